@@ -30,6 +30,7 @@
 #include "qtiocompressor/qtiocompressor.h"
 #include "models/musiclibrarymodel.h"
 #include "contextengine.h"
+#include "contentcache.h"
 #include "widgets/textbrowser.h"
 #include "support/actioncollection.h"
 #include <QScrollBar>
@@ -44,7 +45,7 @@
 const QLatin1String AlbumView::constCacheDir("albums/");
 const QLatin1String AlbumView::constInfoExt(".html.gz");
 
-static QString cacheFileName(const QString &artist, const QString &album, const QString &lang, bool createDir)
+QString AlbumView::cacheFileName(const QString &artist, const QString &album, const QString &lang, bool createDir)
 {
     return Utils::cacheDir(AlbumView::constCacheDir, createDir)+Covers::encodeName(artist)+QLatin1String(" - ")+Covers::encodeName(album)+"."+lang+AlbumView::constInfoExt;
 }
@@ -99,7 +100,7 @@ void AlbumView::refresh()
         return;
     }
     foreach (const QString &lang, engine->getLangs()) {
-        QFile::remove(cacheFileName(Covers::fixArtist(currentSong.albumArtist()), currentSong.album, engine->getPrefix(lang), false));
+        ContentCache::self()->remove(cacheFileName(Covers::fixArtist(currentSong.albumArtist()), currentSong.album, engine->getPrefix(lang), false));
     }
     update(currentSong, true);
 }
@@ -190,7 +191,7 @@ void AlbumView::getDetails()
     foreach (const QString &lang, engine->getLangs()) {
         QString prefix=engine->getPrefix(lang);
         QString cachedFile=cacheFileName(Covers::fixArtist(currentSong.albumArtist()), currentSong.album, prefix, false);
-        if (QFile::exists(cachedFile)) {
+        if (ContentCache::self()->exists(cachedFile)) {
             QFile f(cachedFile);
             QtIOCompressor compressor(&f);
             compressor.setStreamFormat(QtIOCompressor::GzipFormat);
@@ -199,7 +200,7 @@ void AlbumView::getDetails()
 
                 if (!data.isEmpty()) {
                     searchResponse(QString::fromUtf8(data), QString());
-                    Utils::touchFile(cachedFile);
+                    ContentCache::self()->touch(cachedFile);
                     return;
                 }
             }
@@ -251,6 +252,8 @@ void AlbumView::searchResponse(const QString &resp, const QString &lang)
             compressor.setStreamFormat(QtIOCompressor::GzipFormat);
             if (compressor.open(QIODevice::WriteOnly)) {
                 compressor.write(resp.toUtf8().constData());
+                compressor.close();
+                ContentCache::self()->added(f.fileName());
             }
         }
         updateDetails();
@@ -30,6 +30,7 @@
 #include "qtiocompressor/qtiocompressor.h"
 #include "widgets/textbrowser.h"
 #include "contextengine.h"
+#include "contentcache.h"
 #include "support/actioncollection.h"
 #include "models/musiclibrarymodel.h"
 #include <QApplication>
@@ -52,7 +53,7 @@ const QLatin1String ArtistView::constCacheDir("artists/");
 const QLatin1String ArtistView::constInfoExt(".html.gz");
 const QLatin1String ArtistView::constSimilarInfoExt(".txt");
 
-static QString cacheFileName(const QString &artist, const QString &lang, bool similar, bool createDir)
+QString ArtistView::cacheFileName(const QString &artist, const QString &lang, bool similar, bool createDir)
 {
     return Utils::cacheDir(ArtistView::constCacheDir, createDir)+
             Covers::encodeName(artist)+(similar ? "-similar" : ("."+lang))+(similar ? ArtistView::constSimilarInfoExt : ArtistView::constInfoExt);
@@ -138,9 +139,9 @@ void ArtistView::refresh()
         return;
     }
     foreach (const QString &lang, engine->getLangs()) {
-        QFile::remove(cacheFileName(currentSong.artist, engine->getPrefix(lang), false, false));
+        ContentCache::self()->remove(cacheFileName(currentSong.artist, engine->getPrefix(lang), false, false));
     }
-    QFile::remove(cacheFileName(currentSong.artist, QString(), true, false));
+    ContentCache::self()->remove(cacheFileName(currentSong.artist, QString(), true, false));
     update(currentSong, true);
 }
 
@@ -224,7 +225,7 @@ void ArtistView::loadBio()
     foreach (const QString &lang, engine->getLangs()) {
         QString prefix=engine->getPrefix(lang);
         QString cachedFile=cacheFileName(currentSong.artist, prefix, false, false);
-        if (QFile::exists(cachedFile)) {
+        if (ContentCache::self()->exists(cachedFile)) {
             QFile f(cachedFile);
             QtIOCompressor compressor(&f);
             compressor.setStreamFormat(QtIOCompressor::GzipFormat);
@@ -233,7 +234,7 @@ void ArtistView::loadBio()
 
                 if (!data.isEmpty()) {
                     searchResponse(data, QString());
-                    Utils::touchFile(cachedFile);
+                    ContentCache::self()->touch(cachedFile);
                     return;
                 }
             }
@@ -247,7 +248,7 @@ void ArtistView::loadBio()
 void ArtistView::loadSimilar()
 {
     QString cachedFile=cacheFileName(currentSong.artist, QString(), true, false);
-    if (QFile::exists(cachedFile)) {
+    if (ContentCache::self()->exists(cachedFile)) {
         QFile f(cachedFile);
         if (f.open(QIODevice::ReadOnly|QIODevice::Text)) {
             QStringList artists;
@@ -261,7 +262,7 @@ void ArtistView::loadSimilar()
             if (!artists.isEmpty()) {
                 buildSimilar(artists);
                 setBio();
-                Utils::touchFile(cachedFile);
+                ContentCache::self()->touch(cachedFile);
                 return;
             }
         }
@@ -289,6 +290,8 @@ void ArtistView::handleSimilarReply()
                     foreach (const QString &artist, artists) {
                         stream << artist << endl;
                     }
+                    f.close();
+                    ContentCache::self()->added(f.fileName());
                 }
             }
         } else {
@@ -370,9 +373,8 @@ void ArtistView::setBio()
     setHtml(html);
 }
 
-void ArtistView::requestSimilar()
+QUrl ArtistView::similarArtistsUrl(const QString &artist)
 {
-    abort();
     QUrl url("http://ws.audioscrobbler.com/2.0/");
     #if QT_VERSION < 0x050000
     QUrl &query=url;
@@ -383,12 +385,17 @@ void ArtistView::requestSimilar()
     query.addQueryItem("method", "artist.getSimilar");
     query.addQueryItem("api_key", Covers::constLastFmApiKey);
     query.addQueryItem("autocorrect", "1");
-    query.addQueryItem("artist", Covers::fixArtist(currentSong.artist));
+    query.addQueryItem("artist", Covers::fixArtist(artist));
     #if QT_VERSION >= 0x050000
     url.setQuery(query);
     #endif
+    return url;
+}
 
-    currentSimilarJob=NetworkAccessManager::self()->get(url);
+void ArtistView::requestSimilar()
+{
+    abort();
+    currentSimilarJob=NetworkAccessManager::self()->get(similarArtistsUrl(currentSong.artist));
     currentSimilarJob->setProperty(constNameKey, currentSong.artist);
     connect(currentSimilarJob, SIGNAL(finished()), this, SLOT(handleSimilarReply()));
 }
@@ -414,6 +421,8 @@ void ArtistView::searchResponse(const QString &resp, const QString &lang)
         compressor.setStreamFormat(QtIOCompressor::GzipFormat);
         if (compressor.open(QIODevice::WriteOnly)) {
             compressor.write(resp.toUtf8().constData());
+            compressor.close();
+            ContentCache::self()->added(f.fileName());
         }
     }
     loadSimilar();
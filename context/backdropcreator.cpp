@@ -27,6 +27,7 @@
 #include "support/utils.h"
 #include <QApplication>
 #include <QPainter>
+#include <QStringList>
 
 #include <QDebug>
 static bool debugEnabled=false;
@@ -36,9 +37,14 @@ void BackdropCreator::enableDebug()
     debugEnabled=true;
 }
 
+// Created backdrops are cached, so that the same artist gets the same (randomly arranged) backdrop
+// each time, without having to re-compose this.
+static const int constCacheSize=32*1024; // Kb
+
 BackdropCreator::BackdropCreator()
     : QObject(0)
 {
+    backdrops.setMaxCost(constCacheSize);
     connect(Covers::self(), SIGNAL(cover(const Song &, const QImage &, const QString &)), SLOT(coverRetrieved(const Song &, const QImage &, const QString &)));
     imageSize=QApplication::fontMetrics().height()*12;
     thread=new Thread(metaObject()->className());
@@ -54,9 +60,23 @@ BackdropCreator::~BackdropCreator()
 void BackdropCreator::create(const QString &artist, const QList<Song> &songs)
 {
     DBUG << artist << songs.count();
+    QStringList albumNames;
+    foreach (const Song &s, songs) {
+        albumNames.append(s.albumArtist()+QLatin1String(" - ")+s.album);
+    }
+    albumNames.sort();
     requestedArtist=artist;
+    requestedKey=artist+QLatin1Char('\n')+albumNames.join(QLatin1String("\n"));
     images.clear();
     requested.clear();
+
+    QImage *cached=backdrops.object(requestedKey);
+    if (cached) {
+        DBUG << "cached";
+        emit created(requestedArtist, *cached);
+        return;
+    }
+
     foreach (const Song &s, songs) {
         Covers::Image img=Covers::self()->requestImage(s, true);
         if (!img.img.isNull()) {
@@ -131,5 +151,9 @@ void BackdropCreator::createImage()
     }
     }
 
+    int cost=backdrop.byteCount()/1024;
+    if (cost>0 && cost<constCacheSize) {
+        backdrops.insert(requestedKey, new QImage(backdrop), cost);
+    }
     emit created(requestedArtist, backdrop);
 }
@@ -26,10 +26,11 @@
 
 #include <QObject>
 #include <QSet>
+#include <QCache>
+#include <QImage>
 #include "mpd-interface/song.h"
 
 class Thread;
-class QImage;
 
 class BackdropCreator : public QObject
 {
@@ -55,6 +56,8 @@ private:
 private:
     int imageSize;
     QString requestedArtist;
+    QString requestedKey;
+    QCache<QString, QImage> backdrops;
     QSet<Song> requested;
     QList<QImage> images;
     QList<Song> albums;
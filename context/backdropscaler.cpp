@@ -0,0 +1,107 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2014 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#include "backdropscaler.h"
+#include "widgets/treeview.h"
+#include "support/thread.h"
+#include <QPainter>
+
+// Exported by QtGui
+void qt_blurImage(QPainter *p, QImage &blurImage, qreal radius, bool quality, bool alphaOnly, int transposed = 0);
+
+#include <QDebug>
+static bool debugEnabled=false;
+#define DBUG if (debugEnabled) qWarning() << metaObject()->className() << __FUNCTION__
+void BackdropScaler::enableDebug()
+{
+    debugEnabled=true;
+}
+
+static const int constCacheSize=64*1024; // Kb
+
+BackdropScaler::BackdropScaler()
+    : QObject(0)
+{
+    cache.setMaxCost(constCacheSize);
+    thread=new Thread(metaObject()->className());
+    moveToThread(thread);
+    thread->start();
+}
+
+BackdropScaler::~BackdropScaler()
+{
+    thread->stop();
+}
+
+void BackdropScaler::scale(int id, const QString &key, const QImage &img, int opacity, int blur, int width)
+{
+    QString baseKey=key+QLatin1Char(':')+QString::number(opacity)+QLatin1Char(':')+QString::number(blur);
+    QString scaledKey=baseKey+QLatin1Char(':')+QString::number(width);
+    QImage *cached=cache.object(scaledKey);
+    if (cached) {
+        DBUG << id << scaledKey << "cached";
+        emit scaled(id, *cached);
+        return;
+    }
+
+    QImage result=processed(baseKey, img, opacity, blur);
+    if (width>0 && !result.isNull() && width!=result.width()) {
+        QSize sz(width, width*result.height()/result.width());
+        result=result.scaled(sz, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
+        insert(scaledKey, result);
+    }
+    DBUG << id << scaledKey << result.size();
+    emit scaled(id, result);
+}
+
+QImage BackdropScaler::processed(const QString &key, const QImage &orig, int opacity, int blur)
+{
+    QImage *cached=cache.object(key);
+    if (cached) {
+        return *cached;
+    }
+
+    QImage img=orig;
+    if (opacity<100) {
+        img=TreeView::setOpacity(img, (opacity*1.0)/100.0);
+    }
+    if (blur>0) {
+        QImage blurred(img.size(), QImage::Format_ARGB32_Premultiplied);
+        blurred.fill(Qt::transparent);
+        QPainter painter(&blurred);
+        qt_blurImage(&painter, img, blur, true, false);
+        painter.end();
+        img = blurred;
+    }
+    insert(key, img);
+    return img;
+}
+
+void BackdropScaler::insert(const QString &key, const QImage &img)
+{
+    int cost=img.byteCount()/1024;
+    if (cost>0 && cost<constCacheSize) {
+        cache.insert(key, new QImage(img), cost);
+    }
+}
@@ -0,0 +1,62 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2014 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef BACKDROP_SCALER_H
+#define BACKDROP_SCALER_H
+
+#include <QObject>
+#include <QCache>
+#include <QImage>
+
+class Thread;
+
+// Applies opacity and blur to backdrop images, and scales them to the size required by the
+// context view, in a separate thread. Results are cached by (key, opacity, blur, width) - so that
+// switching back to an artist, or resizing to a previous size, does not need to redo this.
+class BackdropScaler : public QObject
+{
+    Q_OBJECT
+public:
+    static void enableDebug();
+
+    BackdropScaler();
+    virtual ~BackdropScaler();
+
+Q_SIGNALS:
+    void scaled(int id, const QImage &img);
+
+public Q_SLOTS:
+    // If width is 0, then image is not scaled - only opacity and blur are applied.
+    void scale(int id, const QString &key, const QImage &img, int opacity, int blur, int width);
+
+private:
+    QImage processed(const QString &key, const QImage &img, int opacity, int blur);
+    void insert(const QString &key, const QImage &img);
+
+private:
+    QCache<QString, QImage> cache;
+    Thread *thread;
+};
+
+#endif
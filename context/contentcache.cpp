@@ -0,0 +1,459 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2014 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "contentcache.h"
+#include "artistview.h"
+#include "albumview.h"
+#include "songview.h"
+#include "contextwidget.h"
+#include "gui/settings.h"
+#include "support/utils.h"
+#include "support/globalstatic.h"
+#include "support/thread.h"
+#include "qtiocompressor/qtiocompressor.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDirIterator>
+#include <QDateTime>
+#include <QTextStream>
+#include <QTimer>
+#include <QMap>
+#include <QDebug>
+
+static bool debugEnabled=false;
+#define DBUG if (debugEnabled) qWarning() << metaObject()->className() << __FUNCTION__
+void ContentCache::enableDebug()
+{
+    debugEnabled=true;
+}
+
+GLOBAL_STATIC(ContentCache, instance)
+
+static const QLatin1String constIndexFile("context-cache.gz");
+static const QLatin1String constTempExt(".tmp");
+static const QLatin1String constIndexHeader("#Cantata context cache 1");
+static const int constSaveDelay=30*1000;
+// When the limit is exceeded, remove files until we are below this percentage of it - so that we
+// do not have to evict something each time a new file is added.
+static const int constEvictToPercent=90;
+
+static inline uint now()
+{
+    return QDateTime::currentDateTime().toTime_t();
+}
+
+static QHash<QString, uint> readIndex(const QString &fileName)
+{
+    QHash<QString, uint> accessed;
+    QFile f(fileName);
+    QtIOCompressor compressor(&f);
+    compressor.setStreamFormat(QtIOCompressor::GzipFormat);
+    if (f.exists() && compressor.open(QIODevice::ReadOnly)) {
+        QTextStream stream(&compressor);
+        stream.setCodec("UTF-8");
+        if (stream.readLine()==constIndexHeader) {
+            while (!stream.atEnd()) {
+                QString line=stream.readLine();
+                int sizeStart=line.indexOf(' ');
+                int keyStart=-1==sizeStart ? -1 : line.indexOf(' ', sizeStart+1);
+                if (-1==keyStart) {
+                    continue;
+                }
+                QString k=line.mid(keyStart+1);
+                if (!k.isEmpty()) {
+                    accessed.insert(k, line.left(sizeStart).toUInt());
+                }
+            }
+        }
+    }
+    return accessed;
+}
+
+ContentCacheWorker::ContentCacheWorker(const QString &r, const QStringList &d)
+    : abortRequested(0)
+    , root(r)
+    , dirs(d)
+{
+    thread=new Thread(metaObject()->className());
+    moveToThread(thread);
+    thread->start();
+}
+
+ContentCacheWorker::~ContentCacheWorker()
+{
+}
+
+// NOTE: Called from GUI thread
+void ContentCacheWorker::stop()
+{
+    abortRequested.fetchAndStoreOrdered(1);
+    if (thread) {
+        thread->stop();
+        thread->wait();
+        thread=0;
+    }
+}
+
+QHash<QString, ContentCache::Entry> ContentCacheWorker::takeEntries()
+{
+    QHash<QString, ContentCache::Entry> e=entries;
+    entries.clear();
+    return e;
+}
+
+void ContentCacheWorker::load()
+{
+    // Sizes are taken from the files themselves, the index only supplies access times. Files not
+    // in the index were written after it was last saved, and entries without a file have been
+    // removed - so neither can cause the cache to exceed its limit.
+    QHash<QString, uint> accessed=readIndex(root+constIndexFile);
+    foreach (const QString &d, dirs) {
+        QDirIterator it(root+d, QDir::Files|QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            #if QT_VERSION >= 0x050000
+            if (0!=abortRequested.loadAcquire()) {
+            #else
+            if (0!=abortRequested) {
+            #endif
+                return;
+            }
+            it.next();
+            QFileInfo info=it.fileInfo();
+            QString k=info.absoluteFilePath().mid(root.length());
+            QHash<QString, uint>::ConstIterator a=accessed.find(k);
+            // Utils::touchFile() was used to mark files as used, so modification time is the best guess...
+            entries.insert(k, ContentCache::Entry(a==accessed.constEnd() ? info.lastModified().toTime_t() : a.value(), info.size()));
+        }
+    }
+    DBUG << "Indexed" << accessed.count() << "scanned" << entries.count();
+    emit loaded();
+}
+
+void ContentCacheWorker::removeFiles(const QStringList &files, uint before)
+{
+    foreach (const QString &f, files) {
+        QFileInfo info(f);
+        if (info.exists() && info.lastModified().toTime_t()<before) {
+            QFile::remove(f);
+        }
+    }
+}
+
+ContentCache::ContentCache()
+    : state(NotLoaded)
+    , modified(false)
+    , totalSize(0)
+    , maxSize(0)
+    , saveTimer(0)
+    , worker(0)
+{
+    dirs << ArtistView::constCacheDir << AlbumView::constCacheDir << SongView::constCacheDir
+         << SongView::constLyricsDir << ContextWidget::constCacheDir;
+    readConfig();
+}
+
+ContentCache::~ContentCache()
+{
+}
+
+void ContentCache::readConfig()
+{
+    maxSize=((quint64)Settings::self()->contextCacheSize())*1024*1024;
+    DBUG << maxSize;
+    if (Loaded==state) {
+        evict();
+    }
+}
+
+bool ContentCache::exists(const QString &fileName)
+{
+    load();
+    QString k=key(fileName);
+    if (k.isEmpty() || Loaded!=state) {
+        return !fileName.isEmpty() && QFile::exists(fileName);
+    }
+    return entries.contains(k);
+}
+
+void ContentCache::touch(const QString &fileName)
+{
+    load();
+    QString k=key(fileName);
+    if (k.isEmpty()) {
+        return;
+    }
+    QHash<QString, Entry>::Iterator it=entries.find(k);
+    if (it!=entries.end()) {
+        it.value().accessed=now();
+        setModified();
+    } else if (Loading==state) {
+        touchedWhileLoading.insert(k, now());
+    }
+}
+
+void ContentCache::added(const QString &fileName)
+{
+    load();
+    QString k=key(fileName);
+    if (k.isEmpty()) {
+        return;
+    }
+    QFileInfo info(fileName);
+    if (!info.exists()) {
+        remove(fileName);
+        return;
+    }
+    QHash<QString, Entry>::Iterator it=entries.find(k);
+    if (it!=entries.end()) {
+        totalSize-=it.value().size;
+        it.value()=Entry(now(), info.size());
+    } else {
+        entries.insert(k, Entry(now(), info.size()));
+    }
+    totalSize+=info.size();
+    DBUG << k << info.size() << totalSize;
+    setModified();
+    if (Loaded==state) {
+        evict();
+    }
+}
+
+void ContentCache::remove(const QString &fileName)
+{
+    if (fileName.isEmpty()) {
+        return;
+    }
+    QFile::remove(fileName);
+    load();
+    QString k=key(fileName);
+    if (k.isEmpty()) {
+        return;
+    }
+    if (Loading==state) {
+        removedWhileLoading.insert(k);
+    }
+    QHash<QString, Entry>::Iterator it=entries.find(k);
+    if (it!=entries.end()) {
+        totalSize-=it.value().size;
+        entries.erase(it);
+        setModified();
+    }
+}
+
+void ContentCache::removeAll(const QString &dir)
+{
+    load();
+    QString k=dir.isEmpty() ? QString() : key(Utils::fixPath(dir));
+    if (k.isEmpty()) {
+        return;
+    }
+    DBUG << k;
+    if (Loading==state) {
+        dirsRemovedWhileLoading.append(k);
+    }
+    QHash<QString, Entry>::Iterator it=entries.begin();
+    while (it!=entries.end()) {
+        if (it.key().startsWith(k)) {
+            totalSize-=it.value().size;
+            it=entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    setModified();
+}
+
+void ContentCache::save()
+{
+    if (saveTimer) {
+        saveTimer->stop();
+    }
+    // Whilst loading, the index is incomplete. Anything added in the meantime will be found by the
+    // next scan, if Cantata exits before loading completes.
+    if (Loaded!=state || !modified || root.isEmpty()) {
+        return;
+    }
+
+    QString fileName=root+constIndexFile;
+    QString tempName=fileName+constTempExt;
+    QFile f(tempName);
+    QtIOCompressor compressor(&f);
+    compressor.setStreamFormat(QtIOCompressor::GzipFormat);
+    if (!compressor.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    QTextStream stream(&compressor);
+    stream.setCodec("UTF-8");
+    stream << constIndexHeader << '\n';
+    QHash<QString, Entry>::ConstIterator it=entries.constBegin();
+    QHash<QString, Entry>::ConstIterator end=entries.constEnd();
+    for (; it!=end; ++it) {
+        stream << it.value().accessed << ' ' << it.value().size << ' ' << it.key() << '\n';
+    }
+    stream.flush();
+    compressor.close();
+    // Write to a temporary file, and then rename - so that we never leave a partial index.
+    QFile::remove(fileName);
+    if (QFile::rename(tempName, fileName)) {
+        modified=false;
+        DBUG << entries.count() << totalSize;
+    }
+}
+
+QString ContentCache::key(const QString &fileName) const
+{
+    if (fileName.isEmpty()) {
+        return QString();
+    }
+    if (root.isEmpty() || !fileName.startsWith(root)) {
+        return QString();
+    }
+    QString k=fileName.mid(root.length());
+    foreach (const QString &d, dirs) {
+        if (k.startsWith(d)) {
+            return k;
+        }
+    }
+    return QString();
+}
+
+void ContentCache::stop()
+{
+    save();
+    if (worker) {
+        disconnect(worker, SIGNAL(loaded()), this, SLOT(workerLoaded()));
+        worker->stop();
+        delete worker;
+        worker=0;
+    }
+}
+
+void ContentCache::load()
+{
+    if (NotLoaded!=state) {
+        return;
+    }
+    root=Utils::cacheDir(QString(), true);
+    if (root.isEmpty()) {
+        state=Loaded;
+        return;
+    }
+
+    state=Loading;
+    worker=new ContentCacheWorker(root, dirs);
+    connect(worker, SIGNAL(loaded()), this, SLOT(workerLoaded()), Qt::QueuedConnection);
+    QMetaObject::invokeMethod(worker, "load", Qt::QueuedConnection);
+}
+
+void ContentCache::workerLoaded()
+{
+    if (Loading!=state || !worker) {
+        return;
+    }
+
+    QHash<QString, Entry> scanned=worker->takeEntries();
+    QHash<QString, Entry>::ConstIterator it=scanned.constBegin();
+    QHash<QString, Entry>::ConstIterator end=scanned.constEnd();
+    for (; it!=end; ++it) {
+        // Entries added whilst loading are more up to date than the scan.
+        if (entries.contains(it.key()) || removedWhileLoading.contains(it.key())) {
+            continue;
+        }
+        bool removed=false;
+        foreach (const QString &d, dirsRemovedWhileLoading) {
+            if (it.key().startsWith(d)) {
+                removed=true;
+                break;
+            }
+        }
+        if (removed) {
+            continue;
+        }
+        Entry e=it.value();
+        QHash<QString, uint>::ConstIterator t=touchedWhileLoading.find(it.key());
+        if (t!=touchedWhileLoading.constEnd()) {
+            e.accessed=qMax(e.accessed, t.value());
+        }
+        entries.insert(it.key(), e);
+    }
+    touchedWhileLoading.clear();
+    removedWhileLoading.clear();
+    dirsRemovedWhileLoading.clear();
+
+    totalSize=0;
+    QHash<QString, Entry>::ConstIterator e=entries.constBegin();
+    QHash<QString, Entry>::ConstIterator eEnd=entries.constEnd();
+    for (; e!=eEnd; ++e) {
+        totalSize+=e.value().size;
+    }
+    state=Loaded;
+    DBUG << "Loaded" << entries.count() << totalSize;
+    setModified();
+    evict();
+}
+
+void ContentCache::evict()
+{
+    if (0==maxSize || totalSize<=maxSize) {
+        return;
+    }
+
+    quint64 target=(maxSize/100)*constEvictToPercent;
+    QMap<uint, QString> byAge;
+    QHash<QString, Entry>::ConstIterator it=entries.constBegin();
+    QHash<QString, Entry>::ConstIterator end=entries.constEnd();
+    for (; it!=end; ++it) {
+        byAge.insertMulti(it.value().accessed, it.key());
+    }
+
+    QMap<uint, QString>::ConstIterator a=byAge.constBegin();
+    QMap<uint, QString>::ConstIterator aEnd=byAge.constEnd();
+    QStringList files;
+    for (; a!=aEnd && totalSize>target; ++a) {
+        files.append(root+a.value());
+        totalSize-=entries.take(a.value()).size;
+    }
+    DBUG << "Removing" << files.count() << "files, size now" << totalSize;
+    // Files are removed in the worker thread, as there may be a large number of these.
+    if (worker) {
+        QMetaObject::invokeMethod(worker, "removeFiles", Qt::QueuedConnection, Q_ARG(QStringList, files), Q_ARG(uint, now()));
+    } else {
+        foreach (const QString &f, files) {
+            QFile::remove(f);
+        }
+    }
+    setModified();
+}
+
+void ContentCache::setModified()
+{
+    modified=true;
+    if (!saveTimer) {
+        saveTimer=new QTimer(this);
+        saveTimer->setSingleShot(true);
+        connect(saveTimer, SIGNAL(timeout()), this, SLOT(save()));
+    }
+    if (!saveTimer->isActive()) {
+        saveTimer->start(constSaveDelay);
+    }
+}
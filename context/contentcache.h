@@ -0,0 +1,142 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2014 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef CONTENT_CACHE_H
+#define CONTENT_CACHE_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QAtomicInt>
+
+class QTimer;
+class Thread;
+class ContentCacheWorker;
+
+// Keeps track of the files written to the context view's cache folders (artist, album, and track
+// information, lyrics, and backdrops). An index of each file's size and last access time is kept
+// in memory, and saved to disk - so that checking whether an item is cached does not need to touch
+// these (potentially very large) folders. When the total size exceeds the configured limit, the
+// least recently used files are removed.
+//
+// The index is read, and reconciled with the files actually on disk, in a background thread. Until
+// that has completed, lookups check the disk directly.
+class ContentCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Entry {
+        Entry(uint a=0, quint64 s=0) : accessed(a), size(s) { }
+        uint accessed;
+        quint64 size;
+    };
+
+    static void enableDebug();
+    static ContentCache * self();
+
+    ContentCache();
+    virtual ~ContentCache();
+
+    void readConfig();
+    // Files outside of the managed folders are checked on disk.
+    bool exists(const QString &fileName);
+    // Mark file as used, so that it is not evicted before files that were used earlier.
+    void touch(const QString &fileName);
+    // Called after a file has been written.
+    void added(const QString &fileName);
+    void remove(const QString &fileName);
+    // Forget all entries within dir - called when the cache settings page deletes a folder.
+    void removeAll(const QString &dir);
+    quint64 size() { load(); return totalSize; }
+    // Save index, and stop background thread - called when Cantata exits.
+    void stop();
+
+public Q_SLOTS:
+    void save();
+
+private Q_SLOTS:
+    void workerLoaded();
+
+private:
+    enum State {
+        NotLoaded,
+        Loading,
+        Loaded
+    };
+
+    QString key(const QString &fileName) const;
+    void load();
+    void evict();
+    void setModified();
+
+private:
+    State state;
+    bool modified;
+    QString root;
+    QStringList dirs;
+    QHash<QString, Entry> entries;
+    quint64 totalSize;
+    quint64 maxSize;
+    QTimer *saveTimer;
+    ContentCacheWorker *worker;
+    // Changes made whilst the worker is loading the index, applied once it has completed.
+    QHash<QString, uint> touchedWhileLoading;
+    QSet<QString> removedWhileLoading;
+    QStringList dirsRemovedWhileLoading;
+};
+
+// Reads the saved index, and scans the cache folders, in a background thread - so that files that
+// were written but not saved to the index (e.g. if Cantata crashed) are still tracked. Also removes
+// evicted files.
+class ContentCacheWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    ContentCacheWorker(const QString &r, const QStringList &d);
+    virtual ~ContentCacheWorker();
+
+    // Stops the thread, and waits for it to finish - the caller may then delete this object.
+    void stop();
+    // Only valid once loaded() has been emitted.
+    QHash<QString, ContentCache::Entry> takeEntries();
+
+Q_SIGNALS:
+    void loaded();
+
+public Q_SLOTS:
+    void load();
+    // Files modified at, or after, 'before' have been re-written since being evicted, so are kept.
+    void removeFiles(const QStringList &files, uint before);
+
+private:
+    Thread *thread;
+    QAtomicInt abortRequested;
+    QString root;
+    QStringList dirs;
+    QHash<QString, ContentCache::Entry> entries;
+};
+
+#endif
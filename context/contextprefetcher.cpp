@@ -0,0 +1,293 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2014 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#include "contextprefetcher.h"
+#include "contextengine.h"
+#include "artistview.h"
+#include "albumview.h"
+#include "songview.h"
+#include "ultimatelyrics.h"
+#include "contentcache.h"
+#include "gui/covers.h"
+#include "gui/settings.h"
+#include "mpd-interface/mpdconnection.h"
+#include "network/networkaccessmanager.h"
+#include "qtiocompressor/qtiocompressor.h"
+#include "support/utils.h"
+#include <QFile>
+#include <QTextStream>
+#include <QTextDocument>
+#include <QDebug>
+
+static bool debugEnabled=false;
+#define DBUG if (debugEnabled) qWarning() << metaObject()->className() << __FUNCTION__
+void ContextPrefetcher::enableDebug()
+{
+    debugEnabled=true;
+}
+
+// Lyrics lookups use negative IDs, so that they do not clash with those of SongView.
+static int lastLyricsId=0;
+
+static bool haveCachedInfo(ContextEngine *engine, const QString &artist, const QString &album, const Song &song)
+{
+    foreach (const QString &lang, engine->getLangs()) {
+        QString prefix=engine->getPrefix(lang);
+        QString fileName=!song.isEmpty()
+                            ? SongView::infoCacheFileName(song, prefix, false)
+                            : album.isEmpty()
+                                ? ArtistView::cacheFileName(artist, prefix, false, false)
+                                : AlbumView::cacheFileName(artist, album, prefix, false);
+        if (!fileName.isEmpty() && ContentCache::self()->exists(fileName)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void saveInfo(const QString &fileName, const QString &resp)
+{
+    if (fileName.isEmpty()) {
+        return;
+    }
+    QFile f(fileName);
+    QtIOCompressor compressor(&f);
+    compressor.setStreamFormat(QtIOCompressor::GzipFormat);
+    if (compressor.open(QIODevice::WriteOnly)) {
+        compressor.write(resp.toUtf8().constData());
+        compressor.close();
+        ContentCache::self()->added(fileName);
+    }
+}
+
+ContextPrefetcher::ContextPrefetcher(QObject *p)
+    : QObject(p)
+    , current(-1)
+    , lyricsId(0)
+    , similarJob(0)
+{
+    engine=ContextEngine::create(this);
+    connect(engine, SIGNAL(searchResult(QString,QString)), this, SLOT(searchResponse(QString,QString)));
+    connect(UltimateLyrics::self(), SIGNAL(lyricsReady(int, int, QString)), SLOT(lyricsReady(int, int, QString)));
+    readConfig();
+}
+
+ContextPrefetcher::~ContextPrefetcher()
+{
+    cancel();
+}
+
+void ContextPrefetcher::readConfig()
+{
+    budget=Settings::self()->contextPrefetchBudget();
+    if (budget<=0) {
+        cancel();
+    }
+}
+
+void ContextPrefetcher::prefetch(const Song &s)
+{
+    if (budget<=0 || s.artist.isEmpty() || s.title.isEmpty() ||
+        (s.artist==song.artist && s.title==song.title && s.album==song.album)) {
+        return;
+    }
+
+    cancel();
+    song=s;
+    QList<Item> items=QList<Item>() << Lyrics << ArtistInfo << SimilarArtists << AlbumInfo << TrackInfo << ArtistImage << Backdrop;
+    foreach (Item item, items) {
+        if (!isCached(item)) {
+            pending.append(item);
+            if (pending.count()>=budget) {
+                break;
+            }
+        }
+    }
+    DBUG << song.artist << song.title << pending;
+    startNext();
+}
+
+void ContextPrefetcher::cancel()
+{
+    engine->cancel();
+    if (similarJob) {
+        similarJob->cancelAndDelete();
+        similarJob=0;
+    }
+    if (Lyrics==current) {
+        UltimateLyrics::self()->abort(lyricsId);
+    }
+    current=-1;
+    pending.clear();
+    song=Song();
+}
+
+void ContextPrefetcher::searchResponse(const QString &resp, const QString &lang)
+{
+    if (ArtistInfo!=current && AlbumInfo!=current && TrackInfo!=current) {
+        return;
+    }
+
+    DBUG << current << resp.length() << lang;
+    if (!resp.isEmpty() && !lang.isEmpty()) {
+        saveInfo(ArtistInfo==current
+                    ? ArtistView::cacheFileName(song.basicArtist(), lang, false, true)
+                    : AlbumInfo==current
+                        ? AlbumView::cacheFileName(Covers::fixArtist(song.albumArtist()), song.album, lang, true)
+                        : SongView::infoCacheFileName(song, lang, true), resp);
+    }
+    startNext();
+}
+
+void ContextPrefetcher::similarResponse()
+{
+    NetworkJob *reply=qobject_cast<NetworkJob *>(sender());
+    if (!reply) {
+        return;
+    }
+    reply->deleteLater();
+    if (reply!=similarJob) {
+        return;
+    }
+    similarJob=0;
+
+    if (reply->ok()) {
+        QStringList artists=ArtistView::parseSimilarResponse(reply->readAll());
+        DBUG << artists.count();
+        if (!artists.isEmpty()) {
+            QFile f(ArtistView::cacheFileName(song.basicArtist(), QString(), true, true));
+            if (f.open(QIODevice::WriteOnly|QIODevice::Text)) {
+                QTextStream stream(&f);
+                foreach (const QString &artist, artists) {
+                    stream << artist << endl;
+                }
+                f.close();
+                ContentCache::self()->added(f.fileName());
+            }
+        }
+    }
+    startNext();
+}
+
+void ContextPrefetcher::lyricsReady(int id, int index, const QString &lyrics)
+{
+    Q_UNUSED(index)
+    if (Lyrics!=current || id!=lyricsId) {
+        return;
+    }
+
+    DBUG << index << lyrics.length();
+    if (!lyrics.isEmpty()) {
+        // Store the same plain text as SongView would...
+        QTextDocument doc;
+        doc.setHtml(QString(lyrics).replace(QLatin1String("\n\n\n"), QLatin1String("\n\n")).replace("\n", "<br/>"));
+        QString plain=doc.toPlainText().trimmed();
+        if (!plain.isEmpty()) {
+            QFile f(SongView::lyricsCacheFileName(song, true));
+            if (f.open(QIODevice::WriteOnly)) {
+                QTextStream(&f) << plain;
+                f.close();
+                ContentCache::self()->added(f.fileName());
+            }
+        }
+    }
+    startNext();
+}
+
+bool ContextPrefetcher::isCached(Item item) const
+{
+    switch (item) {
+    case Lyrics: {
+        if (ContentCache::self()->exists(SongView::lyricsCacheFileName(song))) {
+            return true;
+        }
+        const MPDConnectionDetails &details=MPDConnection::self()->getDetails();
+        return !song.isNonMPD() && details.dirReadable && !details.dir.isEmpty() &&
+               QFile::exists(Utils::changeExtension(details.dir+song.filePath(), SongView::constExtension));
+    }
+    case ArtistInfo:
+        return haveCachedInfo(engine, song.basicArtist(), QString(), Song());
+    case SimilarArtists:
+        return ContentCache::self()->exists(ArtistView::cacheFileName(song.basicArtist(), QString(), true, false));
+    case AlbumInfo:
+        return song.album.isEmpty() || haveCachedInfo(engine, Covers::fixArtist(song.albumArtist()), song.album, Song());
+    case TrackInfo:
+        return haveCachedInfo(engine, QString(), QString(), song);
+    default:
+        // Covers and ContextWidget check their own caches
+        return false;
+    }
+}
+
+void ContextPrefetcher::startNext()
+{
+    current=-1;
+    while (!pending.isEmpty()) {
+        Item item=pending.takeFirst();
+        DBUG << item;
+        switch (item) {
+        case Lyrics:
+            lyricsId=--lastLyricsId;
+            if (UltimateLyrics::self()->fetch(lyricsId, song)) {
+                current=item;
+                return;
+            }
+            break;
+        case ArtistInfo:
+            current=item;
+            engine->search(QStringList() << song.basicArtist(), ContextEngine::Artist);
+            return;
+        case SimilarArtists: {
+            current=item;
+            QNetworkRequest req(ArtistView::similarArtistsUrl(song.basicArtist()));
+            req.setPriority(QNetworkRequest::LowPriority);
+            similarJob=NetworkAccessManager::self()->get(req);
+            connect(similarJob, SIGNAL(finished()), this, SLOT(similarResponse()));
+            return;
+        }
+        case AlbumInfo:
+            current=item;
+            engine->search(QStringList() << song.albumArtist() << song.album, ContextEngine::Album);
+            return;
+        case TrackInfo:
+            current=item;
+            engine->search(QStringList() << song.artist << song.title, ContextEngine::Track);
+            return;
+        case ArtistImage: {
+            Song s;
+            s.setArtistImageRequest();
+            s.albumartist=song.basicArtist();
+            if (!song.isVariousArtists()) {
+                s.file=song.file;
+            }
+            Covers::self()->requestImage(s);
+            break;
+        }
+        case Backdrop:
+            emit fetchBackdrop(song);
+            break;
+        }
+    }
+    DBUG << "done";
+}
@@ -0,0 +1,86 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2014 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef CONTEXT_PREFETCHER_H
+#define CONTEXT_PREFETCHER_H
+
+#include <QObject>
+#include <QList>
+#include "mpd-interface/song.h"
+
+class ContextEngine;
+class NetworkJob;
+
+// Downloads the context information (lyrics, artist, album, and track details, etc.) for the
+// next song in the play queue into the same cache files that the views use - so that these can
+// be shown as soon as the song starts. Only items that are not already cached are fetched, one at
+// a time, and at most 'budget' items are fetched for each song.
+class ContextPrefetcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    static void enableDebug();
+
+    ContextPrefetcher(QObject *p);
+    virtual ~ContextPrefetcher();
+
+    void readConfig();
+    void prefetch(const Song &s);
+    void cancel();
+
+Q_SIGNALS:
+    // Emitted when the backdrop for 'song' should be fetched - ContextWidget handles this.
+    void fetchBackdrop(const Song &song);
+
+private Q_SLOTS:
+    void searchResponse(const QString &resp, const QString &lang);
+    void similarResponse();
+    void lyricsReady(int id, int index, const QString &lyrics);
+
+private:
+    enum Item {
+        Lyrics,
+        ArtistInfo,
+        SimilarArtists,
+        AlbumInfo,
+        TrackInfo,
+        ArtistImage,
+        Backdrop
+    };
+
+    bool isCached(Item item) const;
+    void startNext();
+
+private:
+    int budget;
+    Song song;
+    QList<Item> pending;
+    int current;
+    int lyricsId;
+    ContextEngine *engine;
+    NetworkJob *similarJob;
+};
+
+#endif
@@ -36,6 +36,9 @@
 #include "wikipediaengine.h"
 #include "support/localize.h"
 #include "backdropcreator.h"
+#include "backdropscaler.h"
+#include "contextprefetcher.h"
+#include "contentcache.h"
 #include "support/gtkstyle.h"
 #include "widgets/playqueueview.h"
 #include "widgets/treeview.h"
@@ -52,11 +55,10 @@
 #endif
 #include <QXmlStreamReader>
 #include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
 #include <QWheelEvent>
 #include <QApplication>
-#ifndef SCALE_CONTEXT_BGND
-#include <QDesktopWidget>
-#endif
 #include <QStackedWidget>
 #include <QAction>
 #include <QPair>
@@ -66,9 +68,6 @@
 #include <QWheelEvent>
 #include <qglobal.h>
 
-// Exported by QtGui
-void qt_blurImage(QPainter *p, QImage &blurImage, qreal radius, bool quality, bool alphaOnly, int transposed = 0);
-
 #include <QDebug>
 static bool debugEnabled=false;
 #define DBUG if (debugEnabled) qWarning() << metaObject()->className() << __FUNCTION__
@@ -87,6 +86,23 @@ static QString cacheFileName(const QString &artist, bool createDir)
     return Utils::cacheDir(ContextWidget::constCacheDir, createDir)+Covers::encodeName(artist)+".jpg";
 }
 
+// Key used to cache the scaled version of a backdrop file. This includes the file's modification time, so that
+// if the file is replaced (e.g. a new download, or an edited custom backdrop) it is scaled again.
+static QString backdropKey(const QString &fileName)
+{
+    return fileName+QLatin1Char(':')+QString::number(QFileInfo(fileName).lastModified().toTime_t());
+}
+
+static QString fixArtist(const QString &artist)
+{
+    QString fixed(artist.trimmed());
+    fixed.remove(QChar('?'));
+    return fixed;
+}
+
+static const char * constArtistProp="artist-name";
+static const char * constPrefetchProp="prefetch";
+
 class ViewSelectorButton : public QToolButton
 {
 public:
@@ -240,12 +256,14 @@ void ThinSplitter::reset()
 ContextWidget::ContextWidget(QWidget *parent)
     : QWidget(parent)
     , job(0)
+    , prefetchJob(0)
     , alwaysCollapsed(false)
     , backdropType(PlayQueueView::BI_Cover)
     , darkBackground(false)
     , useFanArt(0!=constFanArtApiKey.latin1())
     , albumCoverBackdrop(false)
     , oldIsAlbumCoverBackdrop(false)
+    , currentImageCreated(false)
     , fadeValue(1.0)
     , isWide(false)
     , stack(0)
@@ -255,6 +273,13 @@ ContextWidget::ContextWidget(QWidget *parent)
     , splitter(0)
     , viewSelector(0)
     , creator(0)
+    , scaler(0)
+    , imageCount(0)
+    , scaleRequest(0)
+    , scaledWidth(0)
+    , scaleInFlight(false)
+    , scaleAgain(false)
+    , fadeInPending(false)
 {
     QHBoxLayout *layout=new QHBoxLayout(this);
     mainStack=new QStackedWidget(this);
@@ -278,25 +303,14 @@ ContextWidget::ContextWidget(QWidget *parent)
     connect(artist, SIGNAL(findArtist(QString)), this, SIGNAL(findArtist(QString)));
     connect(artist, SIGNAL(findAlbum(QString,QString)), this, SIGNAL(findAlbum(QString,QString)));
     connect(album, SIGNAL(playSong(QString)), this, SIGNAL(playSong(QString)));
+    prefetcher=new ContextPrefetcher(this);
+    connect(prefetcher, SIGNAL(fetchBackdrop(Song)), this, SLOT(prefetchBackdrop(Song)));
     readConfig();
     setZoom();
     setWide(true);
-
-    #ifndef SCALE_CONTEXT_BGND
-    QDesktopWidget *dw=QApplication::desktop();
-    if (dw) {
-        QSize geo=dw->availableGeometry(this).size()-QSize(32, 64);
-        minBackdropSize=geo;
-        minBackdropSize.setWidth(((int)(minBackdropSize.width()/32))*32);
-        minBackdropSize.setHeight(((int)(minBackdropSize.height()/32))*32);
-        maxBackdropSize=QSize(geo.width()*1.25, geo.height()*1.25);
-    } else {
-        minBackdropSize=QSize(Utils::scaleForDpi(1024*3), Utils::scaleForDpi(768*3);
-        maxBackdropSize=QSize(minBackdropSize.width()*2, minBackdropSize.height()*2);
-    }
-    #endif
 }
 
+
 void ContextWidget::setZoom()
 {
     int zoom=Settings::self()->contextZoom();
@@ -404,9 +418,7 @@ void ContextWidget::resizeEvent(QResizeEvent *e)
     if (isVisible()) {
         setWide(width()>minWidth && !alwaysCollapsed);
     }
-    #ifdef SCALE_CONTEXT_BGND
     resizeBackdrop();
-    #endif
     QWidget::resizeEvent(e);
 }
 
@@ -437,7 +449,7 @@ void ContextWidget::readConfig()
         break;
    case PlayQueueView::BI_Custom:
         if (origType!=backdropType || backdropOpacity!=origOpacity || backdropBlur!=origBlur || origCustomBackdropFile!=customBackdropFile) {            
-            updateImage(QImage(customBackdropFile), false);
+            updateImage(QImage(customBackdropFile), false, backdropKey(customBackdropFile));
             artistsCreatedBackdropsFor.clear();
         }
         break;
@@ -445,6 +457,7 @@ void ContextWidget::readConfig()
 
     useDarkBackground(Settings::self()->contextDarkBackground());
     WikipediaEngine::setIntroOnly(Settings::self()->wikipediaIntroOnly());
+    prefetcher->readConfig();
     bool wasCollpased=stack && stack->isVisible();
     alwaysCollapsed=Settings::self()->contextAlwaysCollapsed();
     if (alwaysCollapsed && !wasCollpased) {
@@ -462,6 +475,7 @@ void ContextWidget::saveConfig()
         Settings::self()->saveContextSplitterState(splitter->saveState());
     }
     song->saveConfig();
+    ContentCache::self()->save();
 }
 
 void ContextWidget::useDarkBackground(bool u)
@@ -511,6 +525,15 @@ void ContextWidget::showEvent(QShowEvent *e)
     QWidget::showEvent(e);
 }
 
+static inline int logicalHeight(const QPixmap &pix)
+{
+    #if QT_VERSION >= 0x050100
+    return pix.height()/pix.devicePixelRatio();
+    #else
+    return pix.height();
+    #endif
+}
+
 void ContextWidget::paintEvent(QPaintEvent *e)
 {
     QPainter p(this);
@@ -520,25 +543,27 @@ void ContextWidget::paintEvent(QPaintEvent *e)
         p.fillRect(r, palette().background().color());
     }
     if (backdropType) {
+        // Backdrops are pre-scaled (in BackdropScaler) to the widget's width, so all that is
+        // required here is to draw them. Created backdrops are tiled.
         if (!oldBackdrop.isNull()) {
             if (!qFuzzyCompare(fadeValue, qreal(0.0))) {
                 p.setOpacity(1.0-fadeValue);
             }
-            #ifdef SCALE_CONTEXT_BGND
-            if (!oldIsAlbumCoverBackdrop && oldBackdrop.height()<height()) {
-                p.drawPixmap(0, (height()-oldBackdrop.height())/2, oldBackdrop);
-            } else
-            #endif
-            p.fillRect(r, QBrush(oldBackdrop));
+            if (oldIsAlbumCoverBackdrop) {
+                p.fillRect(r, QBrush(oldBackdrop));
+            } else {
+                int h=logicalHeight(oldBackdrop);
+                p.drawPixmap(0, h<height() ? (height()-h)/2 : 0, oldBackdrop);
+            }
         }
         if (!currentBackdrop.isNull()) {
             p.setOpacity(fadeValue);
-            #ifdef SCALE_CONTEXT_BGND
-            if (!albumCoverBackdrop && currentBackdrop.height()<height()) {
-                p.drawPixmap(0, (height()-currentBackdrop.height())/2, currentBackdrop);
-            } else
-            #endif
-            p.fillRect(r, QBrush(currentBackdrop));
+            if (albumCoverBackdrop) {
+                p.fillRect(r, QBrush(currentBackdrop));
+            } else {
+                int h=logicalHeight(currentBackdrop);
+                p.drawPixmap(0, h<height() ? (height()-h)/2 : 0, currentBackdrop);
+            }
         }
     }
     if (!darkBackground) {
@@ -558,41 +583,37 @@ void ContextWidget::setFade(float value)
     }
 }
 
-void ContextWidget::updateImage(QImage img, bool created)
+void ContextWidget::updateImage(QImage img, bool created, const QString &key)
 {
-    DBUG << img.isNull() << currentBackdrop.isNull();
-    oldBackdrop=currentBackdrop;
-    oldIsAlbumCoverBackdrop=albumCoverBackdrop;
-    currentBackdrop=QPixmap();
+    DBUG << img.isNull() << currentBackdrop.isNull() << key;
     animator.stop();
     if (img.isNull()) {
         backdropAlbums.clear();
     }
-    if (img.isNull() && oldBackdrop.isNull()) {
-        return;
-    }
-    if (!img.isNull()) {
-        if (backdropOpacity<100) {
-            img=TreeView::setOpacity(img, (backdropOpacity*1.0)/100.0);
-        }
-        if (backdropBlur>0) {
-            QImage blurred(img.size(), QImage::Format_ARGB32_Premultiplied);
-            blurred.fill(Qt::transparent);
-            QPainter painter(&blurred);
-            qt_blurImage(&painter, img, backdropBlur, true, false);
-            painter.end();
-            img = blurred;
+    currentImage=img;
+    currentImageCreated=created;
+    // Images without a key (i.e. just downloaded, or created) get a unique one - so that they can
+    // still be cached for resizes, without being confused with any other image.
+    currentImageKey=key.isEmpty() ? QString(QLatin1Char('#'))+QString::number(++imageCount) : key;
+
+    if (img.isNull()) {
+        fadeInPending=false;
+        if (!currentBackdrop.isNull()) {
+            showBackdrop(QPixmap(), false);
         }
-        #ifdef SCALE_CONTEXT_BGND
-        currentImage=img;
-        #else
-        currentBackdrop=QPixmap::fromImage(img);
-        #endif
+    } else {
+        fadeInPending=true;
+        requestBackdrop();
     }
-    albumCoverBackdrop=created;
-    resizeBackdrop();
+}
 
+void ContextWidget::showBackdrop(const QPixmap &pix, bool created)
+{
     animator.stop();
+    oldBackdrop=currentBackdrop;
+    oldIsAlbumCoverBackdrop=albumCoverBackdrop;
+    currentBackdrop=pix;
+    albumCoverBackdrop=created;
     if (PlayQueueView::BI_Custom==backdropType || !isVisible()) {
         setFade(1.0);
     } else {
@@ -610,7 +631,7 @@ void ContextWidget::search()
     }
 }
 
-void ContextWidget::update(const Song &s)
+static Song contextSong(const Song &s)
 {
     Song sng=s;
     if (sng.isVariousArtists()) {
@@ -624,6 +645,12 @@ void ContextWidget::update(const Song &s)
             sng.title=sng.title.mid(pos+3);
         }
     }
+    return sng;
+}
+
+void ContextWidget::update(const Song &s)
+{
+    Song sng=contextSong(s);
 
     if (s.albumArtist()!=currentSong.albumArtist()) {
         cancel();
@@ -662,6 +689,19 @@ void ContextWidget::update(const Song &s)
     }
 }
 
+void ContextWidget::prefetch(const Song &s)
+{
+    // Only worth prefetching if the user is looking at the context view...
+    if (!isVisible() || s.isEmpty() || s.isStream()
+        #ifdef ENABLE_ONLINE_SERVICES
+        || Song::OnlineSvrTrack==s.type
+        #endif
+        ) {
+        return;
+    }
+    prefetcher->prefetch(contextSong(s));
+}
+
 bool ContextWidget::eventFilter(QObject *o, QEvent *e)
 {
     if (QEvent::Wheel==e->type()) {
@@ -686,6 +726,58 @@ void ContextWidget::cancel()
     }
 }
 
+void ContextWidget::cancelPrefetch()
+{
+    if (prefetchJob) {
+        prefetchJob->cancelAndDelete();
+        prefetchJob=0;
+    }
+}
+
+void ContextWidget::prefetchBackdrop(const Song &s)
+{
+    if (PlayQueueView::BI_Cover!=backdropType) {
+        return;
+    }
+
+    QString artist=Covers::fixArtist(s.basicArtist());
+    if (artist.isEmpty() || artist==currentArtist || (prefetchJob && artist==prefetchArtist) ||
+        artistsCreatedBackdropsFor.contains(artist) || ContentCache::self()->exists(cacheFileName(artist, false))) {
+        return;
+    }
+
+    // Backdrops stored alongside the music are cheap to load - so no need to download these.
+    if (!s.isStream() && !s.isNonMPD() && MPDConnection::self()->getDetails().dirReadable) {
+        QString dirName=MPDConnection::self()->getDetails().dir;
+        if (!dirName.isEmpty() && !dirName.startsWith(QLatin1String("http:/"))) {
+            QString encoded=Covers::encodeName(artist);
+            QStringList names=QStringList() << encoded+"-"+constBackdropFileName+".jpg" << encoded+"-"+constBackdropFileName+".png"
+                                            << constBackdropFileName+".jpg" << constBackdropFileName+".png";
+            dirName+=Utils::getDir(s.file);
+            for (int level=0; level<2; ++level) {
+                foreach (const QString &fileName, names) {
+                    if (QFile::exists(dirName+fileName)) {
+                        return;
+                    }
+                }
+                QDir d(dirName);
+                d.cdUp();
+                dirName=Utils::fixPath(d.absolutePath());
+            }
+        }
+    }
+
+    DBUG << artist;
+    cancelPrefetch();
+    prefetchArtist=artist;
+    prefetchSong=s;
+    if (useFanArt) {
+        getMusicbrainzId(fixArtist(prefetchArtist), true);
+    } else {
+        getDiscoGsImage(true);
+    }
+}
+
 void ContextWidget::updateBackdrop(bool force)
 {
     DBUG << updateArtist << currentArtist << currentSong.file << force;
@@ -718,7 +810,7 @@ void ContextWidget::updateBackdrop(bool force)
 
                         if (!img.isNull()) {
                             DBUG << "Got backdrop from" << QString(dirName+fileName);
-                            updateImage(img);
+                            updateImage(img, false, backdropKey(dirName+fileName));
                             QWidget::update();
                             return;
                         }
@@ -744,7 +836,7 @@ void ContextWidget::updateBackdrop(bool force)
 
                     if (!img.isNull()) {
                         DBUG << "Got backdrop from" << QString(dirName+fileName);
-                        updateImage(img);
+                        updateImage(img, false, backdropKey(dirName+fileName));
                         QWidget::update();
                         return;
                     }
@@ -754,26 +846,31 @@ void ContextWidget::updateBackdrop(bool force)
     }
 
     QString cacheName=cacheFileName(currentArtist, false);
-    QImage img(cacheName);
+    QImage img;
+    if (ContentCache::self()->exists(cacheName)) {
+        img.load(cacheName);
+    }
     if (img.isNull()) {
         getBackdrop();
     } else {
         DBUG << "Use cache file:" << cacheName;
-        updateImage(img);
+        ContentCache::self()->touch(cacheName);
+        updateImage(img, false, backdropKey(cacheName));
         QWidget::update();
     }
 }
 
-static QString fixArtist(const QString &artist)
-{
-    QString fixed(artist.trimmed());
-    fixed.remove(QChar('?'));
-    return fixed;
-}
-
 void ContextWidget::getBackdrop()
 {
     cancel();
+    if (prefetchJob && prefetchArtist==currentArtist) {
+        // Already downloading this backdrop, so just use that result when it arrives.
+        DBUG << "Use prefetch job" << currentArtist;
+        job=prefetchJob;
+        prefetchJob=0;
+        job->setProperty(constPrefetchProp, false);
+        return;
+    }
     if (artistsCreatedBackdropsFor.contains(currentArtist)) {
         createBackdrop();
     } else if (useFanArt) {
@@ -789,8 +886,7 @@ void ContextWidget::getFanArtBackdrop()
     getMusicbrainzId(fixArtist(currentArtist));
 }
 
-static const char * constArtistProp="artist-name";
-void ContextWidget::getMusicbrainzId(const QString &artist)
+void ContextWidget::getMusicbrainzId(const QString &artist, bool prefetch)
 {
     QUrl url("http://www.musicbrainz.org/ws/2/artist/");
     #if QT_VERSION < 0x050000
@@ -804,15 +900,17 @@ void ContextWidget::getMusicbrainzId(const QString &artist)
     url.setQuery(query);
     #endif
 
-    job = NetworkAccessManager::self()->get(url);
-    DBUG << url.toString();
-    job->setProperty(constArtistProp, artist);
-    connect(job, SIGNAL(finished()), this, SLOT(musicbrainzResponse()));
+    NetworkJob *j=startJob(url, prefetch, SLOT(musicbrainzResponse()));
+    j->setProperty(constArtistProp, artist);
 }
 
-void ContextWidget::getDiscoGsImage()
+void ContextWidget::getDiscoGsImage(bool prefetch)
 {
-    cancel();
+    if (prefetch) {
+        cancelPrefetch();
+    } else {
+        cancel();
+    }
     QUrl url;
     #if QT_VERSION < 0x050000
     QUrl &query=url;
@@ -824,14 +922,12 @@ void ContextWidget::getDiscoGsImage()
     url.setPath("/search");
     query.addQueryItem("per_page", QString::number(5));
     query.addQueryItem("type", "artist");
-    query.addQueryItem("q", fixArtist(currentArtist));
+    query.addQueryItem("q", fixArtist(prefetch ? prefetchArtist : currentArtist));
     query.addQueryItem("f", "json");
     #if QT_VERSION >= 0x050000
     url.setQuery(query);
     #endif
-    job=NetworkAccessManager::self()->get(url, 5000);
-    DBUG << url.toString();
-    connect(job, SIGNAL(finished()), this, SLOT(discoGsResponse()));
+    startJob(url, prefetch, SLOT(discoGsResponse()), 5000);
 }
 
 void ContextWidget::musicbrainzResponse()
@@ -865,21 +961,20 @@ void ContextWidget::musicbrainzResponse()
         }
     }
 
+    bool prefetch=reply->property(constPrefetchProp).toBool();
     if (id.isEmpty()) {
         QString artist=reply->property(constArtistProp).toString();
         // MusicBrainz does not seem to like AC/DC, but AC DC works - so if we fail with an artist
         // containing /, then try with space...
         if (!artist.isEmpty() && artist.contains("/")) {
             artist=artist.replace("/", " ");
-            getMusicbrainzId(artist);
+            getMusicbrainzId(artist, prefetch);
         } else {
-            getDiscoGsImage();
+            getDiscoGsImage(prefetch);
         }
     } else {
-        QUrl url("http://api.fanart.tv/webservice/artist/"+constFanArtApiKey+"/"+id+"/json/artistbackground/1");
-        job=NetworkAccessManager::self()->get(url);
-        DBUG << url.toString();
-        connect(job, SIGNAL(finished()), this, SLOT(fanArtResponse()));
+        startJob(QUrl("http://api.fanart.tv/webservice/artist/"+constFanArtApiKey+"/"+id+"/json/artistbackground/1"),
+                 prefetch, SLOT(fanArtResponse()));
     }
 }
 
@@ -917,12 +1012,11 @@ void ContextWidget::fanArtResponse()
         }
     }
 
+    bool prefetch=reply->property(constPrefetchProp).toBool();
     if (url.isEmpty()) {
-        getDiscoGsImage();
+        getDiscoGsImage(prefetch);
     } else {
-        job=NetworkAccessManager::self()->get(QUrl(url));
-        DBUG << url;
-        connect(job, SIGNAL(finished()), this, SLOT(downloadResponse()));
+        startJob(QUrl(url), prefetch, SLOT(downloadResponse()));
     }
 }
 
@@ -974,6 +1068,8 @@ void ContextWidget::discoGsResponse()
 
     DBUG << "status" << reply->error() << reply->errorString();
     QString url;
+    bool prefetch=reply->property(constPrefetchProp).toBool();
+    const QString &artistName=prefetch ? prefetchArtist : currentArtist;
 
     if (reply->ok()) {
         #if QT_VERSION >= 0x050000
@@ -996,7 +1092,7 @@ void ContextWidget::discoGsResponse()
                         if (rm.contains("thumb") && rm.contains("title")) {
                             QString thumbUrl=rm["thumb"].toString();
                             QString title=rm["title"].toString();
-                            if (thumbUrl.contains("/image/A-150-") && matchesArtist(title, currentArtist)) {
+                            if (thumbUrl.contains("/image/A-150-") && matchesArtist(title, artistName)) {
                                 url=thumbUrl.replace("image/A-150-", "/image/A-");
                                 break;
                             }
@@ -1008,11 +1104,12 @@ void ContextWidget::discoGsResponse()
     }
 
     if (url.isEmpty()) {
-        createBackdrop();
+        // Created backdrops are not cached, so there is nothing to do when prefetching.
+        if (!prefetch) {
+            createBackdrop();
+        }
     } else {
-        job=NetworkAccessManager::self()->get(QUrl(url));
-        DBUG << url;
-        connect(job, SIGNAL(finished()), this, SLOT(downloadResponse()));
+        startJob(QUrl(url), prefetch, SLOT(downloadResponse()));
     }
 }
 
@@ -1033,47 +1130,60 @@ void ContextWidget::downloadResponse()
         img=QImage::fromData(data);
     }
 
+    bool prefetch=reply->property(constPrefetchProp).toBool();
     if (img.isNull()) {
-        createBackdrop();
+        if (!prefetch) {
+            createBackdrop();
+        }
     } else {
-        updateImage(img);
-        bool saved=false;
-
-        if (Settings::self()->storeBackdropsInMpdDir() && !currentSong.isVariousArtists() &&
-            !currentSong.isNonMPD() && MPDConnection::self()->getDetails().dirReadable) {
-            QString mpdDir=MPDConnection::self()->getDetails().dir;
-            QString songDir=Utils::getDir(currentSong.file);
-            if (!mpdDir.isEmpty() && 2==songDir.split(Utils::constDirSep, QString::SkipEmptyParts).count()) {
-                QDir d(mpdDir+songDir);
-                d.cdUp();
-                QString fileName=Utils::fixPath(d.absolutePath())+constBackdropFileName+".jpg";
-                QFile f(fileName);
-                if (f.open(QIODevice::WriteOnly)) {
-                    f.write(data);
-                    f.close();
-                    DBUG << "Saved backdrop to" << fileName << "for artist" << currentArtist << ", current song" << currentSong.file;
-                    saved=true;
-                }
-            } else {
-                DBUG << "Not saving to mpd folder, mpd dir:" << mpdDir
-                     << "num parts:" << songDir.split(Utils::constDirSep, QString::SkipEmptyParts).count();
-            }
-        } else {
-            DBUG << "Not saving to mpd folder - set to save in mpd?" << Settings::self()->storeBackdropsInMpdDir()
-                 << "isVa:" << currentSong.isVariousArtists() << "isNonMPD:" << currentSong.isNonMPD()
-                 << "mpd readable:" << MPDConnection::self()->getDetails().dirReadable;
+        if (!prefetch) {
+            updateImage(img);
+        }
+        saveBackdrop(data, prefetch ? prefetchSong : currentSong, prefetch ? prefetchArtist : currentArtist);
+        if (!prefetch) {
+            QWidget::update();
         }
+    }
+}
 
-        if (!saved) {
-            QString cacheName=cacheFileName(currentArtist, true);
-            QFile f(cacheName);
+void ContextWidget::saveBackdrop(const QByteArray &data, const Song &sng, const QString &artistName)
+{
+    bool saved=false;
+
+    if (Settings::self()->storeBackdropsInMpdDir() && !sng.isVariousArtists() &&
+        !sng.isNonMPD() && MPDConnection::self()->getDetails().dirReadable) {
+        QString mpdDir=MPDConnection::self()->getDetails().dir;
+        QString songDir=Utils::getDir(sng.file);
+        if (!mpdDir.isEmpty() && 2==songDir.split(Utils::constDirSep, QString::SkipEmptyParts).count()) {
+            QDir d(mpdDir+songDir);
+            d.cdUp();
+            QString fileName=Utils::fixPath(d.absolutePath())+constBackdropFileName+".jpg";
+            QFile f(fileName);
             if (f.open(QIODevice::WriteOnly)) {
-                DBUG << "Saved backdrop to (cache)" << cacheName << "for artist" << currentArtist << ", current song" << currentSong.file;
                 f.write(data);
                 f.close();
+                DBUG << "Saved backdrop to" << fileName << "for artist" << artistName << ", current song" << sng.file;
+                saved=true;
             }
+        } else {
+            DBUG << "Not saving to mpd folder, mpd dir:" << mpdDir
+                 << "num parts:" << songDir.split(Utils::constDirSep, QString::SkipEmptyParts).count();
+        }
+    } else {
+        DBUG << "Not saving to mpd folder - set to save in mpd?" << Settings::self()->storeBackdropsInMpdDir()
+             << "isVa:" << sng.isVariousArtists() << "isNonMPD:" << sng.isNonMPD()
+             << "mpd readable:" << MPDConnection::self()->getDetails().dirReadable;
+    }
+
+    if (!saved) {
+        QString cacheName=cacheFileName(artistName, true);
+        QFile f(cacheName);
+        if (f.open(QIODevice::WriteOnly)) {
+            DBUG << "Saved backdrop to (cache)" << cacheName << "for artist" << artistName << ", current song" << sng.file;
+            f.write(data);
+            f.close();
+            ContentCache::self()->added(cacheName);
         }
-        QWidget::update();
     }
 }
 
@@ -1098,27 +1208,81 @@ void ContextWidget::createBackdrop()
     }
 }
 
+int ContextWidget::backdropWidth() const
+{
+    // Created backdrops are tiled, and so are not scaled.
+    if (currentImageCreated) {
+        return 0;
+    }
+    #if QT_VERSION >= 0x050100
+    if (Settings::self()->retinaSupport()) {
+        return width()*devicePixelRatio();
+    }
+    #endif
+    return width();
+}
+
 void ContextWidget::resizeBackdrop()
 {
-    #ifdef SCALE_CONTEXT_BGND
-    if (!albumCoverBackdrop && !currentImage.isNull() &&( currentBackdrop.isNull() || (!currentBackdrop.isNull() && currentBackdrop.width()!=width()))) {
-        QSize sz(width(), width()*currentImage.height()/currentImage.width());
-        currentBackdrop = QPixmap::fromImage(currentImage.scaled(sz, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation));
+    if (!currentImage.isNull() && !currentImageCreated && scaledWidth!=backdropWidth()) {
+        requestBackdrop();
     }
-    #else
-    if (!currentBackdrop.isNull() && !albumCoverBackdrop) {
-        if (currentBackdrop.width()<minBackdropSize.width() && currentBackdrop.height()<minBackdropSize.height()) {
-            QSize size(minBackdropSize);
-            if (currentBackdrop.width()<minBackdropSize.width()/4 && currentBackdrop.height()<minBackdropSize.height()/4) {
-                size=QSize(minBackdropSize.width()/2, minBackdropSize.height()/2);
-            }
-            currentBackdrop=currentBackdrop.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        } else if (maxBackdropSize.width()>1024 && maxBackdropSize.height()>768 &&
-                   (currentBackdrop.width()>maxBackdropSize.width() || currentBackdrop.height()>maxBackdropSize.height())) {
-            currentBackdrop=currentBackdrop.scaled(maxBackdropSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+}
+
+void ContextWidget::requestBackdrop()
+{
+    if (currentImage.isNull()) {
+        return;
+    }
+    // Only have one request outstanding - so that resizing does not queue up lots of (soon to be
+    // obsolete) scale operations.
+    if (scaleInFlight) {
+        scaleAgain=true;
+        return;
+    }
+    if (!scaler) {
+        scaler=new BackdropScaler();
+        connect(scaler, SIGNAL(scaled(int,QImage)), SLOT(backdropScaled(int,QImage)));
+        connect(this, SIGNAL(scaleBackdrop(int,QString,QImage,int,int,int)), scaler, SLOT(scale(int,QString,QImage,int,int,int)));
+    }
+    scaleInFlight=true;
+    scaleAgain=false;
+    scaledWidth=backdropWidth();
+    scaleKey=currentImageKey;
+    DBUG << scaleRequest+1 << scaleKey << scaledWidth;
+    emit scaleBackdrop(++scaleRequest, scaleKey, currentImage, backdropOpacity, backdropBlur, scaledWidth);
+}
+
+void ContextWidget::backdropScaled(int id, const QImage &img)
+{
+    DBUG << id << scaleRequest << img.size();
+    if (id!=scaleRequest) {
+        return;
+    }
+    scaleInFlight=false;
+
+    // Ignore results for images that have since been replaced...
+    if (scaleKey==currentImageKey && !currentImage.isNull()) {
+        QPixmap pix=QPixmap::fromImage(img);
+        #if QT_VERSION >= 0x050100
+        if (!currentImageCreated && Settings::self()->retinaSupport()) {
+            pix.setDevicePixelRatio(devicePixelRatio());
+        }
+        #endif
+        if (fadeInPending) {
+            fadeInPending=false;
+            showBackdrop(pix, currentImageCreated);
+        } else {
+            currentBackdrop=pix;
+            albumCoverBackdrop=currentImageCreated;
+            QWidget::update();
         }
     }
-    #endif
+
+    if (scaleAgain || scaleKey!=currentImageKey) {
+        scaleAgain=false;
+        requestBackdrop();
+    }
 }
 
 void ContextWidget::backdropCreated(const QString &artist, const QImage &img)
@@ -1143,9 +1307,30 @@ NetworkJob * ContextWidget::getReply(QObject *obj)
     }
 
     reply->deleteLater();
-    if (reply!=job) {
+    if (reply==job) {
+        job=0;
+    } else if (reply==prefetchJob) {
+        prefetchJob=0;
+    } else {
         return 0;
     }
-    job=0;
     return reply;
 }
+
+NetworkJob * ContextWidget::startJob(const QUrl &url, bool prefetch, const char *slot, int timeout)
+{
+    QNetworkRequest req(url);
+    if (prefetch) {
+        req.setPriority(QNetworkRequest::LowPriority);
+    }
+    NetworkJob *j=NetworkAccessManager::self()->get(req, timeout);
+    DBUG << url.toString() << prefetch;
+    j->setProperty(constPrefetchProp, prefetch);
+    connect(j, SIGNAL(finished()), this, slot);
+    if (prefetch) {
+        prefetchJob=j;
+    } else {
+        job=j;
+    }
+    return j;
+}
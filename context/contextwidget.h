@@ -31,14 +31,12 @@
 #include <QSplitter>
 #include "mpd-interface/song.h"
 
-#ifndef SCALE_CONTEXT_BGND
-#define SCALE_CONTEXT_BGND
-#endif
-
 class ArtistView;
 class AlbumView;
 class SongView;
 class BackdropCreator;
+class BackdropScaler;
+class ContextPrefetcher;
 class NetworkJob;
 class QStackedWidget;
 class QComboBox;
@@ -46,6 +44,7 @@ class QImage;
 class QToolButton;
 class QButtonGroup;
 class QWheelEvent;
+class QUrl;
 #ifdef ENABLE_ONLINE_SERVICES
 class OnlineView;
 #endif
@@ -109,11 +108,12 @@ public:
     void saveConfig();
     void useDarkBackground(bool u);
     void update(const Song &s);
+    void prefetch(const Song &s);
     void showEvent(QShowEvent *e);
     void paintEvent(QPaintEvent *e);
     float fade() { return fadeValue; }
     void setFade(float value);
-    void updateImage(QImage img, bool created=false);
+    void updateImage(QImage img, bool created=false, const QString &key=QString());
     void search();
 
 Q_SIGNALS:
@@ -121,6 +121,7 @@ Q_SIGNALS:
     void findAlbum(const QString &artist, const QString &album);
     void playSong(const QString &file);
     void createBackdrop(const QString &artist, const QList<Song> &songs);
+    void scaleBackdrop(int id, const QString &key, const QImage &img, int opacity, int blur, int width);
 
 private Q_SLOTS:
     void musicbrainzResponse();
@@ -128,6 +129,8 @@ private Q_SLOTS:
     void discoGsResponse();
     void downloadResponse();
     void backdropCreated(const QString &artist, const QImage &img);
+    void prefetchBackdrop(const Song &s);
+    void backdropScaled(int id, const QImage &img);
 
 private:
     void setZoom();
@@ -135,17 +138,27 @@ private:
     void resizeEvent(QResizeEvent *e);
     bool eventFilter(QObject *o, QEvent *e);
     void cancel();
+    void cancelPrefetch();
     void updateBackdrop(bool force=false);
     void getBackdrop();
     void getFanArtBackdrop();
-    void getMusicbrainzId(const QString &artist);
-    void getDiscoGsImage();
+    void getMusicbrainzId(const QString &artist, bool prefetch=false);
+    void getDiscoGsImage(bool prefetch=false);
     void createBackdrop();
     void resizeBackdrop();
+    int backdropWidth() const;
+    void requestBackdrop();
+    void showBackdrop(const QPixmap &pix, bool created);
+    void saveBackdrop(const QByteArray &data, const Song &sng, const QString &artistName);
     NetworkJob * getReply(QObject *obj);
+    NetworkJob * startJob(const QUrl &url, bool prefetch, const char *slot, int timeout=0);
 
 private:
     NetworkJob *job;
+    NetworkJob *prefetchJob;
+    Song prefetchSong;
+    QString prefetchArtist;
+    ContextPrefetcher *prefetcher;
     bool alwaysCollapsed;
     int backdropType;
     int backdropOpacity;
@@ -156,9 +169,9 @@ private:
     bool albumCoverBackdrop;
     bool oldIsAlbumCoverBackdrop;
     Song currentSong;
-    #ifdef SCALE_CONTEXT_BGND
-    QImage currentImage;
-    #endif
+    QImage currentImage; // Unscaled source of currentBackdrop
+    QString currentImageKey;
+    bool currentImageCreated;
     QPixmap oldBackdrop;
     QPixmap currentBackdrop;
     QString currentArtist;
@@ -181,10 +194,14 @@ private:
     ViewSelector *viewSelector;
     BackdropCreator *creator;
     QSet<QString> backdropAlbums;
-    #ifndef SCALE_CONTEXT_BGND
-    QSize minBackdropSize;
-    QSize maxBackdropSize;
-    #endif
+    BackdropScaler *scaler;
+    int imageCount;
+    int scaleRequest;
+    int scaledWidth;
+    QString scaleKey;
+    bool scaleInFlight;
+    bool scaleAgain;
+    bool fadeInPending;
     QList<QString> artistsCreatedBackdropsFor;
 };
 
@@ -26,6 +26,7 @@
 #include "ultimatelyricsprovider.h"
 #include "ultimatelyrics.h"
 #include "contextengine.h"
+#include "contentcache.h"
 #include "gui/settings.h"
 #include "gui/covers.h"
 #include "support/squeezedtextlabel.h"
@@ -61,7 +62,7 @@ const QLatin1String SongView::constExtension(".lyrics");
 const QLatin1String SongView::constCacheDir("tracks/");
 const QLatin1String SongView::constInfoExt(".html.gz");
 
-static QString infoCacheFileName(const Song &song, const QString &lang, bool createDir)
+QString SongView::infoCacheFileName(const Song &song, const QString &lang, bool createDir)
 {
     QString artist=song.artist;
     QString title=song.title;
@@ -75,7 +76,7 @@ static QString infoCacheFileName(const Song &song, const QString &lang, bool cre
     return dir+Covers::encodeName(title)+"."+lang+SongView::constInfoExt;
 }
 
-static QString lyricsCacheFileName(const Song &song, bool createDir=false)
+QString SongView::lyricsCacheFileName(const Song &song, bool createDir)
 {
     QString artist=song.artist;
     QString title=song.title;
@@ -144,7 +145,7 @@ SongView::SongView(QWidget *p)
     connect(refreshAction, SIGNAL(triggered()), SLOT(update()));
     connect(editAction, SIGNAL(triggered()), SLOT(edit()));
     connect(delAction, SIGNAL(triggered()), SLOT(del()));
-    connect(UltimateLyrics::self(), SIGNAL(lyricsReady(int, QString)), SLOT(lyricsReady(int, QString)));
+    connect(UltimateLyrics::self(), SIGNAL(lyricsReady(int, int, QString)), SLOT(lyricsReady(int, int, QString)));
 
     engine=ContextEngine::create(this);
     refreshInfoAction = ActionCollection::get()->createAction("refreshtrack", i18n("Refresh Track Information"), "view-refresh");
@@ -179,7 +180,7 @@ void SongView::update()
     QString mpdName=mpdFileName();
     QString cacheName=cacheFileName();
     bool mpdExists=!mpdName.isEmpty() && QFile::exists(mpdName);
-    bool cacheExists=!cacheName.isEmpty() && QFile::exists(cacheName);
+    bool cacheExists=!cacheName.isEmpty() && ContentCache::self()->exists(cacheName);
 
     if (mpdExists || cacheExists) {
         switch (MessageBox::warningYesNoCancel(this, i18n("Reload lyrics?\n\nReload from disk, or delete disk copy and download?"), i18n("Reload"),
@@ -191,7 +192,7 @@ void SongView::update()
                 QFile::remove(mpdName);
             }
             if (cacheExists) {
-                QFile::remove(cacheName);
+                ContentCache::self()->remove(cacheName);
             }
             break;
         default:
@@ -223,10 +224,7 @@ void SongView::search()
         if (!mpdName.isEmpty() && QFile::exists(mpdName)) {
             QFile::remove(mpdName);
         }
-        QString cacheName=cacheFileName();
-        if (!cacheName.isEmpty() && QFile::exists(cacheName)) {
-            QFile::remove(cacheName);
-        }
+        ContentCache::self()->remove(cacheFileName());
         update(dlg.song(), true);
     }
 }
@@ -244,10 +242,7 @@ void SongView::del()
     }
 
     QString mpdName=mpdFileName();
-    QString cacheName=cacheFileName();
-    if (!cacheName.isEmpty() && QFile::exists(cacheName)) {
-        QFile::remove(cacheName);
-    }
+    ContentCache::self()->remove(cacheFileName());
     if (!mpdName.isEmpty() && QFile::exists(mpdName)) {
         QFile::remove(mpdName);
     }
@@ -412,9 +407,10 @@ void SongView::loadLyrics()
         // Delete the cached lyrics file when the user is force-fully re-fetching the lyrics.
         // Afterwards we'll simply do getLyrics() to get the new ones.
         QFile::remove(file);
-    } else */if (setLyricsFromFile(file)) {
+    } else */if (ContentCache::self()->exists(file) && setLyricsFromFile(file)) {
        // We just wanted a normal update without explicit re-fetching. We can return
        // here because we got cached lyrics and we don't want an explicit re-fetch.
+       ContentCache::self()->touch(file);
        lyricsFile=file;
        setMode(Mode_Display);
        return;
@@ -432,7 +428,7 @@ void SongView::loadInfo()
     foreach (const QString &lang, engine->getLangs()) {
         QString prefix=engine->getPrefix(lang);
         QString cachedFile=infoCacheFileName(currentSong, prefix, false);
-        if (QFile::exists(cachedFile)) {
+        if (ContentCache::self()->exists(cachedFile)) {
             QFile f(cachedFile);
             QtIOCompressor compressor(&f);
             compressor.setStreamFormat(QtIOCompressor::GzipFormat);
@@ -441,7 +437,7 @@ void SongView::loadInfo()
 
                 if (!data.isEmpty()) {
                     infoSearchResponse(QString::fromUtf8(data), QString());
-                    Utils::touchFile(cachedFile);
+                    ContentCache::self()->touch(cachedFile);
                     return;
                 }
             }
@@ -639,7 +635,7 @@ void SongView::refreshInfo()
         return;
     }
     foreach (const QString &lang, engine->getLangs()) {
-        QFile::remove(infoCacheFileName(currentSong, engine->getPrefix(lang), false));
+        ContentCache::self()->remove(infoCacheFileName(currentSong, engine->getPrefix(lang), false));
     }
     searchForInfo();
 }
@@ -664,6 +660,8 @@ void SongView::infoSearchResponse(const QString &resp, const QString &lang)
             compressor.setStreamFormat(QtIOCompressor::GzipFormat);
             if (compressor.open(QIODevice::WriteOnly)) {
                 compressor.write(resp.toUtf8().constData());
+                compressor.close();
+                ContentCache::self()->added(f.fileName());
             }
         }
     }
@@ -699,7 +697,7 @@ void SongView::abort()
     }
     currentProvider=-1;
     if (currentProv) {
-        currentProv->abort();
+        UltimateLyrics::self()->abort(currentRequest);
         currentProv=0;
 
         text->setText(QString());
@@ -786,15 +784,16 @@ void SongView::downloadFinished()
     getLyrics();
 }
 
-void SongView::lyricsReady(int id, QString lyrics)
+void SongView::lyricsReady(int id, int index, QString lyrics)
 {
     if (id != currentRequest) {
         return;
     }
+    currentProvider=index;
     lyrics=lyrics.trimmed();
 
     if (lyrics.isEmpty()) {
-        getLyrics();
+        noLyrics();
     } else {
         cancelJobAction->setEnabled(false);
         hideSpinner();
@@ -825,6 +824,7 @@ bool SongView::saveFile(const QString &fileName)
     if (f.open(QIODevice::WriteOnly)) {
         QTextStream(&f) << text->toPlainText();
         f.close();
+        ContentCache::self()->added(fileName);
         lyricsFile=fileName;
         return true;
     }
@@ -845,22 +845,27 @@ QString SongView::cacheFileName() const
 
 void SongView::getLyrics()
 {
-    currentProv=UltimateLyrics::self()->getNext(currentProvider);
+    // Several providers are queried at once, but the message only mentions the preferred one.
+    currentProv=UltimateLyrics::self()->fetch(currentRequest, currentSong, currentProvider);
     if (currentProv) {
         text->setText(i18n("Fetching lyrics via %1", currentProv->displayName()));
-        currentProv->fetchInfo(currentRequest, currentSong);
         showSpinner();
     } else {
-        text->setText(QString());
-        currentProvider=-1;
-        // Set lyrics file anyway - so that editing is enabled!
-        lyricsFile=Settings::self()->storeLyricsInMpdDir() && !currentSong.isNonMPD()
-                ? mpdLyricsFilePath(currentSong)
-                : lyricsCacheFileName(currentSong);
-        setMode(Mode_Display);
+        noLyrics();
     }
 }
 
+void SongView::noLyrics()
+{
+    text->setText(QString());
+    currentProvider=-1;
+    // Set lyrics file anyway - so that editing is enabled!
+    lyricsFile=Settings::self()->storeLyricsInMpdDir() && !currentSong.isNonMPD()
+            ? mpdLyricsFilePath(currentSong)
+            : lyricsCacheFileName(currentSong);
+    setMode(Mode_Display);
+}
+
 void SongView::setMode(Mode m)
 {
     if (Mode_Display==m) {
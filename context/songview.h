@@ -56,6 +56,9 @@ public:
     static const QLatin1String constCacheDir;
     static const QLatin1String constInfoExt;
 
+    static QString infoCacheFileName(const Song &song, const QString &lang, bool createDir);
+    static QString lyricsCacheFileName(const Song &song, bool createDir=false);
+
     SongView(QWidget *p);
     ~SongView();
 
@@ -67,7 +70,7 @@ Q_SIGNALS:
 
 public Q_SLOTS:
     void downloadFinished();
-    void lyricsReady(int, QString lyrics);
+    void lyricsReady(int id, int index, QString lyrics);
     void update();
     void search();
     void edit();
@@ -95,6 +98,7 @@ private:
     QString mpdFileName() const;
     QString cacheFileName() const;
     void getLyrics();
+    void noLyrics();
     void setMode(Mode m);
     bool saveFile(const QString &fileName);
 
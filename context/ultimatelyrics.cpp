@@ -30,9 +30,27 @@
 #include <QFileInfoList>
 #include <QXmlStreamReader>
 #include <QSet>
+#include <QPair>
+#include <QDebug>
+
+static bool debugEnabled=false;
+#define DBUG if (debugEnabled) qWarning() << "UltimateLyrics" << __FUNCTION__
+void UltimateLyrics::enableDebug()
+{
+    debugEnabled=true;
+}
 
 GLOBAL_STATIC(UltimateLyrics, instance)
 
+// Number of responses required before a provider's statistics are used to order it.
+static const int constMinSamples=5;
+// Weight given to each new response when updating the (moving) averages.
+static const double constStatsWeight=0.125;
+// Latency, in milliseconds, at which a provider's score is halved.
+static const double constLatencyScale=2000.0;
+// Number of lookup ids whose provider order is remembered, so that they may step through their providers.
+static const int constMaxOrders=8;
+
 static bool compareLyricProviders(const UltimateLyricsProvider *a, const UltimateLyricsProvider *b)
 {
     return a->getRelevance() < b->getRelevance();
@@ -105,12 +123,46 @@ static UltimateLyricsProvider * parseProvider(QXmlStreamReader *reader)
     return scraper;
 }
 
+static bool compareScores(const QPair<double, UltimateLyricsProvider *> &a, const QPair<double, UltimateLyricsProvider *> &b)
+{
+    return a.first > b.first;
+}
+
+double UltimateLyrics::Stats::score() const
+{
+    // Providers we know little about are placed first, so that we learn about them...
+    return samples<constMinSamples ? 1.0 : hitRate*(constLatencyScale/(constLatencyScale+latency));
+}
+
+UltimateLyrics::UltimateLyrics()
+    : maxParallel(Settings::self()->parallelLyricLookups())
+    , statsChanged(false)
+{
+    foreach (const QString &entry, Settings::self()->lyricProviderStats()) {
+        QStringList parts=entry.split(QLatin1Char(':'));
+        if (4==parts.count()) {
+            Stats s;
+            s.samples=parts.at(1).toInt();
+            s.hitRate=parts.at(2).toDouble();
+            s.latency=parts.at(3).toDouble();
+            stats.insert(parts.at(0), s);
+        }
+    }
+}
+
 void UltimateLyrics::release()
 {
+    QList<int> ids=lookups.keys();
+    foreach (int id, ids) {
+        abort(id);
+    }
+    saveStats();
     foreach (UltimateLyricsProvider *provider, providers) {
         delete provider;
     }
     providers.clear();
+    orders.clear();
+    recentOrders.clear();
 }
 
 const QList<UltimateLyricsProvider *> UltimateLyrics::getProviders()
@@ -129,21 +181,6 @@ UltimateLyricsProvider * UltimateLyrics::providerByName(const QString &name) con
     return 0;
 }
 
-UltimateLyricsProvider * UltimateLyrics::getNext(int &index)
-{
-    load();
-    index++;
-    if (index>-1 && index<providers.count()) {
-        for (int i=index; i<providers.count(); ++i) {
-            if (providers.at(i)->isEnabled()) {
-                index=i;
-                return providers.at(i);
-            }
-        }
-    }
-    return 0;
-}
-
 void UltimateLyrics::load()
 {
     if (!providers.isEmpty()) {
@@ -172,7 +209,8 @@ void UltimateLyrics::load()
                             UltimateLyricsProvider *provider = parseProvider(&reader);
                             if (provider) {
                                 providers << provider;
-                                connect(provider, SIGNAL(lyricsReady(int,QString)), this, SIGNAL(lyricsReady(int,QString)));
+                                // Queued, as providers may respond from within fetchInfo()
+                                connect(provider, SIGNAL(lyricsReady(int,QString)), this, SLOT(providerResponse(int,QString)), Qt::QueuedConnection);
                                 providerNames.insert(name);
                             }
                         }
@@ -202,4 +240,159 @@ void UltimateLyrics::setEnabled(const QStringList &enabled)
     }
     qSort(providers.begin(), providers.end(), compareLyricProviders);
     Settings::self()->saveLyricProviders(enabled);
+    orders.clear();
+    recentOrders.clear();
+}
+
+UltimateLyricsProvider * UltimateLyrics::fetch(int id, const Song &song, int index)
+{
+    load();
+    abort(id);
+    // Only re-order providers for new lookups, so that the user can cycle through the providers
+    // (by refreshing) without the order changing underneath them. Each id has its own copy of the
+    // order, so that other lookups (e.g. prefetches) do not change it either.
+    QMap<int, QList<UltimateLyricsProvider *> >::ConstIterator it=orders.constFind(id);
+    if (index<0 || it==orders.constEnd()) {
+        it=orders.insert(id, currentOrder());
+        index=-1;
+    }
+
+    Lookup lookup;
+    lookup.song=song;
+    lookup.order=it.value();
+    lookup.next=index;
+    recentOrders.removeAll(id);
+    recentOrders.append(id);
+    while (recentOrders.count()>constMaxOrders) {
+        orders.remove(recentOrders.takeFirst());
+    }
+    while (lookup.running.count()<maxParallel && startNext(id, lookup)) {
+    }
+    if (lookup.running.isEmpty()) {
+        return 0;
+    }
+    lookups.insert(id, lookup);
+    return lookup.running.first();
+}
+
+void UltimateLyrics::abort(int id)
+{
+    QMap<int, Lookup>::Iterator it=lookups.find(id);
+    if (it!=lookups.end()) {
+        foreach (UltimateLyricsProvider *provider, it.value().running) {
+            if (!it.value().results.contains(provider)) {
+                provider->abort(id);
+            }
+        }
+        lookups.erase(it);
+    }
+}
+
+void UltimateLyrics::providerResponse(int id, const QString &data)
+{
+    UltimateLyricsProvider *provider=qobject_cast<UltimateLyricsProvider *>(sender());
+    if (!provider) {
+        return;
+    }
+    QMap<int, Lookup>::Iterator it=lookups.find(id);
+    if (it==lookups.end() || !it.value().running.contains(provider) || it.value().results.contains(provider)) {
+        return;
+    }
+
+    QString lyrics=data.trimmed();
+    updateStats(provider, !lyrics.isEmpty(), it.value().timers[provider].elapsed());
+    it.value().results.insert(provider, lyrics);
+    checkLookup(id);
+}
+
+QList<UltimateLyricsProvider *> UltimateLyrics::currentOrder() const
+{
+    QList<QPair<double, UltimateLyricsProvider *> > scored;
+    foreach (UltimateLyricsProvider *provider, providers) {
+        if (provider->isEnabled()) {
+            scored.append(qMakePair(stats.value(provider->getName()).score(), provider));
+        }
+    }
+    // Stable sort, so that providers with equal scores remain in the user's order.
+    qStableSort(scored.begin(), scored.end(), compareScores);
+    QList<UltimateLyricsProvider *> order;
+    for (int i=0; i<scored.count(); ++i) {
+        order.append(scored.at(i).second);
+    }
+    DBUG << order.count() << (order.isEmpty() ? QString() : order.first()->getName());
+    return order;
+}
+
+bool UltimateLyrics::startNext(int id, Lookup &lookup)
+{
+    if (lookup.next+1>=lookup.order.count()) {
+        return false;
+    }
+    UltimateLyricsProvider *provider=lookup.order.at(++lookup.next);
+    DBUG << id << provider->getName();
+    lookup.running.append(provider);
+    lookup.timers[provider].start();
+    provider->fetchInfo(id, lookup.song);
+    return true;
+}
+
+void UltimateLyrics::checkLookup(int id)
+{
+    Lookup &lookup=lookups[id];
+
+    // Results are only used in priority order - so, if a higher priority provider has yet to
+    // respond, then wait for it.
+    while (!lookup.running.isEmpty() && lookup.results.contains(lookup.running.first())) {
+        UltimateLyricsProvider *provider=lookup.running.takeFirst();
+        QString lyrics=lookup.results.take(provider);
+        lookup.timers.remove(provider);
+        if (!lyrics.isEmpty()) {
+            int index=lookup.order.indexOf(provider);
+            DBUG << id << "lyrics from" << provider->getName();
+            abort(id);
+            emit lyricsReady(id, index, lyrics);
+            return;
+        }
+    }
+
+    // Replace the providers that failed...
+    while (lookup.running.count()<maxParallel && startNext(id, lookup)) {
+    }
+
+    if (lookup.running.isEmpty()) {
+        DBUG << id << "no lyrics";
+        lookups.remove(id);
+        emit lyricsReady(id, -1, QString());
+    }
+}
+
+void UltimateLyrics::updateStats(UltimateLyricsProvider *provider, bool hit, qint64 ms)
+{
+    Stats &s=stats[provider->getName()];
+    if (0==s.samples) {
+        s.hitRate=hit ? 1.0 : 0.0;
+        s.latency=ms;
+    } else {
+        s.hitRate+=((hit ? 1.0 : 0.0)-s.hitRate)*constStatsWeight;
+        s.latency+=(ms-s.latency)*constStatsWeight;
+    }
+    s.samples++;
+    statsChanged=true;
+    DBUG << provider->getName() << hit << ms << s.hitRate << s.latency;
+}
+
+void UltimateLyrics::saveStats()
+{
+    if (!statsChanged) {
+        return;
+    }
+    QStringList entries;
+    QMap<QString, Stats>::ConstIterator it=stats.constBegin();
+    QMap<QString, Stats>::ConstIterator end=stats.constEnd();
+    for (; it!=end; ++it) {
+        entries.append(it.key()+QLatin1Char(':')+QString::number(it.value().samples)+QLatin1Char(':')+
+                       QString::number(it.value().hitRate, 'f', 3)+QLatin1Char(':')+QString::number((int)it.value().latency));
+    }
+    Settings::self()->saveLyricProviderStats(entries);
+    statsChanged=false;
 }
@@ -24,7 +24,11 @@
 #ifndef ULTIMATELYRICS_H
 #define ULTIMATELYRICS_H
 
+#include "mpd-interface/song.h"
 #include <QObject>
+#include <QMap>
+#include <QHash>
+#include <QElapsedTimer>
 
 class UltimateLyricsProvider;
 
@@ -33,23 +37,61 @@ class UltimateLyrics : public QObject
     Q_OBJECT
 
 public:
+    static void enableDebug();
     static UltimateLyrics * self();
-    UltimateLyrics() { }
+    UltimateLyrics();
 
-    UltimateLyricsProvider * getNext(int &index);
     const QList<UltimateLyricsProvider *> getProviders();
     void release();
     void setEnabled(const QStringList &enabled);
 
+    // Query several providers at once, starting with the one after 'index' in the lookup order.
+    // lyricsReady() is emitted with the lyrics of the highest priority provider that had some, or
+    // with an index of -1 if none did. Returns the first provider queried, or 0 if there are none.
+    UltimateLyricsProvider * fetch(int id, const Song &song, int index=-1);
+    void abort(int id);
+
 Q_SIGNALS:
-    void lyricsReady(int id, const QString &data);
+    void lyricsReady(int id, int index, const QString &data);
+
+private Q_SLOTS:
+    void providerResponse(int id, const QString &data);
 
 private:
+    struct Stats {
+        Stats() : samples(0), hitRate(0.0), latency(0.0) { }
+        double score() const;
+        int samples;
+        double hitRate;
+        double latency;
+    };
+
+    struct Lookup {
+        Lookup() : next(-1) { }
+        Song song;
+        QList<UltimateLyricsProvider *> order; // Enabled providers, sorted by score
+        int next; // Index, within 'order', of the last provider queried
+        QList<UltimateLyricsProvider *> running; // In priority order
+        QHash<UltimateLyricsProvider *, QString> results;
+        QHash<UltimateLyricsProvider *, QElapsedTimer> timers;
+    };
+
     UltimateLyricsProvider * providerByName(const QString &name) const;
     void load();
+    QList<UltimateLyricsProvider *> currentOrder() const;
+    bool startNext(int id, Lookup &lookup);
+    void checkLookup(int id);
+    void updateStats(UltimateLyricsProvider *provider, bool hit, qint64 ms);
+    void saveStats();
 
 private:
-    QList<UltimateLyricsProvider *> providers;
+    QList<UltimateLyricsProvider *> providers; // Sorted by user preference
+    QMap<int, QList<UltimateLyricsProvider *> > orders; // Order used by the last lookup of each id
+    QList<int> recentOrders; // Ids in 'orders', least recently used first
+    QMap<QString, Stats> stats;
+    QMap<int, Lookup> lookups;
+    int maxParallel;
+    bool statsChanged;
 };
 
 #endif // ULTIMATELYRICS_H
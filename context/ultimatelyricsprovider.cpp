@@ -289,6 +289,20 @@ void UltimateLyricsProvider::abort()
     songs.clear();
 }
 
+void UltimateLyricsProvider::abort(int id)
+{
+    QHash<NetworkJob *, int>::Iterator it(requests.begin());
+    while (it!=requests.end()) {
+        if (it.value()==id) {
+            it.key()->cancelAndDelete();
+            it=requests.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    songs.remove(id);
+}
+
 void UltimateLyricsProvider::wikiMediaSearchResponse()
 {
     NetworkJob *reply = qobject_cast<NetworkJob*>(sender());
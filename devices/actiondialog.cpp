@@ -35,6 +35,7 @@
 #include "mpd-interface/mpdparseutils.h"
 #include "mpd-interface/mpdconnection.h"
 #include "encoders.h"
+#include "transcodingscheduler.h"
 #include "support/localize.h"
 #include "support/messagebox.h"
 #include "filejob.h"
@@ -101,6 +102,8 @@ public:
 
 ActionDialog::ActionDialog(QWidget *parent)
     : Dialog(parent)
+    , mode(Copy)
+    , sourceIsAudioCd(false)
     , mpdConfigured(false)
     , currentDev(0)
     , songDialog(0)
@@ -128,6 +131,13 @@ ActionDialog::ActionDialog(QWidget *parent)
 ActionDialog::~ActionDialog()
 {
     iCount--;
+    if (Copy==mode) {
+        Device *dev=getDevice(sourceUdi.isEmpty() ? destUdi : sourceUdi, false);
+        if (dev) {
+            dev->clearQueue();
+        }
+    }
+    TranscodingScheduler::self()->clear();
     updateUnity(true);
 }
 
@@ -244,9 +254,7 @@ void ActionDialog::copy(const QString &srcUdi, const QString &dstUdi, const QLis
     // check space...
     haveVariousArtists=false;
     qint64 spaceRequired=0;
-    #ifdef ACTION_DIALOG_SHOW_TIME_REMAINING
     totalTime=0;
-    #endif
     foreach (const Song &s, songsToAction) {
         quint32 size=s.size;
         if (sourceIsAudioCd) {
@@ -264,9 +272,7 @@ void ActionDialog::copy(const QString &srcUdi, const QString &dstUdi, const QLis
         if (!haveVariousArtists && s.isVariousArtists()) {
             haveVariousArtists=true;
         }
-        #ifdef ACTION_DIALOG_SHOW_TIME_REMAINING
         totalTime+=s.time;
-        #endif
     }
 
     qint64 spaceAvailable=0;
@@ -362,9 +368,7 @@ void ActionDialog::remove(const QString &udi, const QList<Song> &songs)
         dirsToClean.insert(baseDir+Utils::getDir(s.file));
     }
     show();
-    #ifdef ACTION_DIALOG_SHOW_TIME_REMAINING
     timer.start();
-    #endif
     doNext();
 }
 
@@ -386,10 +390,8 @@ void ActionDialog::init(const QString &srcUdi, const QString &dstUdi, const QLis
     paused=false;
     actionedSongs.clear();
     skippedSongs.clear();
-    #ifdef ACTION_DIALOG_SHOW_TIME_REMAINING
     actionedTime=0;
     timeTaken=0;
-    #endif
     currentPercent=0;
     currentDev=0;
     count=0;
@@ -425,9 +427,8 @@ void ActionDialog::slotButtonClicked(int button)
             Settings::self()->saveOverwriteSongs(overwrite->isChecked());
             setPage(PAGE_PROGRESS);
             hideSongs();
-            #ifdef ACTION_DIALOG_SHOW_TIME_REMAINING
             timer.start();
-            #endif
+            queueSongs();
             doNext();
             break;
         case Cancel:
@@ -442,17 +443,11 @@ void ActionDialog::slotButtonClicked(int button)
         }
         break;
     case PAGE_SKIP:
-        #ifdef ACTION_DIALOG_SHOW_TIME_REMAINING
-        timeTaken+=timer.elapsed();
-        #endif
         setPage(PAGE_PROGRESS);
         switch(button) {
         case User1:
             skippedSongs.append(currentSong);
-            #ifdef ACTION_DIALOG_SHOW_TIME_REMAINING
             totalTime-=currentSong.time;
-            timer.restart();
-            #endif
             incProgress();
             doNext();
             break;
@@ -637,13 +632,13 @@ void ActionDialog::doNext()
 
 void ActionDialog::actionStatus(int status, bool copiedCover)
 {
+    // Song has been copied, or skipped, so any transcoded temp file is no longer required...
+    TranscodingScheduler::self()->release(currentSong.file);
     int origStatus=status;
     bool wasSkip=false;
     if (Device::Ok!=status && Device::NotConnected!=status && autoSkip) {
         skippedSongs.append(currentSong);
-        #ifdef ACTION_DIALOG_SHOW_TIME_REMAINING
         totalTime-=currentSong.time;
-        #endif
         wasSkip=true;
         status=Device::Ok;
     }
@@ -653,9 +648,7 @@ void ActionDialog::actionStatus(int status, bool copiedCover)
         if (Device::Ok==origStatus) {
             if (!wasSkip) {
                 actionedSongs.append(currentSong);
-                #ifdef ACTION_DIALOG_SHOW_TIME_REMAINING
                 actionedTime+=currentSong.time;
-                #endif
                 #ifdef ENABLE_REPLAYGAIN_SUPPORT
                 if (Copy==mode && sourceIsAudioCd && !albumsWithoutRgTags.contains(currentSong.album) && Tags::readReplaygain(destFile).isEmpty()) {
                     albumsWithoutRgTags.insert(currentSong.album);
@@ -785,9 +778,11 @@ void ActionDialog::setPage(int page, const StringPairList &msg, const QString &h
         case PAGE_PROGRESS:
             actionLabel->startAnimation();
             setButtons(Cancel);
+            resumeTimer();
             break;
         case PAGE_SKIP:
             actionLabel->stopAnimation();
+            pauseTimer();
             skipText->setText(msg, QLatin1String("<b>")+i18n("Error")+QLatin1String("</b><br/>")+header+
                               (header.isEmpty() ? QString() : QLatin1String("<br/><br/>")));
             if (songsToAction.count()) {
@@ -801,6 +796,7 @@ void ActionDialog::setPage(int page, const StringPairList &msg, const QString &h
             break;
         case PAGE_ERROR:
             actionLabel->stopAnimation();
+            pauseTimer();
             stack->setCurrentIndex(PAGE_ERROR);
             errorText->setText(msg, QLatin1String("<b>")+i18n("Error")+QLatin1String("</b><br/>")+header+
                                (header.isEmpty() ? QString() : QLatin1String("<br/><br/>")));
@@ -825,26 +821,88 @@ ActionDialog::StringPairList ActionDialog::formatSong(const Song &s, bool showFi
         }
     }
 
-    #ifdef ACTION_DIALOG_SHOW_TIME_REMAINING
     if (showTime) {
-        QString estimate=i18n("Calculating...");
-        double taken=timeTaken+timer.elapsed();
-        if (taken>5.0) {
-            double pc=(progressBar->value()*1.0)/(progressBar->maximum()*1.0);
-            double percent=Copy==mode ? (actionedTime+(currentPercent*0.01*currentSong.time))/totalTime : pc;
-            percent-=percent*((1.0-percent)*0.15);
-            quint64 timeRemaining=((taken/percent)-taken)/1000.0;
-            estimate=i18nc("time (Estimated)", "%1 (Estimated)", Song::formattedTime(timeRemaining>0 ? timeRemaining : 0));
+        if (TranscodingScheduler::self()->isActive()) {
+            str.append(StringPair(i18n("Transcoding:"), i18n("%1 running, %2 waiting", TranscodingScheduler::self()->running(),
+                                                             TranscodingScheduler::self()->pending())));
         }
-        str.append(StringPair(i18n("Time remaining:"), estimate);
+        str.append(StringPair(i18n("Time remaining:"), timeRemaining()));
     }
-    #else
-    Q_UNUSED(showTime)
-    #endif
     
     return str;
 }
 
+QString ActionDialog::timeRemaining()
+{
+    quint64 taken=timeTaken+(timer.isValid() ? timer.elapsed() : 0);
+    // Wait for at least 5 seconds, so that estimate is not too erratic...
+    if (taken<5000) {
+        return i18n("Calculating...");
+    }
+
+    // If songs are being transcoded in parallel, then the scheduler has a better idea of the overall time...
+    int remaining=TranscodingScheduler::self()->timeRemaining();
+    if (remaining<0) {
+        double done=0.0;
+        if (Copy==mode && totalTime>0.0) {
+            done=(actionedTime+(currentPercent*0.01*currentSong.time))/totalTime;
+        } else if (progressBar->maximum()>0) {
+            done=(progressBar->value()*1.0)/(progressBar->maximum()*1.0);
+        }
+        if (done<=0.0) {
+            return i18n("Calculating...");
+        }
+        remaining=(((taken/done)-taken)/1000.0)+0.5;
+    }
+    return i18nc("time (Estimated)", "%1 (Estimated)", Utils::formatTime(remaining>0 ? remaining : 0));
+}
+
+void ActionDialog::pauseTimer()
+{
+    if (timer.isValid()) {
+        timeTaken+=timer.elapsed();
+        timer.invalidate();
+    }
+}
+
+void ActionDialog::resumeTimer()
+{
+    if (!timer.isValid()) {
+        timer.start();
+    }
+}
+
+void ActionDialog::queueSongs()
+{
+    if (Copy!=mode) {
+        return;
+    }
+    if (sourceIsAudioCd) {
+        // Allow tracks to be read from CD whilst previous tracks are encoded
+        Device *dev=getDevice(sourceUdi, false);
+        if (dev) {
+            dev->queueSongs(songsToAction, overwrite->isChecked());
+        }
+        return;
+    }
+    // Otherwise, only songs copied to a device may be transcoded...
+    if (!sourceUdi.isEmpty()) {
+        return;
+    }
+    Device *dev=getDevice(destUdi, false);
+    if (!dev) {
+        return;
+    }
+    QList<Song> songs;
+    QString mpdDir=MPDConnection::self()->getDetails().dir;
+    foreach (const Song &s, songsToAction) {
+        Song song=s;
+        song.file=mpdDir+s.filePath();
+        songs.append(song);
+    }
+    dev->queueSongs(songs, overwrite->isChecked());
+}
+
 bool ActionDialog::refreshLibrary()
 {
     actionLabel->stopAnimation();
@@ -35,6 +35,7 @@
 #include "models/dirviewmodel.h"
 #include "support/utils.h"
 #include "extractjob.h"
+#include "transcodingscheduler.h"
 #include "mpd-interface/mpdconnection.h"
 #include "gui/covers.h"
 #include "gui/settings.h"
@@ -99,6 +100,10 @@ AudioCdDevice::AudioCdDevice(MusicModel *m, Solid::Device &dev)
     , time(0xFFFFFFFF)
     , lookupInProcess(false)
     , autoPlay(false)
+    , ripper(0)
+    , ripEncoderValue(0)
+    , waitingForTrack(false)
+    , ripCopyCover(false)
 {
     icn=Icon("media-optical");
     drive=dev.parent().as<Solid::OpticalDrive>();
@@ -138,6 +143,7 @@ AudioCdDevice::AudioCdDevice(MusicModel *m, Solid::Device &dev)
 
 AudioCdDevice::~AudioCdDevice()
 {
+    stopRipper();
     QList<Song> tracks;
     foreach (const MusicLibraryItem *item, childItems()) {
         if (MusicLibraryItem::Type_Song==item->itemType()) {
@@ -276,12 +282,205 @@ void AudioCdDevice::copySongTo(const Song &s, const QString &musicPath, bool ove
     }
 
     currentSong=s;
+    if (queuedTracks.contains(s.id)) {
+        // Track is being ripped/encoded in the background...
+        ripCopyCover=copyCover;
+        if (ripFailures.contains(s.id)) {
+            int status=ripFailures.take(s.id);
+            queuedTracks.remove(s.id);
+            emit actionStatus(status);
+        } else if (rippedTracks.contains(s.id) && TranscodingScheduler::Finished==TranscodingScheduler::self()->state(rippedTracks[s.id])) {
+            finishTrack();
+        } else if (rippedTracks.contains(s.id) && TranscodingScheduler::Failed==TranscodingScheduler::self()->state(rippedTracks[s.id])) {
+            releaseTrack(s.id);
+            emit actionStatus(TranscodeFailed);
+        } else {
+            waitingForTrack=true;
+        }
+        return;
+    }
+
+    if (ripper) {
+        // Only one reader may access the drive at a time, so stop reading ahead. Any queued tracks
+        // that have not yet been read will then be extracted directly, as this one is.
+        stopReading();
+        QSet<int>::Iterator it=queuedTracks.begin();
+        while (it!=queuedTracks.end()) {
+            if (rippedTracks.contains(*it) || ripFailures.contains(*it)) {
+                ++it;
+            } else {
+                it=queuedTracks.erase(it);
+            }
+        }
+    }
+
     ExtractJob *job=new ExtractJob(encoder, mpdOpts.transcoderValue, source, currentDestFile, currentSong, copyCover ? coverImage.fileName : QString());
     connect(job, SIGNAL(result(int)), SLOT(copySongToResult(int)));
     connect(job, SIGNAL(percent(int)), SLOT(percent(int)));
     job->start();
 }
 
+void AudioCdDevice::queueSongs(const QList<Song> &songs, bool overwrite)
+{
+    stopRipper();
+    if (!isConnected()) {
+        return;
+    }
+
+    DeviceOptions mpdOpts;
+    mpdOpts.load(MPDConnectionDetails::configGroupName(MPDConnection::self()->getDetails().name), true);
+    ripEncoder=Encoders::getEncoder(mpdOpts.transcoderCodec);
+    if (ripEncoder.codec.isEmpty()) {
+        return;
+    }
+    ripEncoderValue=mpdOpts.transcoderValue;
+
+    QList<Song> tracks;
+    foreach (const Song &s, songs) {
+        if (!overwrite) {
+            Song check=s;
+            if (opts.fixVariousArtists && s.isVariousArtists()) {
+                Device::fixVariousArtists(QString(), check, false);
+            }
+            if (MusicLibraryModel::self()->songExists(check)) {
+                continue;
+            }
+        }
+        tracks.append(s);
+        queuedTracks.insert(s.id);
+    }
+
+    if (tracks.isEmpty()) {
+        return;
+    }
+
+    // Read one track ahead of each encoder, so that none are idle waiting for the drive.
+    ripper=new CdRipper(device, tracks, TranscodingScheduler::self()->maxJobs()+1);
+    connect(ripper, SIGNAL(ripped(Song,QString,int)), this, SLOT(trackRipped(Song,QString,int)));
+    connect(ripper, SIGNAL(percent(int,int)), this, SLOT(ripPercent(int,int)));
+    connect(TranscodingScheduler::self(), SIGNAL(jobPercent(QString,int)), this, SLOT(encodePercent(QString,int)), Qt::UniqueConnection);
+    connect(TranscodingScheduler::self(), SIGNAL(jobFinished(QString,int)), this, SLOT(encoded(QString,int)), Qt::UniqueConnection);
+    ripper->start();
+}
+
+void AudioCdDevice::abortJob()
+{
+    Device::abortJob();
+    stopRipper();
+}
+
+void AudioCdDevice::trackRipped(const Song &track, const QString &wavFile, int status)
+{
+    if (!queuedTracks.contains(track.id)) {
+        if (!wavFile.isEmpty()) {
+            QFile::remove(wavFile);
+        }
+        return;
+    }
+
+    if (Ok==status) {
+        rippedTracks.insert(track.id, wavFile);
+        Song wavSong=track;
+        wavSong.file=wavFile;
+        TranscodingScheduler::self()->queue(ripEncoder, ripEncoderValue, wavSong);
+    } else if (waitingForTrack && track.id==currentSong.id) {
+        waitingForTrack=false;
+        queuedTracks.remove(track.id);
+        emit actionStatus(status);
+    } else {
+        ripFailures.insert(track.id, status);
+    }
+}
+
+// Reading is first half of progress, encoding is second half.
+void AudioCdDevice::ripPercent(int track, int pc)
+{
+    if (waitingForTrack && track==currentSong.id) {
+        if (jobAbortRequested) {
+            stopRipper();
+            return;
+        }
+        emit progress(pc/2);
+    }
+}
+
+void AudioCdDevice::encodePercent(const QString &wavFile, int pc)
+{
+    if (waitingForTrack && rippedTracks.value(currentSong.id)==wavFile) {
+        if (jobAbortRequested) {
+            stopRipper();
+            return;
+        }
+        emit progress(50+(pc/2));
+    }
+}
+
+void AudioCdDevice::encoded(const QString &wavFile, int status)
+{
+    int track=rippedTracks.key(wavFile, -1);
+    if (-1==track) {
+        return;
+    }
+
+    // WAV file is no longer required, so remove and allow ripper to read another track.
+    QFile::remove(wavFile);
+    if (ripper) {
+        ripper->release();
+    }
+
+    if (waitingForTrack && track==currentSong.id) {
+        waitingForTrack=false;
+        if (Ok==status) {
+            finishTrack();
+        } else {
+            releaseTrack(track);
+            emit actionStatus(TranscodeFailed);
+        }
+    }
+}
+
+void AudioCdDevice::finishTrack()
+{
+    ExtractJob *job=new ExtractJob(ripEncoder, ripEncoderValue, device, currentDestFile, currentSong, ripCopyCover ? coverImage.fileName : QString());
+    job->setEncodedFile(TranscodingScheduler::self()->output(rippedTracks[currentSong.id]));
+    connect(job, SIGNAL(result(int)), SLOT(copySongToResult(int)));
+    connect(job, SIGNAL(percent(int)), SLOT(percent(int)));
+    job->start();
+}
+
+void AudioCdDevice::releaseTrack(int track)
+{
+    queuedTracks.remove(track);
+    QString wavFile=rippedTracks.take(track);
+    if (!wavFile.isEmpty()) {
+        TranscodingScheduler::self()->release(wavFile);
+        QFile::remove(wavFile);
+    }
+}
+
+void AudioCdDevice::stopReading()
+{
+    if (ripper) {
+        disconnect(ripper, 0, this, 0);
+        ripper->stop();
+        delete ripper;
+        ripper=0;
+    }
+}
+
+void AudioCdDevice::stopRipper()
+{
+    stopReading();
+    foreach (const QString &wavFile, rippedTracks) {
+        TranscodingScheduler::self()->cancel(wavFile);
+        QFile::remove(wavFile);
+    }
+    queuedTracks.clear();
+    rippedTracks.clear();
+    ripFailures.clear();
+    waitingForTrack=false;
+}
+
 quint32 AudioCdDevice::totalTime()
 {
     if (0xFFFFFFFF==time) {
@@ -310,6 +509,7 @@ void AudioCdDevice::copySongToResult(int status)
 {
     ExtractJob *job=qobject_cast<ExtractJob *>(sender());
     FileJob::finished(job);
+    releaseTrack(currentSong.id);
     if (jobAbortRequested) {
         if (job && job->wasStarted() && QFile::exists(currentDestFile)) {
             QFile::remove(currentDestFile);
@@ -25,6 +25,7 @@
 #define AUDIOCDDEVICE_H
 
 #include "device.h"
+#include "encoders.h"
 #include "gui/covers.h"
 #include "http/httpserver.h"
 #ifdef ENABLE_KDE_SUPPORT
@@ -33,8 +34,11 @@
 #include "solid-lite/opticaldrive.h"
 #endif
 #include <QImage>
+#include <QMap>
+#include <QSet>
 
 class CddbInterface;
+class CdRipper;
 class MusicBrainz;
 struct CdAlbum;
 
@@ -68,6 +72,9 @@ public:
     QString path() const { return devPath; }
     void addSong(const Song &, bool, bool) { }
     void copySongTo(const Song &s, const QString &musicPath, bool overwrite, bool copyCover);
+    void queueSongs(const QList<Song> &songs, bool overwrite);
+    void clearQueue() { stopRipper(); }
+    void abortJob();
     void removeSong(const Song &) { }
     void cleanDirs(const QSet<QString> &) { }
     double usedCapacity() { return 1.0; }
@@ -99,7 +106,17 @@ public Q_SLOTS:
     void cdMatches(const QList<CdAlbum> &albums);
     void setCover(const Song &song, const QImage &img, const QString &file);
 
+private Q_SLOTS:
+    void trackRipped(const Song &track, const QString &wavFile, int status);
+    void ripPercent(int track, int pc);
+    void encodePercent(const QString &wavFile, int pc);
+    void encoded(const QString &wavFile, int status);
+
 private:
+    void stopReading();
+    void stopRipper();
+    void finishTrack();
+    void releaseTrack(int track);
     void connectService(bool useCddb);
     void playTracks();
     void updateDetails();
@@ -126,6 +143,16 @@ private:
     bool lookupInProcess;
     Covers::Image coverImage;
     bool autoPlay;
+
+    // Rip-ahead state. Tracks are read into WAV files by 'ripper', and encoded in parallel by TranscodingScheduler
+    CdRipper *ripper;
+    Encoders::Encoder ripEncoder;
+    int ripEncoderValue;
+    QSet<int> queuedTracks;
+    QMap<int, QString> rippedTracks;
+    QMap<int, int> ripFailures;
+    bool waitingForTrack;
+    bool ripCopyCover;
 };
 
 #endif
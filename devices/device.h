@@ -169,6 +169,9 @@ public:
     const QString & statusMessage() const { return statusMsg; }
     bool isConfigured() { return configured; }
     virtual void abortJob() { jobAbortRequested=true; }
+    // Called before a batch of addSong() calls, allows songs to be prepared (e.g. transcoded) in advance.
+    virtual void queueSongs(const QList<Song> &songs, bool overwrite) { Q_UNUSED(songs) Q_UNUSED(overwrite) }
+    virtual void clearQueue() { }
     bool abortRequested() const { return jobAbortRequested; }
     virtual bool canPlaySongs() const { return false; }
     virtual bool supportsDisconnect() const { return false; }
@@ -28,9 +28,13 @@
 #include "gui/covers.h"
 #include "mpd-interface/mpdconnection.h"
 #include "gui/settings.h"
+#include "support/thread.h"
 #include <QStringList>
 #include <QProcess>
 #include <QFile>
+#include <QDir>
+#include <QTemporaryFile>
+#include <QMutexLocker>
 
 const int ExtractJob::constWavHeaderSize=44; // ffmpeg uses 46 byte header?
 
@@ -66,6 +70,142 @@ void ExtractJob::writeWavHeader(QIODevice &dev, qint32 size)
     dev.write((char*)riffHeader, constWavHeaderSize);
 }
 
+CdRipper::CdRipper(const QString &dev, const QList<Song> &t, int ahead)
+    : QObject(0)
+    , device(dev)
+    , tracks(t)
+    , maxAhead(qMax(1, ahead))
+    , spooled(0)
+    , stopRequested(false)
+{
+    thread=new Thread(metaObject()->className());
+    moveToThread(thread);
+    thread->start();
+}
+
+CdRipper::~CdRipper()
+{
+}
+
+void CdRipper::start()
+{
+    QMetaObject::invokeMethod(this, "rip", Qt::QueuedConnection);
+}
+
+// NOTE: Called from GUI thread. Blocks until the reading thread has finished, so that the drive
+// has been released - the caller may then delete this object.
+void CdRipper::stop()
+{
+    {
+        QMutexLocker locker(&mutex);
+        stopRequested=true;
+        cond.wakeAll();
+    }
+    if (thread) {
+        thread->stop();
+        thread->wait();
+        thread=0;
+    }
+}
+
+bool CdRipper::wasStopped()
+{
+    QMutexLocker locker(&mutex);
+    return stopRequested;
+}
+
+// NOTE: Called from GUI thread, once a spool file has been encoded and removed
+void CdRipper::release()
+{
+    QMutexLocker locker(&mutex);
+    if (spooled>0) {
+        spooled--;
+    }
+    cond.wakeAll();
+}
+
+void CdRipper::rip()
+{
+    CdParanoia cdparanoia(device, Settings::self()->paranoiaFull(), Settings::self()->paranoiaNeverSkip());
+
+    foreach (const Song &track, tracks) {
+        {
+            // Wait for encoders to catch up...
+            QMutexLocker locker(&mutex);
+            while (!stopRequested && spooled>=maxAhead) {
+                cond.wait(&mutex);
+            }
+            if (stopRequested) {
+                return;
+            }
+        }
+
+        if (!cdparanoia) {
+            emit ripped(track, QString(), Device::FailedToLockDevice);
+            continue;
+        }
+
+        QTemporaryFile temp(QDir::tempPath()+"/cantata_XXXXXX.wav");
+        temp.setAutoRemove(false);
+        if (!temp.open()) {
+            emit ripped(track, QString(), Device::FailedToCreateTempFile);
+            continue;
+        }
+        QString wavFile=temp.fileName();
+        temp.close();
+
+        int status=ripTrack(cdparanoia, track, wavFile);
+        if (Device::Ok!=status) {
+            QFile::remove(wavFile);
+            if (Device::Cancelled==status) {
+                return;
+            }
+            wavFile=QString();
+        } else {
+            QMutexLocker locker(&mutex);
+            spooled++;
+        }
+        emit ripped(track, wavFile, status);
+    }
+}
+
+int CdRipper::ripTrack(CdParanoia &cdparanoia, const Song &track, const QString &wavFile)
+{
+    QFile file(wavFile);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return Device::WriteFailed;
+    }
+
+    int firstSector = cdparanoia.firstSectorOfTrack(track.id);
+    int lastSector = cdparanoia.lastSectorOfTrack(track.id);
+    int total=lastSector-firstSector;
+    int count=0;
+    int lastPc=-1;
+
+    cdparanoia.seek(firstSector, SEEK_SET);
+    // We know the size of the data, so write a correct header - not all encoders accept 0-sized WAV files.
+    ExtractJob::writeWavHeader(file, (total+1)*CD_FRAMESIZE_RAW);
+    while ((firstSector+count) <= lastSector) {
+        if (wasStopped()) {
+            return Device::Cancelled;
+        }
+        qint16 *buf = cdparanoia.read();
+        if (!buf) {
+            return Device::Failed;
+        }
+        if (CD_FRAMESIZE_RAW!=file.write((char *)buf, CD_FRAMESIZE_RAW)) {
+            return Device::WriteFailed;
+        }
+        count++;
+        int pc=total>0 ? ((count*100/total)+0.5) : 100;
+        if (pc!=lastPc) {
+            lastPc=pc;
+            emit percent(track.id, pc);
+        }
+    }
+    return Device::Ok;
+}
+
 ExtractJob::ExtractJob(const Encoders::Encoder &enc, int val, const QString &src, const QString &dest, const Song &s, const QString &cover)
     : encoder(enc)
     , value(val)
@@ -83,8 +223,16 @@ ExtractJob::~ExtractJob()
 
 void ExtractJob::run()
 {
-    if (stopRequested) {
+    if (stopRequested()) {
         emit result(Device::Cancelled);
+    } else if (!encodedFile.isEmpty()) {
+        if (!moveEncodedFile()) {
+            emit result(Device::WriteFailed);
+            return;
+        }
+        setPercent(100);
+        updateTagsAndCover();
+        emit result(Device::Ok);
     } else {
         QStringList encParams=encoder.params(value, encoder.transcoder ? "pipe:" : "-", destFile);
         CdParanoia cdparanoia(srcFile, Settings::self()->paranoiaFull(), Settings::self()->paranoiaNeverSkip());
@@ -98,7 +246,7 @@ void ExtractJob::run()
         process.start(cmd, encParams, QIODevice::WriteOnly);
         process.waitForStarted();
 
-        if (stopRequested) {
+        if (stopRequested()) {
             emit result(Device::Cancelled);
             process.close();
             return;
@@ -118,7 +266,7 @@ void ExtractJob::run()
                 process.close();
                 return;
             }
-            if (stopRequested) {
+            if (stopRequested()) {
                 emit result(Device::Cancelled);
                 process.close();
                 return;
@@ -129,7 +277,7 @@ void ExtractJob::run()
             qint64 writePos=0;
             do {
                 qint64 bytesWritten = process.write(&buffer[writePos], CD_FRAMESIZE_RAW - writePos);
-                if (stopRequested) {
+                if (stopRequested()) {
                     emit result(Device::Cancelled);
                     process.close();
                     QFile::remove(destFile);
@@ -149,17 +297,37 @@ void ExtractJob::run()
         }
         process.closeWriteChannel();
         process.waitForFinished();
-        Utils::setFilePerms(destFile);
-        Tags::update(destFile, Song(), song, 3);
+        updateTagsAndCover();
+        emit result(Device::Ok);
+    }
+}
 
-        if (!stopRequested && !coverFile.isEmpty()) {
-            QString mpdCover=MPDConnection::self()->getDetails().coverName;
-            if (mpdCover.isEmpty()) {
-                mpdCover=Covers::constFileName;
-            }
-            copiedCover=Covers::copyImage(Utils::getDir(coverFile), Utils::getDir(destFile), Utils::getFile(coverFile), mpdCover+coverFile.mid(coverFile.length()-4), 0);
-        }
+bool ExtractJob::moveEncodedFile()
+{
+    if (QFile::exists(destFile)) {
+        QFile::remove(destFile);
+    }
+    if (QFile::rename(encodedFile, destFile)) {
+        return true;
+    }
+    // Temp folder might be on a different filesystem, so need to copy...
+    if (QFile::copy(encodedFile, destFile)) {
+        QFile::remove(encodedFile);
+        return true;
+    }
+    return false;
+}
 
-        emit result(Device::Ok);
+void ExtractJob::updateTagsAndCover()
+{
+    Utils::setFilePerms(destFile);
+    Tags::update(destFile, Song(), song, 3);
+
+    if (!stopRequested() && !coverFile.isEmpty()) {
+        QString mpdCover=MPDConnection::self()->getDetails().coverName;
+        if (mpdCover.isEmpty()) {
+            mpdCover=Covers::constFileName;
+        }
+        copiedCover=Covers::copyImage(Utils::getDir(coverFile), Utils::getDir(destFile), Utils::getFile(coverFile), mpdCover+coverFile.mid(coverFile.length()-4), 0);
     }
 }
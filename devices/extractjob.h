@@ -27,6 +27,48 @@
 
 #include "filejob.h"
 #include "encoders.h"
+#include <QList>
+#include <QMutex>
+#include <QWaitCondition>
+
+class Thread;
+class CdParanoia;
+
+// Reads tracks from the CD into WAV spool files, so that the drive can read at full speed whilst
+// previously read tracks are being encoded. At most 'maxAhead' spool files may exist at once,
+// each must be released (via release()) once it has been encoded.
+class CdRipper : public QObject
+{
+    Q_OBJECT
+public:
+    CdRipper(const QString &dev, const QList<Song> &t, int ahead);
+    virtual ~CdRipper();
+
+    void start();
+    void stop();
+    void release();
+    bool wasStopped(); // Reads the stop flag under the mutex, as stop() is called from the GUI thread
+
+Q_SIGNALS:
+    void ripped(const Song &track, const QString &wavFile, int status);
+    void percent(int track, int pc);
+
+private Q_SLOTS:
+    void rip();
+
+private:
+    int ripTrack(CdParanoia &cdparanoia, const Song &track, const QString &wavFile);
+
+private:
+    Thread *thread;
+    QString device;
+    QList<Song> tracks;
+    int maxAhead;
+    int spooled;
+    bool stopRequested;
+    QMutex mutex;
+    QWaitCondition cond;
+};
 
 class ExtractJob : public FileJob
 {
@@ -39,19 +81,24 @@ public:
     virtual ~ExtractJob();
 
     bool coverCopied() const { return copiedCover; }
+    // Track has already been ripped and encoded (into a temporary file) - so just move to destination and update tags
+    void setEncodedFile(const QString &f) { encodedFile=f; }
 
 private:
     void run();
+    bool moveEncodedFile();
+    void updateTagsAndCover();
 
 private:
     Encoders::Encoder encoder;
     int value;
     QString srcFile;
     QString destFile;
+    QString encodedFile;
     Song song;
     QString coverFile;
     bool copiedCover;
 };
 
 
-#endif //TRANSCODING_JOB_H
+#endif //EXTRACT_JOB_H
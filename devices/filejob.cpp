@@ -63,7 +63,7 @@ void FileThread::stop()
 }
 
 FileJob::FileJob()
-    : stopRequested(false)
+    : stopFlag(0)
     , progressPercent(0)
 {
     FileThread::self()->addJob(this);
@@ -106,6 +106,9 @@ QString CopyJob::updateTagsLocal()
             emit result(Device::FailedToUpdateTags);
             return QString();
         }
+        if (!coverSrcFile.isEmpty()) {
+            song.file=coverSrcFile;
+        }
         if ((copyOpts&OptsApplyVaFix || copyOpts&OptsUnApplyVaFix) && !Device::fixVariousArtists(temp->fileName(), song, copyOpts&OptsApplyVaFix)) {
             emit result(Device::FailedToUpdateTags);
             return QString();
@@ -120,11 +123,11 @@ QString CopyJob::updateTagsLocal()
 
 void CopyJob::updateTagsDest()
 {
-    if (!stopRequested && !(copyOpts&OptsFixLocal) && (copyOpts&OptsApplyVaFix || copyOpts&OptsUnApplyVaFix || Device::constEmbedCover==deviceOpts.coverName)) {
+    if (!stopRequested() && !(copyOpts&OptsFixLocal) && (copyOpts&OptsApplyVaFix || copyOpts&OptsUnApplyVaFix || Device::constEmbedCover==deviceOpts.coverName)) {
         if (copyOpts&OptsApplyVaFix || copyOpts&OptsUnApplyVaFix) {
             Device::fixVariousArtists(destFile, song, copyOpts&OptsApplyVaFix);
         }
-        if (!stopRequested && Device::constEmbedCover==deviceOpts.coverName) {
+        if (!stopRequested() && Device::constEmbedCover==deviceOpts.coverName) {
             Device::embedCover(destFile, song, deviceOpts.coverMaxSize);
         }
     }
@@ -132,7 +135,7 @@ void CopyJob::updateTagsDest()
 
 void CopyJob::copyCover(const QString &origSrcFile)
 {
-    if (!stopRequested && Device::constNoCover!=deviceOpts.coverName && Device::constEmbedCover!=deviceOpts.coverName) {
+    if (!stopRequested() && Device::constNoCover!=deviceOpts.coverName && Device::constEmbedCover!=deviceOpts.coverName) {
         song.file=destFile;
         copiedCover=Covers::copyCover(song, Utils::getDir(origSrcFile), Utils::getDir(destFile), deviceOpts.coverName, deviceOpts.coverMaxSize);
     }
@@ -140,13 +143,13 @@ void CopyJob::copyCover(const QString &origSrcFile)
 
 void CopyJob::run()
 {
-    QString origSrcFile(srcFile);
+    QString origSrcFile(coverSrcFile.isEmpty() ? srcFile : coverSrcFile);
     srcFile=updateTagsLocal();
     if (srcFile.isEmpty()) {
         return;
     }
 
-    if (stopRequested) {
+    if (stopRequested()) {
         emit result(Device::Cancelled);
         return;
     }
@@ -171,7 +174,7 @@ void CopyJob::run()
     qint64 adjustTotal = Device::constNoCover!=deviceOpts.coverName ? 16384 : 0;
 
     do {
-        if (stopRequested) {
+        if (stopRequested()) {
             emit result(Device::Cancelled);
             return;
         }
@@ -182,7 +185,7 @@ void CopyJob::run()
             return;
         }
 
-        if (stopRequested) {
+        if (stopRequested()) {
             emit result(Device::Cancelled);
             return;
         }
@@ -190,7 +193,7 @@ void CopyJob::run()
         qint64 writePos=0;
         do {
             qint64 bytesWritten = dest.write(&buffer[writePos], bytesRead - writePos);
-            if (stopRequested) {
+            if (stopRequested()) {
                 emit result(Device::Cancelled);
                 return;
             }
@@ -231,7 +234,7 @@ void CleanJob::run()
     int total=dirs.count();
     int current=0;
     foreach (const QString &d, dirs) {
-        if (stopRequested) {
+        if (stopRequested()) {
             emit result(Device::Cancelled);
             return;
         }
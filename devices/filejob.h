@@ -25,6 +25,7 @@
 #define FILE_JOB_H
 
 #include <QObject>
+#include <QAtomicInt>
 #include <QSet>
 #include "mpd-interface/song.h"
 #include "deviceoptions.h"
@@ -69,14 +70,22 @@ Q_SIGNALS:
     void result(int status);
 
 public:
-    virtual void stop() { stopRequested=true; }
+    // Called from the GUI thread, whilst run() is on the job's own thread.
+    virtual void stop() { stopFlag.fetchAndStoreOrdered(1); }
     virtual void start();
 
 protected Q_SLOTS:
     virtual void run()=0;
 
 protected:
-    bool stopRequested;
+    #if QT_VERSION >= 0x050000
+    bool stopRequested() const { return 0!=stopFlag.loadAcquire(); }
+    #else
+    bool stopRequested() const { return 0!=stopFlag; }
+    #endif
+
+protected:
+    QAtomicInt stopFlag;
     int progressPercent;
 };
 
@@ -105,6 +114,8 @@ public:
     virtual ~CopyJob();
 
     bool coverCopied() const { return copiedCover; }
+    // If srcFile is a temporary file (e.g. already transcoded), then covers need to be taken from the original location.
+    void setCoverSource(const QString &f) { coverSrcFile=f; }
 
 protected:
     QString updateTagsLocal();
@@ -117,6 +128,7 @@ private:
 protected:
     QString srcFile;
     QString destFile;
+    QString coverSrcFile;
     DeviceOptions deviceOpts;
     int copyOpts;
     Song song;
@@ -36,6 +36,7 @@
 #include "mpd-interface/mpdconnection.h"
 #include "encoders.h"
 #include "transcodingjob.h"
+#include "transcodingscheduler.h"
 #include "actiondialog.h"
 #include "support/localize.h"
 #include "gui/covers.h"
@@ -321,6 +322,8 @@ FsDevice::FsDevice(MusicModel *m, Solid::Device &dev)
     : Device(m, dev)
     , state(Idle)
     , scanned(false)
+    , waitingForTranscode(false)
+    , transcodeCopyCover(false)
     , cacheProgress(-1)
     , scanner(0)
 {
@@ -330,6 +333,8 @@ FsDevice::FsDevice(MusicModel *m, const QString &name, const QString &id)
     : Device(m, name, id)
     , state(Idle)
     , scanned(false)
+    , waitingForTranscode(false)
+    , transcodeCopyCover(false)
     , cacheProgress(-1)
     , scanner(0)
 {
@@ -420,6 +425,20 @@ void FsDevice::addSong(const Song &s, bool overwrite, bool copyCover)
         job->start();
     } else {
         transcoding=true;
+        TranscodingScheduler::State transcodeState=TranscodingScheduler::self()->state(s.file);
+        if (TranscodingScheduler::Pending==transcodeState || TranscodingScheduler::Running==transcodeState || TranscodingScheduler::Finished==transcodeState) {
+            transcodeCopyCover=copyCover;
+            if (TranscodingScheduler::Finished==transcodeState) {
+                copyTranscoded();
+            } else {
+                // Song is still being encoded by the scheduler, wait for it to finish...
+                waitingForTranscode=true;
+                connect(TranscodingScheduler::self(), SIGNAL(jobPercent(QString,int)), this, SLOT(transcodedPercent(QString,int)), Qt::UniqueConnection);
+                connect(TranscodingScheduler::self(), SIGNAL(jobFinished(QString,int)), this, SLOT(transcoded(QString,int)), Qt::UniqueConnection);
+                emit progress(TranscodingScheduler::self()->percent(s.file)*0.9);
+            }
+            return;
+        }
         TranscodingJob *job=new TranscodingJob(encoder, opts.transcoderValue, s.file, currentDestFile, copyCover ? opts : DeviceOptions(Device::constNoCover),
                                                (needToFixVa ? CopyJob::OptsApplyVaFix : CopyJob::OptsNone)|
                                                    (Device::RemoteFs==devType() ? CopyJob::OptsFixLocal : CopyJob::OptsNone),
@@ -430,6 +449,34 @@ void FsDevice::addSong(const Song &s, bool overwrite, bool copyCover)
     }
 }
 
+void FsDevice::queueSongs(const QList<Song> &songs, bool overwrite)
+{
+    if (!isConnected() || opts.transcoderCodec.isEmpty()) {
+        return;
+    }
+
+    Encoders::Encoder encoder=Encoders::getEncoder(opts.transcoderCodec);
+    if (encoder.codec.isEmpty()) {
+        return;
+    }
+
+    foreach (const Song &s, songs) {
+        if (opts.transcoderWhenDifferent && !encoder.isDifferent(s.file)) {
+            continue;
+        }
+        if (!overwrite) {
+            Song check=s;
+            if (opts.fixVariousArtists && s.isVariousArtists()) {
+                Device::fixVariousArtists(QString(), check, true);
+            }
+            if (songExists(check) || QFile::exists(encoder.changeExtension(audioFolder+opts.createFilename(s)))) {
+                continue;
+            }
+        }
+        TranscodingScheduler::self()->queue(encoder, opts.transcoderValue, s);
+    }
+}
+
 void FsDevice::copySongTo(const Song &s, const QString &musicPath, bool overwrite, bool copyCover)
 {
     jobAbortRequested=false;
@@ -546,6 +593,54 @@ void FsDevice::percent(int pc)
     emit progress(pc);
 }
 
+void FsDevice::transcodedPercent(const QString &src, int pc)
+{
+    if (!waitingForTranscode || src!=currentSong.file) {
+        return;
+    }
+    if (jobAbortRequested) {
+        waitingForTranscode=false;
+        TranscodingScheduler::self()->cancel(src);
+        return;
+    }
+    // Encoding is 90% of the work, copying to the device the remaining 10%
+    emit progress(pc*0.9);
+}
+
+void FsDevice::transcoded(const QString &src, int status)
+{
+    if (!waitingForTranscode || src!=currentSong.file) {
+        return;
+    }
+    waitingForTranscode=false;
+    if (jobAbortRequested) {
+        TranscodingScheduler::self()->release(src);
+        return;
+    }
+    if (Ok!=status) {
+        emit actionStatus(Cancelled==status ? Cancelled : TranscodeFailed);
+        return;
+    }
+    copyTranscoded();
+}
+
+void FsDevice::copyTranscodedPercent(int pc)
+{
+    percent(90+(pc/10));
+}
+
+void FsDevice::copyTranscoded()
+{
+    CopyJob *job=new CopyJob(TranscodingScheduler::self()->output(currentSong.file), currentDestFile,
+                             transcodeCopyCover ? opts : DeviceOptions(Device::constNoCover),
+                             (needToFixVa ? CopyJob::OptsApplyVaFix : CopyJob::OptsNone)|(Device::RemoteFs==devType() ? CopyJob::OptsFixLocal : CopyJob::OptsNone),
+                             currentSong);
+    job->setCoverSource(currentSong.file);
+    connect(job, SIGNAL(result(int)), SLOT(addSongResult(int)));
+    connect(job, SIGNAL(percent(int)), SLOT(copyTranscodedPercent(int)));
+    job->start();
+}
+
 void FsDevice::addSongResult(int status)
 {
     CopyJob *job=qobject_cast<CopyJob *>(sender());
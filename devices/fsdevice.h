@@ -120,6 +120,7 @@ public:
     QString path() const { return audioFolder; }
     QString coverFile() const { return opts.coverName; }
     void addSong(const Song &s, bool overwrite, bool copyCover);
+    void queueSongs(const QList<Song> &songs, bool overwrite);
     void copySongTo(const Song &s, const QString &musicPath, bool overwrite, bool copyCover);
     void removeSong(const Song &s);
     void cleanDirs(const QSet<QString> &dirs);
@@ -146,6 +147,9 @@ protected Q_SLOTS:
     void savedCache();
     void libraryUpdated(MusicLibraryItemRoot *lib);
     void percent(int pc);
+    void transcodedPercent(const QString &src, int pc);
+    void transcoded(const QString &src, int status);
+    void copyTranscodedPercent(int pc);
     void addSongResult(int status);
     void copySongToResult(int status);
     void removeSongResult(int status);
@@ -155,10 +159,13 @@ protected Q_SLOTS:
 
 private:
     void cacheStatus(const QString &msg, int prog);
+    void copyTranscoded();
 
 protected:
     State state;
     bool scanned;
+    bool waitingForTranscode;
+    bool transcodeCopyCover;
     int cacheProgress;
     MusicScanner *scanner;
     mutable QString audioFolder;
@@ -45,7 +45,7 @@ void TranscodingJob::run()
         return;
     }
 
-    if (stopRequested) {
+    if (stopRequested()) {
         emit result(Device::Cancelled);
     } else {
         QStringList parameters=encoder.params(value, src, destFile);
@@ -61,6 +61,8 @@ void TranscodingJob::run()
 
 void TranscodingJob::stop()
 {
+    // Job may be stopped before run() has been called - so ensure process is not started...
+    stopFlag.fetchAndStoreOrdered(1);
     if (process) {
         process->close();
         process->deleteLater();
@@ -75,7 +77,7 @@ void TranscodingJob::finished(int exitCode, QProcess::ExitStatus exitStatus)
     if (!process) {
         return;
     }
-    if (stopRequested) {
+    if (stopRequested()) {
         emit result(Device::Cancelled);
         return;
     }
@@ -88,7 +90,7 @@ void TranscodingJob::finished(int exitCode, QProcess::ExitStatus exitStatus)
 
 void TranscodingJob::processOutput()
 {
-    if (stopRequested) {
+    if (stopRequested()) {
         emit result(Device::Cancelled);
         return;
     }
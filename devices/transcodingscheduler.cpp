@@ -0,0 +1,287 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2014 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "transcodingscheduler.h"
+#include "transcodingjob.h"
+#include "device.h"
+#include "gui/settings.h"
+#include "support/globalstatic.h"
+#include <QThread>
+#include <QTemporaryFile>
+#include <QFile>
+#include <QDir>
+#include <QDebug>
+
+static bool debugIsEnabled=false;
+#define DBUG if (debugIsEnabled) qWarning() << metaObject()->className() << __FUNCTION__
+void TranscodingScheduler::enableDebug()
+{
+    debugIsEnabled=true;
+}
+
+static const int constMaxJobs=8;
+// Maximum number of transcoded files, per running job, that may be waiting to be copied. If the
+// destination is slower than the encoders, we stop starting new jobs - so that the temp folder
+// does not fill up with files the device cannot accept yet.
+static const int constMaxWaitingPerJob=2;
+
+GLOBAL_STATIC(TranscodingScheduler, instance)
+
+static QString tempFileName(const Encoders::Encoder &enc)
+{
+    QTemporaryFile temp(QDir::tempPath()+"/cantata_XXXXXX"+enc.extension);
+    temp.setAutoRemove(false);
+    if (!temp.open()) {
+        return QString();
+    }
+    QString name=temp.fileName();
+    temp.close();
+    return name;
+}
+
+TranscodingScheduler::TranscodingScheduler()
+    : runningCount(0)
+    , finishedCount(0)
+    , doneTime(0)
+{
+    int jobCount=Settings::self()->maxTranscodeJobs();
+    if (jobCount<1) {
+        jobCount=QThread::idealThreadCount();
+    }
+    maxRunning=qMax(1, qMin(jobCount, constMaxJobs));
+    maxWaiting=maxRunning*constMaxWaitingPerJob;
+    DBUG << maxRunning;
+}
+
+TranscodingScheduler::~TranscodingScheduler()
+{
+    clear();
+}
+
+void TranscodingScheduler::queue(const Encoders::Encoder &enc, int value, const Song &s, const QString &dest)
+{
+    if (jobs.contains(s.file)) {
+        return;
+    }
+
+    Job j;
+    j.encoder=enc;
+    j.value=value;
+    j.song=s;
+    j.tempOutput=dest.isEmpty();
+    // Temporary output files are only created when the job starts - so that queueing a large
+    // number of songs does not fill the temp folder with empty files.
+    j.output=dest;
+    if (jobs.isEmpty()) {
+        timer.start();
+        doneTime=0;
+    }
+    DBUG << s.file << j.output;
+    jobs.insert(s.file, j);
+    pendingFiles.append(s.file);
+    startJobs();
+}
+
+TranscodingScheduler::State TranscodingScheduler::state(const QString &src) const
+{
+    QMap<QString, Job>::ConstIterator it=jobs.find(src);
+    return it==jobs.constEnd() ? NotQueued : it.value().state;
+}
+
+QString TranscodingScheduler::output(const QString &src) const
+{
+    QMap<QString, Job>::ConstIterator it=jobs.find(src);
+    return it==jobs.constEnd() ? QString() : it.value().output;
+}
+
+int TranscodingScheduler::percent(const QString &src) const
+{
+    QMap<QString, Job>::ConstIterator it=jobs.find(src);
+    return it==jobs.constEnd() ? 0 : it.value().pc;
+}
+
+void TranscodingScheduler::release(const QString &src)
+{
+    QMap<QString, Job>::Iterator it=jobs.find(src);
+    if (it==jobs.end()) {
+        return;
+    }
+
+    DBUG << src;
+    stopJob(it.value());
+    if (Finished==it.value().state || Failed==it.value().state) {
+        finishedCount--;
+    }
+    if (it.value().tempOutput && !it.value().output.isEmpty()) {
+        QFile::remove(it.value().output);
+    }
+    pendingFiles.removeAll(src);
+    jobs.erase(it);
+    startJobs();
+}
+
+void TranscodingScheduler::cancel(const QString &src)
+{
+    QMap<QString, Job>::Iterator it=jobs.find(src);
+    if (it!=jobs.end() && Running==it.value().state) {
+        // Remove temp output for cancelled jobs, even if caller specified destination - its incomplete!
+        it.value().tempOutput=true;
+    }
+    release(src);
+}
+
+void TranscodingScheduler::clear()
+{
+    DBUG << jobs.count();
+    QMap<QString, Job>::Iterator it=jobs.begin();
+    QMap<QString, Job>::Iterator end=jobs.end();
+    for (; it!=end; ++it) {
+        bool wasRunning=Running==it.value().state;
+        stopJob(it.value());
+        if ((it.value().tempOutput || wasRunning) && !it.value().output.isEmpty()) {
+            QFile::remove(it.value().output);
+        }
+    }
+    jobs.clear();
+    pendingFiles.clear();
+    runningCount=0;
+    finishedCount=0;
+    doneTime=0;
+}
+
+int TranscodingScheduler::timeRemaining() const
+{
+    if (jobs.isEmpty() || !timer.isValid()) {
+        return -1;
+    }
+
+    quint64 total=doneTime;
+    double done=doneTime;
+    QMap<QString, Job>::ConstIterator it=jobs.constBegin();
+    QMap<QString, Job>::ConstIterator end=jobs.constEnd();
+    for (; it!=end; ++it) {
+        if (Finished!=it.value().state && Failed!=it.value().state) {
+            total+=it.value().song.time;
+            if (Running==it.value().state) {
+                done+=it.value().song.time*(it.value().pc/100.0);
+            }
+        }
+    }
+
+    qint64 taken=timer.elapsed();
+    // Wait for at least 5 seconds, so that estimate is not too erratic...
+    if (total<=0 || done<=0.0 || taken<5000) {
+        return -1;
+    }
+    double rate=done/(taken/1000.0); // Song seconds transcoded per wall-clock second
+    return (int)(((total-done)/rate)+0.5);
+}
+
+void TranscodingScheduler::percentChanged(int pc)
+{
+    QString src=sourceOf(sender());
+    if (src.isEmpty()) {
+        return;
+    }
+    Job &j=jobs[src];
+    if (pc!=j.pc) {
+        j.pc=pc;
+        emit jobPercent(src, pc);
+    }
+}
+
+void TranscodingScheduler::result(int status)
+{
+    FileJob::finished(sender());
+    QString src=sourceOf(sender());
+    if (src.isEmpty()) {
+        return;
+    }
+
+    Job &j=jobs[src];
+    DBUG << src << status;
+    j.job=0;
+    j.state=Device::Ok==status ? Finished : Failed;
+    j.pc=100;
+    doneTime+=j.song.time;
+    runningCount--;
+    finishedCount++;
+    if (Failed==j.state) {
+        QFile::remove(j.output);
+    }
+    emit jobFinished(src, status);
+    startJobs();
+}
+
+void TranscodingScheduler::startJobs()
+{
+    while (runningCount<maxRunning && finishedCount<maxWaiting && !pendingFiles.isEmpty()) {
+        QString src=pendingFiles.takeFirst();
+        Job &j=jobs[src];
+        if (j.output.isEmpty()) {
+            j.output=tempFileName(j.encoder);
+            if (j.output.isEmpty()) {
+                DBUG << src << "failed to create temp file";
+                j.state=Failed;
+                j.pc=100;
+                doneTime+=j.song.time;
+                finishedCount++;
+                emit jobFinished(src, Device::FailedToCreateTempFile);
+                continue;
+            }
+        }
+        DBUG << src << j.output;
+        TranscodingJob *job=new TranscodingJob(j.encoder, j.value, src, j.output, DeviceOptions(Device::constNoCover), CopyJob::OptsNone, j.song);
+        connect(job, SIGNAL(result(int)), SLOT(result(int)));
+        connect(job, SIGNAL(percent(int)), SLOT(percentChanged(int)));
+        j.job=job;
+        j.state=Running;
+        runningCount++;
+        job->start();
+    }
+}
+
+QString TranscodingScheduler::sourceOf(QObject *job) const
+{
+    if (job) {
+        QMap<QString, Job>::ConstIterator it=jobs.constBegin();
+        QMap<QString, Job>::ConstIterator end=jobs.constEnd();
+        for (; it!=end; ++it) {
+            if (it.value().job==job) {
+                return it.key();
+            }
+        }
+    }
+    return QString();
+}
+
+void TranscodingScheduler::stopJob(Job &j)
+{
+    if (j.job) {
+        disconnect(j.job, 0, this, 0);
+        j.job->stop();
+        FileJob::finished(j.job);
+        j.job=0;
+        runningCount--;
+    }
+}
@@ -0,0 +1,110 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2014 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef TRANSCODING_SCHEDULER_H
+#define TRANSCODING_SCHEDULER_H
+
+#include <QObject>
+#include <QMap>
+#include <QStringList>
+#include <QElapsedTimer>
+#include "encoders.h"
+#include "mpd-interface/song.h"
+
+class FileJob;
+
+// Runs several encoder processes at once. Each queued source file is transcoded into a local
+// temporary file, which the device can then copy (and tag) whilst other files are still being
+// encoded. Jobs are started in the order they were queued.
+class TranscodingScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum State {
+        NotQueued,
+        Pending,
+        Running,
+        Finished,
+        Failed
+    };
+
+    static void enableDebug();
+    static TranscodingScheduler * self();
+
+    TranscodingScheduler();
+    virtual ~TranscodingScheduler();
+
+    int maxJobs() const { return maxRunning; }
+    void queue(const Encoders::Encoder &enc, int value, const Song &s, const QString &dest=QString());
+    State state(const QString &src) const;
+    QString output(const QString &src) const;
+    int percent(const QString &src) const;
+    int running() const { return runningCount; }
+    int pending() const { return pendingFiles.count(); }
+    bool isActive() const { return !jobs.isEmpty(); }
+    // Called once the output has been used - removes the entry, and its temporary file (unless an
+    // explicit destination was passed to queue())
+    void release(const QString &src);
+    void cancel(const QString &src);
+    void clear();
+    // Estimated number of seconds until all queued files have been transcoded, or -1 if unknown
+    int timeRemaining() const;
+
+Q_SIGNALS:
+    void jobPercent(const QString &src, int pc);
+    void jobFinished(const QString &src, int status);
+
+private Q_SLOTS:
+    void percentChanged(int pc);
+    void result(int status);
+
+private:
+    struct Job {
+        Job() : value(0), state(Pending), pc(0), tempOutput(true), job(0) { }
+        Encoders::Encoder encoder;
+        int value;
+        Song song;
+        QString output;
+        State state;
+        int pc;
+        bool tempOutput;
+        FileJob *job;
+    };
+
+    void startJobs();
+    QString sourceOf(QObject *job) const;
+    void stopJob(Job &j);
+
+private:
+    int maxRunning;
+    int maxWaiting;
+    int runningCount;
+    int finishedCount;
+    QMap<QString, Job> jobs;
+    QStringList pendingFiles;
+    QElapsedTimer timer;
+    quint64 doneTime; // Duration of songs that have finished transcoding
+};
+
+#endif
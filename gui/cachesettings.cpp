@@ -27,6 +27,7 @@
 #include "context/albumview.h"
 #include "context/songview.h"
 #include "context/contextwidget.h"
+#include "context/contentcache.h"
 #include "context/wikipediasettings.h"
 #include "covers.h"
 #include "models/musiclibrarymodel.h"
@@ -44,6 +45,7 @@
 #endif
 #include "support/squeezedtextlabel.h"
 #include "scrobbling/scrobbler.h"
+#include "network/networkcache.h"
 #include <QLabel>
 #include <QPushButton>
 #include <QStyle>
@@ -132,6 +134,7 @@ void CacheItemCounter::deleteAll()
 CacheItem::CacheItem(const QString &title, const QString &d, const QStringList &t, QTreeWidget *p, Type ty)
     : QTreeWidgetItem(p, QStringList() << title)
     , counter(new CacheItemCounter(title, d, t))
+    , dir(d)
     , empty(true)
     , usedSpace(0)
     , type(ty)
@@ -177,6 +180,8 @@ void CacheItem::clean()
     switch (type) {
     case Type_Covers:       Covers::self()->clearNameCache(); break;
     case Type_ScaledCovers: Covers::self()->clearScaleCache(); break;
+    case Type_Context:      ContentCache::self()->removeAll(dir); break;
+    case Type_Network:      NetworkCache::clearAll(); break;
     default: break;
     }
 }
@@ -271,12 +276,17 @@ CacheSettings::CacheSettings(QWidget *parent)
                   CacheItem::Type_Covers);
     new CacheItem(i18n("Scaled Covers"), Utils::cacheDir(Covers::constScaledCoverDir, false), QStringList() << "*.jpg" << "*.png", tree,
                   CacheItem::Type_ScaledCovers);
-    new CacheItem(i18n("Backdrops"), Utils::cacheDir(ContextWidget::constCacheDir, false), QStringList() << "*.jpg" << "*.png", tree);
-    new CacheItem(i18n("Lyrics"), Utils::cacheDir(SongView::constLyricsDir, false), QStringList() << "*"+SongView::constExtension, tree);
+    new CacheItem(i18n("Backdrops"), Utils::cacheDir(ContextWidget::constCacheDir, false), QStringList() << "*.jpg" << "*.png", tree,
+                  CacheItem::Type_Context);
+    new CacheItem(i18n("Lyrics"), Utils::cacheDir(SongView::constLyricsDir, false), QStringList() << "*"+SongView::constExtension, tree,
+                  CacheItem::Type_Context);
     new CacheItem(i18n("Artist Information"), Utils::cacheDir(ArtistView::constCacheDir, false), QStringList() << "*"+ArtistView::constInfoExt
-                  << "*"+ArtistView::constSimilarInfoExt << "*.json.gz" << "*.jpg" << "*.png", tree);
-    new CacheItem(i18n("Album Information"), Utils::cacheDir(AlbumView::constCacheDir, false), QStringList() << "*"+AlbumView::constInfoExt << "*.jpg" << "*.png", tree);
-    new CacheItem(i18n("Track Information"), Utils::cacheDir(SongView::constCacheDir, false), QStringList() << "*"+AlbumView::constInfoExt, tree);
+                  << "*"+ArtistView::constSimilarInfoExt << "*.json.gz" << "*.jpg" << "*.png", tree,
+                  CacheItem::Type_Context);
+    new CacheItem(i18n("Album Information"), Utils::cacheDir(AlbumView::constCacheDir, false), QStringList() << "*"+AlbumView::constInfoExt << "*.jpg" << "*.png", tree,
+                  CacheItem::Type_Context);
+    new CacheItem(i18n("Track Information"), Utils::cacheDir(SongView::constCacheDir, false), QStringList() << "*"+AlbumView::constInfoExt, tree,
+                  CacheItem::Type_Context);
     #ifdef ENABLE_STREAMS
     new CacheItem(i18n("Stream Listings"), Utils::cacheDir(StreamsModel::constSubDir, false), QStringList() << "*"+StreamsModel::constCacheExt, tree);
     #endif
@@ -286,7 +296,9 @@ CacheSettings::CacheSettings(QWidget *parent)
     new CacheItem(i18n("Podcast Directories"), Utils::cacheDir(PodcastSearchDialog::constCacheDir, false), QStringList() << "*"+PodcastSearchDialog::constExt, tree);
     #endif
     new CacheItem(i18n("Wikipedia Languages"), Utils::cacheDir(WikipediaSettings::constSubDir, false), QStringList() << "*.xml.gz", tree);
-    new CacheItem(i18n("Scrobble Tracks"), Utils::cacheDir(Scrobbler::constCacheDir, false), QStringList() << "*.xml.gz", tree);
+    new CacheItem(i18n("Scrobble Tracks"), Utils::cacheDir(Scrobbler::constCacheDir, false), QStringList() << "*.xml.gz" << "*.journal", tree);
+    new CacheItem(i18n("Network Responses"), Utils::cacheDir(NetworkCache::constCacheDir, false), QStringList() << "*.d", tree,
+                  CacheItem::Type_Network);
 
     for (int i=0; i<tree->topLevelItemCount(); ++i) {
         connect(static_cast<CacheItem *>(tree->topLevelItem(i)), SIGNAL(updated()), this, SLOT(updateSpace()));
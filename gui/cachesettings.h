@@ -62,6 +62,8 @@ public:
     enum Type {
         Type_Covers,
         Type_ScaledCovers,
+        Type_Context,
+        Type_Network,
         Type_Other
     };
 
@@ -88,6 +90,7 @@ private:
 
 private:
     CacheItemCounter *counter;
+    QString dir;
     bool empty;
     quint64 usedSpace;
     Type type;
@@ -571,6 +571,19 @@ const QStringList & Covers::standardNames()
     return *coverFileNames;
 }
 
+// Identifies the cover, artist image, or composer image, that a job is for - so that we do not
+// download the same image more than once at a time.
+static QString jobKey(const Song &song)
+{
+    if (song.isComposerImageRequest()) {
+        return QLatin1String("composer:")+song.composer();
+    }
+    if (song.isArtistImageRequest()) {
+        return QLatin1String("artist:")+song.albumArtist();
+    }
+    return QLatin1String("album:")+song.albumArtist()+QLatin1Char('\n')+song.album;
+}
+
 CoverDownloader::CoverDownloader()
     : manager(0)
 {
@@ -601,7 +614,7 @@ void CoverDownloader::download(const Song &song)
         DBUG << "Online image url" << imageUrl;
         if (!imageUrl.isEmpty()) {
             NetworkJob *j=network()->get(imageUrl);
-            jobs.insert(j, job);
+            addJob(j, job);
             connect(j, SIGNAL(finished()), this, SLOT(onlineJobFinished()));
         } else {
             failed(job);
@@ -610,7 +623,7 @@ void CoverDownloader::download(const Song &song)
     }
     #endif
 
-    if (jobs.end()!=findJob(Job(song, QString()))) {
+    if (jobKeys.contains(jobKey(song))) {
         return;
     }
 
@@ -666,7 +679,7 @@ bool CoverDownloader::downloadViaHttp(Job &job, JobType type)
     job.type=type;
     NetworkJob *j=network()->get(u);
     connect(j, SIGNAL(finished()), this, SLOT(jobFinished()));
-    jobs.insert(j, job);
+    addJob(j, job);
     DBUG << u.toString();
     return true;
 }
@@ -694,7 +707,7 @@ void CoverDownloader::downloadViaLastFm(Job &job)
     NetworkJob *j = network()->get(url);
     connect(j, SIGNAL(finished()), this, SLOT(lastFmCallFinished()));
     job.type=JobLastFm;
-    jobs.insert(j, job);
+    addJob(j, job);
     DBUG << url.toString();
 }
 
@@ -711,8 +724,7 @@ void CoverDownloader::lastFmCallFinished()
     QHash<NetworkJob *, Job>::Iterator end(jobs.end());
 
     if (it!=end) {
-        Job job=it.value();
-        jobs.erase(it);
+        Job job=takeJob(it);
         QString url;
 
         if(reply->ok()) {
@@ -758,7 +770,7 @@ void CoverDownloader::lastFmCallFinished()
             NetworkJob *j=network()->get(QNetworkRequest(u));
             connect(j, SIGNAL(finished()), this, SLOT(jobFinished()));
             DBUG << "download" << u.toString();
-            jobs.insert(j, job);
+            addJob(j, job);
         } else {
             failed(job);
         }
@@ -782,13 +794,12 @@ void CoverDownloader::jobFinished()
         QByteArray data=reply->ok() ? reply->readAll() : QByteArray();
         Covers::Image img;
         img.img= data.isEmpty() ? QImage() : QImage::fromData(data, Covers::imageFormat(data));
-        Job job=it.value();
+        Job job=takeJob(it);
 
         if (!img.img.isNull() && img.img.size().width()<32) {
             img.img = QImage();
         }
 
-        jobs.remove(it.key());
         if (img.img.isNull() && JobLastFm!=job.type) {
             if (JobHttpJpg==job.type) {
                 if (!job.level || !downloadViaHttp(job, JobHttpJpg)) {
@@ -843,13 +854,13 @@ void CoverDownloader::onlineJobFinished()
     QHash<NetworkJob *, Job>::Iterator end(jobs.end());
 
     if (it!=end) {
+        Job job=takeJob(it);
         QByteArray data=QNetworkReply::NoError==reply->error() ? reply->readAll() : QByteArray();
         if (data.isEmpty()) {
             DBUG << reply->url().toString() << "empty!";
             return;
         }
 
-        Job job=it.value();
         const Song &song=job.song;
         QString id=song.onlineService();
         QString fileName;
@@ -956,29 +967,21 @@ QString CoverDownloader::saveImg(const Job &job, const QImage &img, const QByteA
     return QString();
 }
 
-QHash<NetworkJob *, CoverDownloader::Job>::Iterator CoverDownloader::findJob(const Job &job)
+void CoverDownloader::addJob(NetworkJob *j, const Job &job)
 {
-    QHash<NetworkJob *, Job>::Iterator it(jobs.begin());
-    QHash<NetworkJob *, Job>::Iterator end(jobs.end());
-    bool isComposer=job.song.isComposerImageRequest();
-    bool isArtist=job.song.isArtistImageRequest();
-    bool isCover=!isComposer && !isArtist;
-
-    for (; it!=end; ++it) {
-        if ((*it).song.isComposerImageRequest()) {
-            if (isComposer && (*it).song.composer()==job.song.composer()) {
-                return it;
-            }
-        } else if ((*it).song.isArtistImageRequest()) {
-            if (isArtist && (*it).song.albumArtist()==job.song.albumArtist()) {
-                return it;
-            }
-        } else if (isCover && (*it).song.albumArtist()==job.song.albumArtist() && (*it).song.album==job.song.album) {
-            return it;
-        }
-    }
+    jobs.insert(j, job);
+    jobKeys[jobKey(job.song)]++;
+}
 
-    return end;
+CoverDownloader::Job CoverDownloader::takeJob(QHash<NetworkJob *, Job>::Iterator it)
+{
+    Job job=it.value();
+    jobs.erase(it);
+    QHash<QString, int>::Iterator k=jobKeys.find(jobKey(job.song));
+    if (k!=jobKeys.end() && --k.value()<=0) {
+        jobKeys.erase(k);
+    }
+    return job;
 }
 
 NetworkAccessManager * CoverDownloader::network()
@@ -1018,6 +1021,24 @@ void CoverLocator::locate(const Song &s)
     startTimer(0);
 }
 
+static inline bool sameRequest(const Song &a, const Song &b)
+{
+    return a.size==b.size && cacheKey(a, a.size)==cacheKey(b, b.size);
+}
+
+void CoverLocator::cancel(const Song &s)
+{
+    QList<Song>::Iterator it=queue.begin();
+    while (it!=queue.end()) {
+        if (sameRequest(*it, s)) {
+            DBUG << s.artist << s.albumId() << s.size;
+            it=queue.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
 // To improve responsiveness of views, we only process a max of X images per even loop iteration.
 // If more images are asked for, we place these into a list, and get them on the next iteration
 // of the loop. This way things appear smoother.
@@ -1077,6 +1098,19 @@ void CoverLoader::load(const Song &song)
     startTimer(0);
 }
 
+void CoverLoader::cancel(const Song &song)
+{
+    QList<LoadedCover>::Iterator it=queue.begin();
+    while (it!=queue.end()) {
+        if (sameRequest((*it).song, song)) {
+            DBUG << song.artist << song.albumId() << song.size;
+            it=queue.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
 void CoverLoader::load()
 {
     QList<LoadedCover> toDo;
@@ -1343,10 +1377,12 @@ QPixmap * Covers::get(const Song &song, int size, bool urgent)
                     return pix;
                 }
             }
+            Song request=setSizeRequest(song, origSize);
+            queuedRequests.insert(cacheKey(request, origSize));
             if (cacheScaledCovers) {
-                tryToLoad(setSizeRequest(song, origSize));
+                tryToLoad(request);
             } else {
-                tryToLocate(setSizeRequest(song, origSize));
+                tryToLocate(request);
             }
 
             // Create a dummy image so that we dont keep on locating/loading/downloading files that do not exist!
@@ -1368,6 +1404,38 @@ QPixmap * Covers::get(const Song &song, int size, bool urgent)
     return defaultPix(song, size, origSize);
 }
 
+void Covers::cancel(const Song &song, int size)
+{
+    if (0==size) {
+        size=22;
+    }
+
+    Song request=setSizeRequest(song, size);
+    if (!queuedRequests.remove(cacheKey(request, size))) {
+        return;
+    }
+
+    int origSize=size;
+    #if QT_VERSION >= 0x050100
+    if (size<constRetinaScaleMaxSize) {
+        size*=devicePixelRatio;
+    }
+    #endif
+    DBUG << song.albumArtist() << song.album << origSize;
+    // Remove dummy entry, so that cover is requested again when item is next drawn...
+    QString key=cacheKey(song, size);
+    QPixmap *pix=cache.object(key);
+    if (pix && pix->width()<2) {
+        cache.remove(key);
+    }
+    if (loader) {
+        emit cancelLoad(request);
+    }
+    if (locator) {
+        emit cancelLocate(request);
+    }
+}
+
 void Covers::coverDownloaded(const Song &song, const QImage &img, const QString &file)
 {
     gotAlbumCover(song, img, file);
@@ -1440,6 +1508,7 @@ void Covers::tryToLocate(const Song &song)
         locator=new CoverLocator();
         connect(locator, SIGNAL(located(QList<LocatedCover>)), this, SLOT(located(QList<LocatedCover>)), Qt::QueuedConnection);
         connect(this, SIGNAL(locate(Song)), locator, SLOT(locate(Song)), Qt::QueuedConnection);
+        connect(this, SIGNAL(cancelLocate(Song)), locator, SLOT(cancel(Song)), Qt::QueuedConnection);
     }
     emit locate(song);
 }
@@ -1468,6 +1537,7 @@ void Covers::tryToLoad(const Song &song)
         loader=new CoverLoader();
         connect(loader, SIGNAL(loaded(QList<LoadedCover>)), this, SLOT(loaded(QList<LoadedCover>)), Qt::QueuedConnection);
         connect(this, SIGNAL(load(Song)), loader, SLOT(load(Song)), Qt::QueuedConnection);
+        connect(this, SIGNAL(cancelLoad(Song)), loader, SLOT(cancel(Song)), Qt::QueuedConnection);
     }
     emit load(song);
 }
@@ -1809,6 +1879,7 @@ Covers::Image Covers::requestImage(const Song &song, bool urgent)
 void Covers::located(const QList<LocatedCover> &covers)
 {
     foreach (const LocatedCover &cvr, covers) {
+        queuedRequests.remove(cacheKey(cvr.song, cvr.song.size));
         if (!cvr.img.isNull()) {
             if (cvr.song.isArtistImageRequest()) {
                 gotArtistImage(cvr.song, cvr.img, cvr.fileName);
@@ -1827,6 +1898,7 @@ void Covers::loaded(const QList<LoadedCover> &covers)
 {
     foreach (const LoadedCover &cvr, covers) {
         if (!cvr.img.isNull()) {
+            queuedRequests.remove(cacheKey(cvr.song, cvr.song.size));
             int size=cvr.song.size;
             #if QT_VERSION >= 0x050100
             int origSize=size;
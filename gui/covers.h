@@ -92,11 +92,13 @@ private Q_SLOTS:
 private:
     void failed(const Job &job);
     QString saveImg(const Job &job, const QImage &img, const QByteArray &raw);
-    QHash<NetworkJob *, Job>::Iterator findJob(const Job &job);
+    void addJob(NetworkJob *j, const Job &job);
+    Job takeJob(QHash<NetworkJob *, Job>::Iterator it);
     NetworkAccessManager * network();
 
 private:
     QHash<NetworkJob *, Job> jobs;
+    QHash<QString, int> jobKeys; // Number of entries in jobs for each cover/artist/composer
 
 private:
     Thread *thread;
@@ -127,6 +129,7 @@ Q_SIGNALS:
 public Q_SLOTS:
     void locate(const Song &s);
     void locate();
+    void cancel(const Song &s);
 
 private:
     void startTimer(int interval);
@@ -160,6 +163,7 @@ Q_SIGNALS:
 public Q_SLOTS:
     void load(const Song &song);
     void load();
+    void cancel(const Song &song);
 
 private:
     void startTimer(int interval);
@@ -228,6 +232,9 @@ public:
     // Get cover image of specified size. If this is not found 0 will be returned, and the cover
     // will be downloaded.
     QPixmap * get(const Song &song, int size, bool urgent=false);
+    // Cancel a request made via get() that is still waiting to be loaded, or located. Used by views
+    // to drop requests for items that have been scrolled out of view.
+    void cancel(const Song &song, int size);
     // Get QImage and filename associated with Song request. If this is not found, then the cover
     // will NOT be downloaded. 'emitResult' controls whether 'cover()/artistImage()' is emitted if
     // a cover is found.
@@ -248,6 +255,8 @@ Q_SIGNALS:
     void download(const Song &s);
     void locate(const Song &s);
     void load(const Song &song);
+    void cancelLocate(const Song &s);
+    void cancelLoad(const Song &song);
     void loaded(const Song &song, int s);
     void cover(const Song &song, const QImage &img, const QString &file);
     void coverUpdated(const Song &song, const QImage &img, const QString &file);
@@ -278,6 +287,7 @@ private:
     QSet<QString> currentImageRequests;
     QList<Song> queue;
     QSet<int> cacheSizes;
+    QSet<QString> queuedRequests; // Keys of get() requests still in locator/loader queues
     QCache<QString, QPixmap> cache;
     QMap<QString, QString> filenames;
     CoverDownloader *downloader;
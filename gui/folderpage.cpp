@@ -103,7 +103,7 @@ void FolderPage::refresh()
     if (DirViewModel::self()->isEnabled()) {
         if (!isVisible()) {
             loaded=false; // Refresh called for, but we are not currently visible...
-        } else if (!DirViewModel::self()->fromXML()) {
+        } else if (!DirViewModel::self()->load()) {
             emit loadFolders();
             loaded=true;
         }
@@ -121,7 +121,7 @@ void FolderPage::showEvent(QShowEvent *e)
     view->focusView();
     QWidget::showEvent(e);
     if (!loaded) {
-        if (!DirViewModel::self()->fromXML()) {
+        if (!DirViewModel::self()->load()) {
             emit loadFolders();
         }
         loaded=true;
@@ -45,26 +45,34 @@
 // To enable debug...
 #include "mpd-interface/mpdconnection.h"
 #include "mpd-interface/mpdparseutils.h"
+#include "models/cachewriter.h"
+#include "mpd-interface/cuecache.h"
 #include "covers.h"
 #include "context/wikipediaengine.h"
 #include "context/lastfmengine.h"
 #include "context/metaengine.h"
 #include "context/backdropcreator.h"
+#include "context/backdropscaler.h"
 #ifdef ENABLE_DYNAMIC
 #include "dynamic/dynamic.h"
 #endif
 #ifdef ENABLE_DEVICES_SUPPORT
 #include "models/devicesmodel.h"
+#include "devices/transcodingscheduler.h"
 #endif
 #include "streams/streamfetcher.h"
 #include "http/httpserver.h"
 #include "widgets/songdialog.h"
 #include "network/networkaccessmanager.h"
+#include "network/networkcache.h"
 #include "context/ultimatelyricsprovider.h"
+#include "context/ultimatelyrics.h"
 #ifdef ENABLE_EXTERNAL_TAGS
 #include "tags/taghelperiface.h"
 #endif
 #include "context/contextwidget.h"
+#include "context/contextprefetcher.h"
+#include "context/contentcache.h"
 #include "scrobbling/scrobbler.h"
 #ifndef ENABLE_KDE_SUPPORT
 #include "gui/mediakeys.h"
@@ -189,6 +197,8 @@ static void installDebugMessageHandler()
         }
         if (dbg&Dbg_MpdParse) {
             MPDParseUtils::enableDebug();
+            CacheWriter::enableDebug();
+            CueCache::enableDebug();
         }
         if (dbg&Dbg_Covers) {
             Covers::enableDebug();
@@ -204,9 +214,12 @@ static void installDebugMessageHandler()
         }
         if (dbg&Dbg_Context_Widget) {
             ContextWidget::enableDebug();
+            ContextPrefetcher::enableDebug();
+            ContentCache::enableDebug();
         }
         if (dbg&Dbg_Context_Backdrop) {
             BackdropCreator::enableDebug();
+            BackdropScaler::enableDebug();
         }
         #ifdef ENABLE_DYNAMIC
         if (dbg&Dbg_Dynamic) {
@@ -224,9 +237,11 @@ static void installDebugMessageHandler()
         }
         if (dbg&Dbg_NetworkAccess) {
             NetworkAccessManager::enableDebug();
+            NetworkCache::enableDebug();
         }
         if (dbg&Dbg_Context_Lyrics) {
             UltimateLyricsProvider::enableDebug();
+            UltimateLyrics::enableDebug();
         }
         if (dbg&Dbg_Threads) {
             ThreadCleaner::enableDebug();
@@ -242,6 +257,7 @@ static void installDebugMessageHandler()
         #ifdef ENABLE_DEVICES_SUPPORT
         if (dbg&Dbg_Devices) {
             DevicesModel::enableDebug();
+            TranscodingScheduler::enableDebug();
         }
         #endif
         #ifndef ENABLE_KDE_SUPPORT
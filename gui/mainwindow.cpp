@@ -46,6 +46,8 @@
 #include "models/musiclibrarymodel.h"
 #include "models/musiclibraryitemartist.h"
 #include "models/musiclibraryitemalbum.h"
+#include "models/cachewriter.h"
+#include "context/contentcache.h"
 #include "librarypage.h"
 #include "albumspage.h"
 #include "folderpage.h"
@@ -152,6 +154,8 @@ static int nextKey(int &key)
 }
 
 static const char *constRatingKey="rating";
+static const int constStatusRetryDelay=250;
+static const int constMaxStatusRetries=4;
 
 MainWindow::MainWindow(QWidget *parent)
     : MAIN_WINDOW_BASE_CLASS(parent)
@@ -1024,6 +1028,8 @@ MainWindow::~MainWindow()
     #ifdef TAGLIB_FOUND
     Tags::stop();
     #endif
+    CacheWriter::self()->stop();
+    ContentCache::self()->stop();
     ThreadCleaner::self()->stopAll();
     Configuration(playQueuePage->metaObject()->className()).set(ItemView::constSearchActiveKey, playQueueSearchWidget->isActive());
 }
@@ -1873,10 +1879,12 @@ void MainWindow::updateStatus(MPDStatus * const status)
             statusTimer->setProperty("count", 0);
         }
     } else {
-        nowPlaying->setRange(0, 0==status->timeTotal() && 0!=current.time && (current.isCdda() || current.isCantataStream())
-                                    ? current.time : status->timeTotal());
+        // MPD may report a zero duration just after a song change. If we already know the song's duration, then use
+        // this - and interpolate the elapsed time as normal. Only if we have no duration (and the song is not a stream,
+        // which never has one) do we re-request the status - backing off each time.
+        nowPlaying->setRange(0, 0==status->timeTotal() && 0!=current.time ? current.time : status->timeTotal());
         nowPlaying->setValue(status->timeElapsed());
-        if (0==status->timeTotal() && 0==status->timeElapsed()) {
+        if (0==status->timeTotal() && 0==status->timeElapsed() && 0==current.time && !currentIsStream()) {
             if (!statusTimer) {
                 statusTimer=new QTimer(this);
                 statusTimer->setSingleShot(true);
@@ -1886,10 +1894,11 @@ void MainWindow::updateStatus(MPDStatus * const status)
             if (!id.isValid() || id.toInt()!=current.id) {
                 statusTimer->setProperty("id", current.id);
                 statusTimer->setProperty("count", 0);
-                statusTimer->start(250);
-            } else if (statusTimer->property("count").toInt()<12) {
-                statusTimer->setProperty("count", statusTimer->property("count").toInt()+1);
-                statusTimer->start(250);
+                statusTimer->start(constStatusRetryDelay);
+            } else if (statusTimer->property("count").toInt()<constMaxStatusRetries) {
+                int count=statusTimer->property("count").toInt()+1;
+                statusTimer->setProperty("count", count);
+                statusTimer->start(constStatusRetryDelay<<count);
             }
         } else if (!nowPlaying->isEnabled()) {
             nowPlaying->setEnabled(-1!=current.id && !current.isCdda() && (!currentIsStream() || status->timeTotal()>5));
@@ -2599,6 +2608,7 @@ void MainWindow::updateNextTrack(int nextTrackId)
         Song s=playQueueModel.getSongByRow(playQueueModel.getRowById(nextTrackId));
         if (!s.artist.isEmpty() && !s.title.isEmpty()) {
             tt+=QLatin1String("<br/><i><small>")+s.artistSong()+QLatin1String("<small></i>");
+            context->prefetch(s);
         } else {
             nextTrackId=-1;
         }
@@ -419,6 +419,16 @@ QStringList Settings::lyricProviders()
                                                    << "vagalume.uol.com.br" << "vagalume.uol.com.br (PORTUGUESE)");
 }
 
+QStringList Settings::lyricProviderStats()
+{
+    return cfg.get("lyricProviderStats", QStringList());
+}
+
+int Settings::parallelLyricLookups()
+{
+    return cfg.get("parallelLyricLookups", 3, 1, 8);
+}
+
 QStringList Settings::wikipediaLangs()
 {
     return cfg.get("wikipediaLangs", QStringList() << "en:en");
@@ -489,6 +499,16 @@ int Settings::contextTrackView()
     return cfg.get("contextTrackView", 0);
 }
 
+int Settings::contextPrefetchBudget()
+{
+    return cfg.get("contextPrefetchBudget", 7, 0, 7);
+}
+
+int Settings::contextCacheSize()
+{
+    return cfg.get("contextCacheSize", 250, 10, 10000);
+}
+
 QString Settings::page()
 {
     return cfg.get("page", QString());
@@ -519,6 +539,12 @@ int Settings::devicesView()
 {
     return ItemView::toMode(cfg.get("devicesView", ItemView::modeStr(ItemView::Mode_DetailedTree)));
 }
+
+// 0 => use number of CPU cores
+int Settings::maxTranscodeJobs()
+{
+    return cfg.get("maxTranscodeJobs", 0, 0, 8);
+}
 #endif
 
 #ifndef ENABLE_UBUNTU
@@ -732,6 +758,11 @@ int Settings::podcastAutoDownloadLimit()
     return cfg.get("podcastAutoDownloadLimit", 0, 0, 1000);
 }
 
+int Settings::maxPodcastDownloads()
+{
+    return cfg.get("maxPodcastDownloads", 2, 1, 8);
+}
+
 int Settings::maxCoverUpdatePerIteration()
 {
     return cfg.get("maxCoverUpdatePerIteration", 10, 1, 50);
@@ -752,6 +783,11 @@ bool Settings::networkAccessEnabled()
     return cfg.get("networkAccessEnabled", true);
 }
 
+int Settings::networkCacheSize()
+{
+    return cfg.get("networkCacheSize", 50, 0, 1000);
+}
+
 int Settings::volumeStep()
 {
     return cfg.get("volumeStep", 5, 1, 20);
@@ -804,6 +840,11 @@ bool Settings::alwaysUseLsInfo()
     return cfg.get("alwaysUseLsInfo", true);
 }
 
+bool Settings::lazyFolders()
+{
+    return cfg.get("lazyFolders", false);
+}
+
 bool Settings::showMenubar()
 {
     return cfg.get("showMenubar", false);
@@ -1057,6 +1098,11 @@ void Settings::saveLyricProviders(const QStringList &v)
     cfg.set("lyricProviders", v);
 }
 
+void Settings::saveLyricProviderStats(const QStringList &v)
+{
+    cfg.set("lyricProviderStats", v);
+}
+
 void Settings::saveWikipediaLangs(const QStringList &v)
 {
     cfg.set("wikipediaLangs", v);
@@ -87,6 +87,8 @@ public:
     bool groupSingle();
     QSet<QString> composerGenres();
     QStringList lyricProviders();
+    QStringList lyricProviderStats();
+    int parallelLyricLookups();
     QStringList wikipediaLangs();
     bool wikipediaIntroOnly();
     int contextBackdrop();
@@ -101,12 +103,15 @@ public:
     int contextSwitchTime();
     bool contextAutoScroll();
     int contextTrackView();
+    int contextPrefetchBudget();
+    int contextCacheSize();
     QString page();
     QStringList hiddenPages();
     #ifdef ENABLE_DEVICES_SUPPORT
     bool overwriteSongs();
     bool showDeleteAction();
     int devicesView();
+    int maxTranscodeJobs();
     #endif
     #ifndef ENABLE_UBUNTU
     int searchView();
@@ -156,10 +161,12 @@ public:
     QDateTime lastRssUpdate();
     QString podcastDownloadPath();
     int podcastAutoDownloadLimit();
+    int maxPodcastDownloads();
     int maxCoverUpdatePerIteration();
     int coverCacheSize();
     QStringList cueFileCodecs();
     bool networkAccessEnabled();
+    int networkCacheSize();
     int volumeStep();
     StartupState startupState();
     int undoSteps();
@@ -172,6 +179,7 @@ public:
     QString lang();
     #endif
     bool alwaysUseLsInfo();
+    bool lazyFolders();
     bool showMenubar();
     int menu();
     bool touchFriendly();
@@ -215,6 +223,7 @@ public:
     void saveGroupSingle(bool v);
     void saveComposerGenres(const QSet<QString> &v);
     void saveLyricProviders(const QStringList &v);
+    void saveLyricProviderStats(const QStringList &v);
     void saveWikipediaLangs(const QStringList &v);
     void saveWikipediaIntroOnly(bool v);
     void saveContextBackdrop(int v);
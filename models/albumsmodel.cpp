@@ -28,6 +28,7 @@
 #include <QStringList>
 #include <QPainter>
 #include <QFile>
+#include <QTimer>
 #include "support/localize.h"
 #include "gui/plurals.h"
 #include "support/globalstatic.h"
@@ -82,6 +83,7 @@ AlbumsModel::AlbumsModel(QObject *parent)
     : ActionModel(parent)
     , enabled(false)
 //     , coversRequested(false)
+    , coverUpdateTimer(0)
 {
     #if defined ENABLE_MODEL_TEST
     new ModelTest(this, this);
@@ -470,21 +472,46 @@ void AlbumsModel::coverLoaded(const Song &song, int s)
     Q_UNUSED(song)
     #else
     if (!song.isArtistImageRequest() && !song.isComposerImageRequest()) {
-        QList<AlbumItem *>::Iterator it=items.begin();
-        QList<AlbumItem *>::Iterator end=items.end();
-        const QString &albumArtist=song.albumArtist();
-        const QString &albumId=song.albumId();
-
-        for (int row=0; it!=end; ++it, ++row) {
-            if ((*it)->artist==albumArtist && (*it)->albumId()==albumId) {
-                QModelIndex idx=index(row, 0, QModelIndex());
-                emit dataChanged(idx, idx);
-            }
+        // Covers are loaded in batches, so collect these and update all affected rows in one go.
+        // This saves scanning all albums, and repainting the view, for each cover.
+        loadedCovers.insert(song.albumArtist()+QLatin1Char('\n')+song.albumId());
+        if (!coverUpdateTimer) {
+            coverUpdateTimer=new QTimer(this);
+            coverUpdateTimer->setSingleShot(true);
+            connect(coverUpdateTimer, SIGNAL(timeout()), this, SLOT(updateCovers()));
+        }
+        if (!coverUpdateTimer->isActive()) {
+            coverUpdateTimer->start(50);
         }
     }
     #endif
 }
 
+void AlbumsModel::updateCovers()
+{
+    if (loadedCovers.isEmpty()) {
+        return;
+    }
+
+    int first=-1;
+    int last=-1;
+    QList<AlbumItem *>::Iterator it=items.begin();
+    QList<AlbumItem *>::Iterator end=items.end();
+
+    for (int row=0; it!=end; ++it, ++row) {
+        if (loadedCovers.contains((*it)->artist+QLatin1Char('\n')+(*it)->albumId())) {
+            if (-1==first) {
+                first=row;
+            }
+            last=row;
+        }
+    }
+    loadedCovers.clear();
+    if (-1!=first) {
+        emit dataChanged(index(first, 0, QModelIndex()), index(last, 0, QModelIndex()));
+    }
+}
+
 void AlbumsModel::clearNewState()
 {
     for (int i=0; i<items.count(); ++i) {
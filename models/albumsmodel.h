@@ -34,6 +34,7 @@
 class MusicLibraryItemRoot;
 class QSize;
 class QPixmap;
+class QTimer;
 
 class AlbumsModel : public ActionModel
 {
@@ -148,10 +149,15 @@ public Q_SLOTS:
     void setCover(const Song &song, const QImage &img, const QString &file);
     void update(const MusicLibraryItemRoot *root, bool incremental=true);
 
+private Q_SLOTS:
+    void updateCovers();
+
 private:
     bool enabled;
 //     bool coversRequested;
     mutable QList<AlbumItem *> items;
+    QSet<QString> loadedCovers; // Albums whose covers have loaded, but whose rows have not been updated yet
+    QTimer *coverUpdateTimer;
 };
 
 #endif
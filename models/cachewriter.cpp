@@ -0,0 +1,228 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2014 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "cachewriter.h"
+#include "support/thread.h"
+#include "support/globalstatic.h"
+#include "qtiocompressor/qtiocompressor.h"
+#include <QTimer>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QXmlStreamWriter>
+#include <QMutexLocker>
+#include <QDebug>
+
+static bool debugIsEnabled=false;
+#define DBUG if (debugIsEnabled) qWarning() << "CacheWriter" << __FUNCTION__
+void CacheWriter::enableDebug()
+{
+    debugIsEnabled=true;
+}
+
+static const int constSaveDelay=2000;
+static const QLatin1String constTempExt(".tmp");
+
+GLOBAL_STATIC(CacheWriter, instance)
+
+QString CacheWriter::tempName(const QString &fileName)
+{
+    return fileName+constTempExt;
+}
+
+void CacheWriter::recover(const QString &fileName)
+{
+    QString temp=tempName(fileName);
+    if (!QFile::exists(fileName) && QFile::exists(temp)) {
+        DBUG << fileName;
+        QFile::rename(temp, fileName);
+    }
+}
+
+CacheWriterWorker::CacheWriterWorker()
+{
+    thread=new Thread(metaObject()->className());
+    moveToThread(thread);
+    thread->start();
+}
+
+void CacheWriterWorker::queue(const QMap<QString, CacheSnapshotPtr> &j)
+{
+    QMutexLocker locker(&mutex);
+    QMap<QString, CacheSnapshotPtr>::ConstIterator it=j.constBegin();
+    QMap<QString, CacheSnapshotPtr>::ConstIterator end=j.constEnd();
+    for (; it!=end; ++it) {
+        // Replaces any older snapshot that has not been written yet.
+        jobs.insert(it.key(), it.value());
+    }
+}
+
+bool CacheWriterWorker::isQueued(const QString &fileName, bool *remove) const
+{
+    QMutexLocker locker(&mutex);
+    QMap<QString, CacheSnapshotPtr>::ConstIterator it=jobs.find(fileName);
+    if (it!=jobs.constEnd()) {
+        *remove=it.value().isNull();
+        return true;
+    }
+    if (fileName==current) {
+        *remove=false;
+        return true;
+    }
+    return false;
+}
+
+void CacheWriterWorker::stop()
+{
+    thread->stop();
+}
+
+void CacheWriterWorker::process()
+{
+    // Only one write at a time - as stop() may call this on the GUI thread whilst the worker thread is writing.
+    QMutexLocker writeLocker(&writeMutex);
+    for (;;) {
+        QString fileName;
+        CacheSnapshotPtr snapshot;
+        {
+            QMutexLocker locker(&mutex);
+            if (jobs.isEmpty()) {
+                current=QString();
+                return;
+            }
+            QMap<QString, CacheSnapshotPtr>::Iterator it=jobs.begin();
+            fileName=current=it.key();
+            snapshot=it.value();
+            jobs.erase(it);
+        }
+        write(fileName, snapshot);
+    }
+}
+
+void CacheWriterWorker::write(const QString &fileName, const CacheSnapshotPtr &snapshot)
+{
+    if (snapshot.isNull()) {
+        DBUG << "remove" << fileName;
+        QFile::remove(CacheWriter::tempName(fileName));
+        QFile::remove(fileName);
+        return;
+    }
+    CacheWriter::write(fileName, *snapshot);
+}
+
+bool CacheWriter::write(const QString &fileName, const CacheSnapshot &snapshot)
+{
+    QString temp=tempName(fileName);
+    QElapsedTimer timer;
+    timer.start();
+    QFile file(temp);
+    QtIOCompressor compressor(&file);
+    compressor.setStreamFormat(QtIOCompressor::GzipFormat);
+    if (!compressor.open(QIODevice::WriteOnly)) {
+        DBUG << "failed to open" << temp;
+        return false;
+    }
+
+    QXmlStreamWriter writer(&compressor);
+    snapshot.write(writer);
+    compressor.close();
+    if (writer.hasError() || QFile::NoError!=file.error()) {
+        DBUG << "failed to write" << temp;
+        QFile::remove(temp);
+        return false;
+    }
+
+    // If we are killed between removing the cache and renaming the new one, recover() will use the temp file.
+    QFile::remove(fileName);
+    if (!QFile::rename(temp, fileName)) {
+        DBUG << "failed to rename" << temp;
+        QFile::remove(temp);
+        return false;
+    }
+    DBUG << fileName << timer.elapsed();
+    return true;
+}
+
+CacheWriter::CacheWriter()
+    : timer(0)
+    , worker(0)
+{
+}
+
+void CacheWriter::save(const QString &fileName, CacheSnapshot *snapshot)
+{
+    DBUG << fileName << (void *)snapshot;
+    pending.insert(fileName, CacheSnapshotPtr(snapshot));
+    if (!timer) {
+        timer=new QTimer(this);
+        timer->setSingleShot(true);
+        connect(timer, SIGNAL(timeout()), this, SLOT(queuePending()));
+    }
+    timer->start(constSaveDelay);
+}
+
+bool CacheWriter::exists(const QString &fileName) const
+{
+    QMap<QString, CacheSnapshotPtr>::ConstIterator it=pending.find(fileName);
+    if (it!=pending.constEnd()) {
+        return !it.value().isNull();
+    }
+    bool remove=false;
+    if (worker && worker->isQueued(fileName, &remove)) {
+        return !remove;
+    }
+    return QFile::exists(fileName);
+}
+
+void CacheWriter::stop()
+{
+    if (timer) {
+        timer->stop();
+    }
+    if (!worker && pending.isEmpty()) {
+        return;
+    }
+    DBUG << pending.keys();
+    if (!worker) {
+        worker=new CacheWriterWorker();
+    }
+    worker->queue(pending);
+    pending.clear();
+    worker->stop();
+    // Write anything the worker has not yet started on, waiting for any current write to finish.
+    worker->process();
+}
+
+void CacheWriter::queuePending()
+{
+    if (pending.isEmpty()) {
+        return;
+    }
+    if (!worker) {
+        worker=new CacheWriterWorker();
+        connect(this, SIGNAL(process()), worker, SLOT(process()), Qt::QueuedConnection);
+    }
+    DBUG << pending.keys();
+    worker->queue(pending);
+    pending.clear();
+    emit process();
+}
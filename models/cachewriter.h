@@ -0,0 +1,114 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2014 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef CACHE_WRITER_H
+#define CACHE_WRITER_H
+
+#include <QObject>
+#include <QMap>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+
+class QXmlStreamWriter;
+class QTimer;
+class Thread;
+
+// Copy of the data that is to be saved. This must not reference any model items, as it is
+// written on a background thread whilst the model may be modified.
+class CacheSnapshot
+{
+public:
+    virtual ~CacheSnapshot() { }
+    virtual void write(QXmlStreamWriter &writer) const =0;
+};
+
+typedef QSharedPointer<CacheSnapshot> CacheSnapshotPtr;
+
+// Writes (gzipped) XML caches on a background thread. Output goes to a temporary file, which is then
+// renamed over the cache - so that the cache is never left half-written.
+class CacheWriterWorker : public QObject
+{
+    Q_OBJECT
+public:
+    CacheWriterWorker();
+    ~CacheWriterWorker() { }
+
+    void queue(const QMap<QString, CacheSnapshotPtr> &jobs);
+    bool isQueued(const QString &fileName, bool *remove) const;
+    void stop();
+
+public Q_SLOTS:
+    // Writes all queued caches. Called on the worker's thread, and on the GUI thread when stopping.
+    void process();
+
+private:
+    void write(const QString &fileName, const CacheSnapshotPtr &snapshot);
+
+private:
+    Thread *thread;
+    mutable QMutex mutex;
+    QMutex writeMutex;
+    QMap<QString, CacheSnapshotPtr> jobs; // A null snapshot implies the cache is to be removed
+    QString current;
+};
+
+// Collects snapshots on the GUI thread, and passes them to the worker once no more have been
+// saved for constSaveDelay milliseconds - so that several updates in quick succession only
+// cause the cache to be written once.
+class CacheWriter : public QObject
+{
+    Q_OBJECT
+public:
+    static void enableDebug();
+    static CacheWriter * self();
+    static QString tempName(const QString &fileName);
+    // If Cantata was killed between removing a cache and renaming the new one, then use the new one.
+    static void recover(const QString &fileName);
+    // Write a cache now, on the calling thread - for use by code that is already on a background thread.
+    static bool write(const QString &fileName, const CacheSnapshot &snapshot);
+
+    CacheWriter();
+    ~CacheWriter() { }
+
+    // Takes ownership of snapshot. If snapshot is 0, the cache file is removed.
+    void save(const QString &fileName, CacheSnapshot *snapshot);
+    void remove(const QString &fileName) { save(fileName, 0); }
+    // Returns true if the cache file exists, or will once pending saves are written.
+    bool exists(const QString &fileName) const;
+    // Write all pending caches, and wait for them to complete.
+    void stop();
+
+Q_SIGNALS:
+    void process();
+
+private Q_SLOTS:
+    void queuePending();
+
+private:
+    QTimer *timer;
+    CacheWriterWorker *worker;
+    QMap<QString, CacheSnapshotPtr> pending;
+};
+
+#endif
@@ -31,7 +31,7 @@
 class DirViewItemDir : public DirViewItem
 {
 public:
-    DirViewItemDir(const QString &name=QString(), DirViewItem *parent=0) : DirViewItem(name, parent) { }
+    DirViewItemDir(const QString &name=QString(), DirViewItem *parent=0) : DirViewItem(name, parent), m_fetched(true) { }
     virtual ~DirViewItemDir() { qDeleteAll(m_childItems); }
 
     virtual int indexOf(DirViewItem *c) const { return m_childItems.indexOf(c); }
@@ -48,8 +48,12 @@ public:
     bool hasChild(const QString &name) { return m_indexes.contains(name); }
     QSet<QString> allFiles() const;
     Type type() const { return Type_Dir; }
+    // When folders are loaded on demand, this is false until the contents have been listed.
+    bool isFetched() const { return m_fetched; }
+    void setFetched(bool f) { m_fetched=f; }
 
 private:
+    bool m_fetched;
     QHash<QString, int> m_indexes;
     QList<DirViewItem *> m_childItems;
 };
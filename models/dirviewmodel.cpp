@@ -38,6 +38,7 @@
 #include "dirviewitemfile.h"
 #include "playqueuemodel.h"
 #include "musiclibrarymodel.h"
+#include "cachewriter.h"
 #include "roles.h"
 #include "gui/settings.h"
 #include "mpd-interface/mpdconnection.h"
@@ -70,6 +71,7 @@ DirViewModel::DirViewModel(QObject *parent)
     , rootItem(new DirViewItemRoot)
     , databaseTimeUnreliable(false)
     , enabled(false)
+    , lazy(false)
 {
     #if defined ENABLE_MODEL_TEST
     new ModelTest(this, this);
@@ -91,11 +93,15 @@ void DirViewModel::setEnabled(bool e)
     if (enabled) {
         connect(MPDConnection::self(), SIGNAL(updatingDatabase()), this, SLOT(updatingMpd()));
         connect(MPDConnection::self(), SIGNAL(dirViewUpdated(DirViewItemRoot *, const QDateTime &)), this, SLOT(updateDirView(DirViewItemRoot *, const QDateTime &)));
+        connect(MPDConnection::self(), SIGNAL(folderListed(const QString &, const QStringList &, const QStringList &, bool)), this, SLOT(folderListed(const QString &, const QStringList &, const QStringList &, bool)));
+        connect(this, SIGNAL(listFolder(const QString &)), MPDConnection::self(), SLOT(listFolder(const QString &)));
     } else {
         clear();
         removeCache();
         disconnect(MPDConnection::self(), SIGNAL(updatingDatabase()), this, SLOT(updatingMpd()));
         disconnect(MPDConnection::self(), SIGNAL(dirViewUpdated(DirViewItemRoot *, const QDateTime &)), this, SLOT(updateDirView(DirViewItemRoot *, const QDateTime &)));
+        disconnect(MPDConnection::self(), SIGNAL(folderListed(const QString &, const QStringList &, const QStringList &, bool)), this, SLOT(folderListed(const QString &, const QStringList &, const QStringList &, bool)));
+        disconnect(this, SIGNAL(listFolder(const QString &)), MPDConnection::self(), SLOT(listFolder(const QString &)));
     }
 }
 
@@ -164,6 +170,38 @@ int DirViewModel::columnCount(const QModelIndex &) const
     return 1;
 }
 
+bool DirViewModel::hasChildren(const QModelIndex &parent) const
+{
+    if (parent.column() > 0) {
+        return false;
+    }
+
+    const DirViewItem *parentItem=parent.isValid() ? static_cast<DirViewItem *>(parent.internalPointer()) : rootItem;
+    if (DirViewItem::Type_File!=parentItem->type() && !static_cast<const DirViewItemDir *>(parentItem)->isFetched()) {
+        // Not listed yet, so show expander...
+        return true;
+    }
+    return parentItem->childCount()>0;
+}
+
+bool DirViewModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (!lazy || parent.column() > 0) {
+        return false;
+    }
+
+    const DirViewItem *parentItem=parent.isValid() ? static_cast<DirViewItem *>(parent.internalPointer()) : rootItem;
+    return DirViewItem::Type_File!=parentItem->type() && !static_cast<const DirViewItemDir *>(parentItem)->isFetched()
+           && !requested.contains(parentItem->fullName());
+}
+
+void DirViewModel::fetchMore(const QModelIndex &parent)
+{
+    if (canFetchMore(parent)) {
+        requestListing(parent.isValid() ? static_cast<DirViewItem *>(parent.internalPointer())->fullName() : QString());
+    }
+}
+
 #ifdef ENABLE_UBUNTU
 static const QString constFolderIcon=QLatin1String("qrc:/folder.svg");
 #endif
@@ -213,7 +251,7 @@ QVariant DirViewModel::data(const QModelIndex &index, int role) const
     case Cantata::Role_SubText:
         switch (item->type()) {
         case DirViewItem::Type_Dir:
-            return Plurals::entries(item->childCount());
+            return static_cast<DirViewItemDir *>(item)->isFetched() ? Plurals::entries(item->childCount()) : QString();
         case DirViewItem::Type_File:
             switch (static_cast<DirViewItemFile *>(item)->fileType()) {
             case DirViewItemFile::Audio:    return i18n("Audio File");
@@ -231,7 +269,8 @@ QVariant DirViewModel::data(const QModelIndex &index, int role) const
 
 void DirViewModel::clear()
 {
-    if (!rootItem || 0==rootItem->childCount()) {
+    requested.clear();
+    if (!rootItem || (0==rootItem->childCount() && rootItem->isFetched())) {
         return;
     }
     const DirViewItemRoot *oldRoot = rootItem;
@@ -254,73 +293,131 @@ static const QString constTrueValue=QLatin1String("true");
 
 static quint32 constVersion=2;
 
+// Flattened copy of the folder tree - each directory is followed by its children, and then an End entry.
+class DirViewCacheSnapshot : public CacheSnapshot
+{
+public:
+    struct Entry
+    {
+        enum Type { Dir, File, End };
+        Entry(Type t=End, const QString &n=QString(), const QString &p=QString()) : type(t), name(n), path(p) { }
+        Type type;
+        QString name;
+        QString path;
+    };
+
+    DirViewCacheSnapshot(const DirViewItemRoot *root, const QDateTime &d, bool du)
+        : date(d), dateUnreliable(du) {
+        if (root) {
+            foreach (const DirViewItem *i, root->childItems()) {
+                add(i);
+            }
+        }
+    }
+    virtual ~DirViewCacheSnapshot() { }
+
+    void write(QXmlStreamWriter &writer) const {
+        writer.writeStartDocument();
+        writer.writeStartElement(constTopTag);
+        writer.writeAttribute(constVersionAttribute, QString::number(constVersion));
+        writer.writeAttribute(constDateAttribute, QString::number(date.toTime_t()));
+        if (dateUnreliable) {
+            writer.writeAttribute(constDateUnreliableAttribute, constTrueValue);
+        }
+        foreach (const Entry &e, entries) {
+            switch (e.type) {
+            case Entry::Dir:
+                writer.writeStartElement(constDirTag);
+                writer.writeAttribute(constNameAttribute, e.name);
+                break;
+            case Entry::File:
+                writer.writeStartElement(constFileTag);
+                writer.writeAttribute(constNameAttribute, e.name);
+                if (!e.path.isEmpty()) {
+                    writer.writeAttribute(constPathAttribute, e.path);
+                }
+                writer.writeEndElement();
+                break;
+            case Entry::End:
+                writer.writeEndElement();
+                break;
+            }
+        }
+        writer.writeEndElement();
+        writer.writeEndDocument();
+    }
+
+private:
+    void add(const DirViewItem *item) {
+        if (DirViewItem::Type_Dir==item->type()) {
+            entries.append(Entry(Entry::Dir, item->name()));
+            foreach (const DirViewItem *i, static_cast<const DirViewItemDir *>(item)->childItems()) {
+                add(i);
+            }
+            entries.append(Entry());
+        } else {
+            entries.append(Entry(Entry::File, item->name(), static_cast<const DirViewItemFile *>(item)->filePath()));
+        }
+    }
+
+private:
+    QDateTime date;
+    bool dateUnreliable;
+    QList<Entry> entries;
+};
+
 void DirViewModel::toXML()
 {
     QString filename=cacheFileName();
     if ((!rootItem || 0==rootItem->childCount()) && !MusicLibraryModel::validCacheDate(databaseTime)) {
-        if (QFile::exists(filename)) {
-            QFile::remove(filename);
-        }
+        CacheWriter::self()->remove(filename);
         return;
     }
 
-    QFile file(filename);
-    QtIOCompressor compressor(&file);
-    compressor.setStreamFormat(QtIOCompressor::GzipFormat);
-    if (!compressor.open(QIODevice::WriteOnly)) {
-        return;
-    }
+    CacheWriter::self()->save(filename, new DirViewCacheSnapshot(rootItem, databaseTime, databaseTimeUnreliable));
+}
 
-    QXmlStreamWriter writer(&compressor);
+bool DirViewModel::load()
+{
+    // Mopidy's folder listing does not match the file paths it uses, so always read the full listing.
+    bool wasLazy=lazy;
+    lazy=Settings::self()->lazyFolders() && !MPDConnection::self()->isMopdidy();
 
-    writer.writeStartDocument();
-    writer.writeStartElement(constTopTag);
-    writer.writeAttribute(constVersionAttribute, QString::number(constVersion));
-    writer.writeAttribute(constDateAttribute, QString::number(databaseTime.toTime_t()));
-    if (databaseTimeUnreliable) {
-        writer.writeAttribute(constDateUnreliableAttribute, constTrueValue);
+    if (!lazy) {
+        return fromXML();
     }
 
-    if (rootItem) {
-        foreach (const DirViewItem *i, rootItem->childItems()) {
-            toXML(i, writer);
-        }
+    QDateTime dbUpdate=MPDStats::self()->dbUpdate();
+    if (!wasLazy || !databaseTime.isValid()) {
+        // Start with an empty tree, and list the top-level folder. Everything else is listed as it is expanded.
+        const DirViewItemRoot *oldRoot = rootItem;
+        beginResetModel();
+        requested.clear();
+        rootItem = new DirViewItemRoot;
+        rootItem->setFetched(false);
+        delete oldRoot;
+        endResetModel();
+        databaseTime=dbUpdate;
+        requestListing(QString());
+    } else if (dbUpdate>databaseTime) {
+        // Database has changed, so re-list every folder that has been listed...
+        databaseTime=dbUpdate;
+        relist(rootItem);
     }
-    writer.writeEndElement();
-    writer.writeEndDocument();
-    compressor.close();
+    return true;
 }
 
 void DirViewModel::removeCache()
 {
-    QString cacheFile(cacheFileName());
-    if (QFile::exists(cacheFile)) {
-        QFile::remove(cacheFile);
-    }
+    CacheWriter::self()->remove(cacheFileName());
 
     databaseTime = QDateTime();
 }
 
-void DirViewModel::toXML(const DirViewItem *item, QXmlStreamWriter &writer)
-{
-    writer.writeStartElement(DirViewItem::Type_File==item->type() ? constFileTag : constDirTag);
-    writer.writeAttribute(constNameAttribute, item->name());
-    if (DirViewItem::Type_Dir==item->type()) {
-        foreach (const DirViewItem *i, static_cast<const DirViewItemDir *>(item)->childItems()) {
-            toXML(i, writer);
-        }
-    } else {
-         const DirViewItemFile *f=static_cast<const DirViewItemFile *>(item);
-         if (!f->filePath().isEmpty()) {
-             writer.writeAttribute(constPathAttribute, f->filePath());
-         }
-    }
-    writer.writeEndElement();
-}
-
 bool DirViewModel::fromXML()
 {
     clear();
+    CacheWriter::recover(cacheFileName());
     QFile file(cacheFileName());
     QtIOCompressor compressor(&file);
     compressor.setStreamFormat(QtIOCompressor::GzipFormat);
@@ -389,7 +486,7 @@ quint32 DirViewModel::fromXML(QIODevice *dev, const QDateTime &dt, DirViewItemRo
 
 void DirViewModel::updateDirView(DirViewItemRoot *newroot, const QDateTime &dbUpdate, bool fromFile)
 {
-    if (databaseTime.isValid() && databaseTime >= dbUpdate) {
+    if (lazy || (databaseTime.isValid() && databaseTime >= dbUpdate)) {
         delete newroot;
         return;
     }
@@ -398,7 +495,7 @@ void DirViewModel::updateDirView(DirViewItemRoot *newroot, const QDateTime &dbUp
     bool updatedListing=false;
     bool needToSave=!databaseTime.isValid() || (MusicLibraryModel::validCacheDate(dbUpdate) && dbUpdate>databaseTime);
 
-    if (incremental && !QFile::exists(cacheFileName())) {
+    if (incremental && !CacheWriter::self()->exists(cacheFileName())) {
         incremental=false;
     }
 
@@ -463,6 +560,94 @@ void DirViewModel::updatingMpd()
     }
 }
 
+void DirViewModel::folderListed(const QString &dir, const QStringList &dirs, const QStringList &files, bool ok)
+{
+    requested.remove(dir);
+    if (!lazy || !ok) {
+        return;
+    }
+
+    DirViewItemDir *item=findDir(dir);
+    if (!item) {
+        // Removed, or tree has been reset, since listing was requested.
+        return;
+    }
+
+    QModelIndex idx=item==rootItem ? QModelIndex() : createIndex(item->row(), 0, item);
+    QSet<QString> newDirs=dirs.toSet();
+    QSet<QString> newFiles=files.toSet();
+
+    // Remove items that no longer exist. Items that do exist are kept, so that already listed
+    // sub-folders (and their expanded state) are retained when re-listing after a database update.
+    for (int i=item->childCount()-1; i>=0; --i) {
+        DirViewItem *child=item->child(i);
+        if (DirViewItem::Type_Dir==child->type() ? !newDirs.remove(child->name()) : !newFiles.remove(child->name())) {
+            beginRemoveRows(idx, i, i);
+            item->remove(child);
+            delete child;
+            endRemoveRows();
+        }
+    }
+
+    QList<DirViewItem *> added;
+    foreach (const QString &d, dirs) {
+        if (newDirs.remove(d)) {
+            DirViewItemDir *child=new DirViewItemDir(d, item);
+            child->setFetched(false);
+            added.append(child);
+        }
+    }
+    foreach (const QString &f, files) {
+        if (newFiles.remove(f)) {
+            added.append(new DirViewItemFile(f, QString(), item));
+        }
+    }
+    item->setFetched(true);
+    if (!added.isEmpty()) {
+        beginInsertRows(idx, item->childCount(), item->childCount()+added.count()-1);
+        foreach (DirViewItem *child, added) {
+            item->add(child);
+        }
+        endInsertRows();
+    } else if (idx.isValid()) {
+        // Expander may need to be removed...
+        emit dataChanged(idx, idx);
+    }
+}
+
+void DirViewModel::requestListing(const QString &dir)
+{
+    requested.insert(dir);
+    emit listFolder(dir);
+}
+
+void DirViewModel::relist(DirViewItemDir *dir)
+{
+    if (!dir->isFetched()) {
+        return;
+    }
+    requestListing(dir==rootItem ? QString() : dir->fullName());
+    foreach (DirViewItem *child, dir->childItems()) {
+        if (DirViewItem::Type_Dir==child->type()) {
+            relist(static_cast<DirViewItemDir *>(child));
+        }
+    }
+}
+
+DirViewItemDir * DirViewModel::findDir(const QString &path) const
+{
+    DirViewItemDir *dir=rootItem;
+    if (!path.isEmpty()) {
+        foreach (const QString &part, path.split(Utils::constDirSep)) {
+            dir=dir->getDirectory(part, false);
+            if (!dir) {
+                break;
+            }
+        }
+    }
+    return dir;
+}
+
 void DirViewModel::addFileToList(const QString &file, const QString &mopidyPath)
 {
     if (!enabled) {
@@ -489,12 +674,17 @@ void DirViewModel::addFileToList(const QStringList &parts, const QModelIndex &pa
 
     DirViewItem *child=dir->child(p);
     if (child) {
-        if (DirViewItem::Type_Dir==child->type()) {
+        // Folders that have not been listed yet will pick up the file when they are.
+        if (DirViewItem::Type_Dir==child->type() && static_cast<DirViewItemDir *>(child)->isFetched()) {
             addFileToList(parts.mid(1), index(dir->indexOf(child), 0, parent), static_cast<DirViewItemDir *>(child), mopidyPath);
         }
     } else {
         beginInsertRows(parent, dir->childCount(), dir->childCount());
-        dir->insertFile(parts, mopidyPath);
+        if (lazy && parts.count()>1) {
+            dir->createDirectory(p)->setFetched(false);
+        } else {
+            dir->insertFile(parts, mopidyPath);
+        }
         endInsertRows();
     }
 }
@@ -510,7 +700,9 @@ void DirViewModel::removeFileFromList(const QStringList &parts, const QModelInde
     DirViewItem *child=dir->child(p);
     if (child) {
         if (DirViewItem::Type_Dir==child->type()) {
-            removeFileFromList(parts.mid(1), index(dir->indexOf(child), 0, parent), static_cast<DirViewItemDir *>(child));
+            if (static_cast<DirViewItemDir *>(child)->isFetched()) {
+                removeFileFromList(parts.mid(1), index(dir->indexOf(child), 0, parent), static_cast<DirViewItemDir *>(child));
+            }
         } else if (DirViewItem::Type_File==child->type()) {
             int index=dir->indexOf(child);
             beginRemoveRows(parent, index, index);
@@ -590,6 +782,11 @@ void DirViewModel::getFiles(DirViewItem *item, QStringList &filenames, bool allo
             addFile(item, filenames, filenames, allowPlaylists);
         break;
         case DirViewItem::Type_Dir: {
+            if (!static_cast<DirViewItemDir *>(item)->isFetched()) {
+                // Not listed yet - MPD will add the folder's contents.
+                addFile(item, filenames, filenames, allowPlaylists);
+                break;
+            }
             QStringList dirFiles;
             for (int c=0; c<item->childCount(); c++) {
                 DirViewItem *child=item->child(c);
@@ -32,8 +32,6 @@
 #include "dirviewitemroot.h"
 #include "actionmodel.h"
 
-class QXmlStreamWriter;
-
 class DirViewModel : public ActionModel
 {
     Q_OBJECT
@@ -50,6 +48,9 @@ public:
     QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
     int rowCount(const QModelIndex &parent = QModelIndex()) const;
     int columnCount(const QModelIndex &) const;
+    bool hasChildren(const QModelIndex &parent=QModelIndex()) const;
+    bool canFetchMore(const QModelIndex &parent) const;
+    void fetchMore(const QModelIndex &parent);
     QVariant data(const QModelIndex &, int) const;
     Qt::ItemFlags flags(const QModelIndex &index) const;
     QStringList filenames(const QModelIndexList &indexes, bool allowPlaylists) const;
@@ -64,26 +65,35 @@ public:
     void removeCache();
     void toXML();
     bool fromXML();
+    // Loads the folder listing from the cache, or (if folders are loaded on demand) lists the top-level
+    // folder. Returns false if the whole listing needs to be read from MPD.
+    bool load();
 
 public Q_SLOTS:
     void updateDirView(DirViewItemRoot *newroot, const QDateTime &dbUpdate=QDateTime(), bool fromFile=false);
     void updatingMpd();
+    void folderListed(const QString &dir, const QStringList &dirs, const QStringList &files, bool ok);
 
 Q_SIGNALS:
     void updated();
+    void listFolder(const QString &dir);
 
 private:
-    void toXML(const DirViewItem *item, QXmlStreamWriter &writer);
     quint32 fromXML(QIODevice *dev, const QDateTime &dt, DirViewItemRoot *root);
     void addFileToList(const QStringList &parts, const QModelIndex &parent, DirViewItemDir *dir, const QString &mopidyPath);
     void removeFileFromList(const QStringList &parts, const QModelIndex &parent, DirViewItemDir *dir);
     void getFiles(DirViewItem *item, QStringList &filenames, bool allowPlaylists) const;
+    void requestListing(const QString &dir);
+    void relist(DirViewItemDir *dir);
+    DirViewItemDir * findDir(const QString &path) const;
 
 private:
     DirViewItemRoot *rootItem;
     QDateTime databaseTime;
     bool databaseTimeUnreliable;
     bool enabled;
+    bool lazy; // Folders are listed as they are expanded
+    QSet<QString> requested; // Folders whose listing has been requested, but not yet received
 };
 
 #endif
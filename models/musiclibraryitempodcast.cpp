@@ -39,11 +39,14 @@
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
 #include <QCryptographicHash>
-#include <QNetworkReply>
+#include <QBuffer>
 
 static QLatin1String constTopTag("podcast");
 static QLatin1String constImageAttribute("img");
 static QLatin1String constRssAttribute("rss");
+static QLatin1String constEtagAttribute("etag");
+static QLatin1String constModifiedAttribute("modified");
+static QLatin1String constHashAttribute("hash");
 static QLatin1String constEpisodeTag("episode");
 static QLatin1String constNameAttribute("name");
 static QLatin1String constDateAttribute("date");
@@ -108,6 +111,9 @@ bool MusicLibraryItemPodcast::load()
             if (constTopTag == element) {
                 m_imageUrl=attributes.value(constImageAttribute).toString();
                 m_rssUrl=attributes.value(constRssAttribute).toString();
+                m_etag=attributes.value(constEtagAttribute).toString();
+                m_lastModified=attributes.value(constModifiedAttribute).toString();
+                m_contentHash=attributes.value(constHashAttribute).toString();
                 QString name=attributes.value(constNameAttribute).toString();
                 if (m_rssUrl.isEmpty() || name.isEmpty()) {
                     return false;
@@ -145,15 +151,25 @@ bool MusicLibraryItemPodcast::load()
 
 static const QString constRssTag=QLatin1String("rss");
 
-MusicLibraryItemPodcast::RssStatus MusicLibraryItemPodcast::loadRss(QNetworkReply *dev)
+QString MusicLibraryItemPodcast::rssHash(const QByteArray &data)
 {
-    m_rssUrl=dev->url();
+    return QCryptographicHash::hash(data, QCryptographicHash::Md5).toHex();
+}
+
+MusicLibraryItemPodcast::RssStatus MusicLibraryItemPodcast::loadRss(const QUrl &url, const QByteArray &data)
+{
+    m_rssUrl=url;
     if (m_fileName.isEmpty()) {
         m_fileName=m_imageFile=generateFileName(m_rssUrl, true);
         m_imageFile=m_imageFile.replace(constExt, ".jpg");
     }
 
-    RssParser::Channel ch=RssParser::parse(dev);
+    QBuffer dev;
+    dev.setData(data);
+    if (!dev.open(QIODevice::ReadOnly)) {
+        return FailedToParse;
+    }
+    RssParser::Channel ch=RssParser::parse(&dev);
 
     if (!ch.isValid()) {
         return FailedToParse;
@@ -201,6 +217,15 @@ bool MusicLibraryItemPodcast::save()
     writer.writeAttribute(constImageAttribute, m_imageUrl.toString()); // ??
     writer.writeAttribute(constRssAttribute, m_rssUrl.toString()); // ??
     writer.writeAttribute(constNameAttribute, m_itemData);
+    if (!m_etag.isEmpty()) {
+        writer.writeAttribute(constEtagAttribute, m_etag);
+    }
+    if (!m_lastModified.isEmpty()) {
+        writer.writeAttribute(constModifiedAttribute, m_lastModified);
+    }
+    if (!m_contentHash.isEmpty()) {
+        writer.writeAttribute(constHashAttribute, m_contentHash);
+    }
     foreach (MusicLibraryItem *i, m_childItems) {
         MusicLibraryItemPodcastEpisode *episode=static_cast<MusicLibraryItemPodcastEpisode *>(i);
         const Song &s=episode->song();
@@ -242,6 +267,17 @@ Song MusicLibraryItemPodcast::coverSong() const
     return song;
 }
 
+bool MusicLibraryItemPodcast::setRssValidators(const QString &etag, const QString &lastModified, const QString &hash)
+{
+    if (etag==m_etag && lastModified==m_lastModified && hash==m_contentHash) {
+        return false;
+    }
+    m_etag=etag;
+    m_lastModified=lastModified;
+    m_contentHash=hash;
+    return true;
+}
+
 void MusicLibraryItemPodcast::remove(int row)
 {
     delete m_childItems.takeAt(row);
@@ -33,7 +33,6 @@
 #include "mpd-interface/song.h"
 
 class QPixmap;
-class QNetworkReply;
 class MusicLibraryItemPodcastEpisode;
 
 class MusicLibraryItemPodcast : public MusicLibraryItemContainer
@@ -55,8 +54,11 @@ public:
     MusicLibraryItemPodcast(const QString &fileName, MusicLibraryItemContainer *parent);
     virtual ~MusicLibraryItemPodcast() { }
 
+    // Hash of raw RSS data - used to detect unchanged feeds, when server does not support ETag/Last-Modified
+    static QString rssHash(const QByteArray &data);
+
     bool load();
-    RssStatus loadRss(QNetworkReply *dev);
+    RssStatus loadRss(const QUrl &url, const QByteArray &data);
     bool save();
     void remove(int row);
     void remove(MusicLibraryItemSong *i);
@@ -64,6 +66,10 @@ public:
     const QUrl & imageUrl() const { return m_imageUrl; }
     void setImageUrl(const QString &u) { m_imageUrl=u; }
     const QUrl & rssUrl() const { return m_rssUrl; }
+    const QString & etag() const { return m_etag; }
+    const QString & lastModified() const { return m_lastModified; }
+    const QString & contentHash() const { return m_contentHash; }
+    bool setRssValidators(const QString &etag, const QString &lastModified, const QString &hash);
     void removeFiles();
     void setUnplayedCount();
     quint32 unplayedEpisodes() const { return m_unplayedEpisodeCount; }
@@ -79,6 +85,9 @@ private:
     mutable bool m_coverRequested;
     QUrl m_imageUrl;
     QUrl m_rssUrl;
+    QString m_etag;
+    QString m_lastModified;
+    QString m_contentHash;
     QString m_fileName;
     QString m_imageFile;
     quint32 m_unplayedEpisodeCount;
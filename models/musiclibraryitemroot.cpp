@@ -33,6 +33,7 @@
 #include "support/localize.h"
 #include "qtiocompressor/qtiocompressor.h"
 #include "musicmodel.h"
+#include "cachewriter.h"
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
 #include <QFile>
@@ -276,13 +277,84 @@ static const QString constImageAttribute=QLatin1String("img");
 static const QString constnumTracksAttribute=QLatin1String("numTracks");
 static const QString constTrueValue=QLatin1String("true");
 
-void MusicLibraryItemRoot::toXML(QXmlStreamWriter &writer, const QDateTime &date, bool dateUnreliable, MusicLibraryProgressMonitor *prog) const
+// Copy of everything toXML() writes. Songs (and their strings) are implicitly shared, so this is cheap
+// to create - and can then be written on another thread whilst the tree is modified.
+class MusicLibraryCacheSnapshot : public CacheSnapshot
 {
-    if (isFlat) {
-        return;
+public:
+    struct Album
+    {
+        QString name;
+        quint32 year;
+        QString genre;
+        bool singleTracks;
+        QString imageUrl;
+        QString id;
+        QString sort;
+        QList<Song> tracks;
+    };
+
+    struct Artist
+    {
+        QString name;
+        QString actual;
+        QString sort;
+        QList<Album> albums;
+    };
+
+    MusicLibraryCacheSnapshot(const MusicLibraryItemRoot *root, const QDateTime &d, bool du, bool albumArtistSupport);
+    virtual ~MusicLibraryCacheSnapshot() { }
+    void write(QXmlStreamWriter &writer) const { write(writer, 0); }
+    void write(QXmlStreamWriter &writer, MusicLibraryProgressMonitor *prog) const;
+
+private:
+    QDateTime date;
+    bool dateUnreliable;
+    bool groupSingle;
+    bool supportsAlbumArtist;
+    quint64 numTracks;
+    QList<Artist> artists;
+};
+
+MusicLibraryCacheSnapshot::MusicLibraryCacheSnapshot(const MusicLibraryItemRoot *root, const QDateTime &d, bool du, bool albumArtistSupport)
+    : date(d)
+    , dateUnreliable(du)
+    , groupSingle(MPDParseUtils::groupSingle())
+    , supportsAlbumArtist(albumArtistSupport)
+    , numTracks(0)
+{
+    foreach (const MusicLibraryItem *a, root->childItems()) {
+        const MusicLibraryItemArtist *artistItem = static_cast<const MusicLibraryItemArtist *>(a);
+        Artist artist;
+        artist.name=artistItem->data();
+        artist.actual=artistItem->actualArtist();
+        if (artistItem->hasSort()) {
+            artist.sort=artistItem->sortString();
+        }
+        foreach (const MusicLibraryItem *al, artistItem->childItems()) {
+            const MusicLibraryItemAlbum *albumItem = static_cast<const MusicLibraryItemAlbum *>(al);
+            Album album;
+            album.name=albumItem->originalName().isEmpty() ? albumItem->data() : albumItem->originalName();
+            album.year=albumItem->year();
+            album.genre=Song::combineGenres(albumItem->genres());
+            album.singleTracks=albumItem->isSingleTracks();
+            album.imageUrl=albumItem->imageUrl();
+            album.id=albumItem->id();
+            if (albumItem->hasSort()) {
+                album.sort=albumItem->sortString();
+            }
+            foreach (const MusicLibraryItem *t, albumItem->childItems()) {
+                album.tracks.append(static_cast<const MusicLibraryItemSong *>(t)->song());
+            }
+            numTracks+=album.tracks.count();
+            artist.albums.append(album);
+        }
+        artists.append(artist);
     }
+}
 
-    quint64 total=0;
+void MusicLibraryCacheSnapshot::write(QXmlStreamWriter &writer, MusicLibraryProgressMonitor *prog) const
+{
     quint64 count=0;
     int percent=0;
     QElapsedTimer timer;
@@ -299,102 +371,90 @@ void MusicLibraryItemRoot::toXML(QXmlStreamWriter &writer, const QDateTime &date
     if (dateUnreliable) {
         writer.writeAttribute(constDateUnreliableAttribute, constTrueValue);
     }
-    if (MPDParseUtils::groupSingle()) {
+    if (groupSingle) {
         writer.writeAttribute(constGroupSingleAttribute, constTrueValue);
     }
-    foreach (const MusicLibraryItem *a, childItems()) {
-        foreach (const MusicLibraryItem *al, static_cast<const MusicLibraryItemArtist *>(a)->childItems()) {
-            total+=al->childCount();
-            if (prog && prog->wasStopped()) {
-                return;
-            }
-        }
-    }
-
-    writer.writeAttribute(constnumTracksAttribute, QString::number(total));
+    writer.writeAttribute(constnumTracksAttribute, QString::number(numTracks));
 
     //Loop over all artist, albums and tracks.
-    foreach (const MusicLibraryItem *a, childItems()) {
-        const MusicLibraryItemArtist *artist = static_cast<const MusicLibraryItemArtist *>(a);
+    foreach (const Artist &artist, artists) {
         writer.writeStartElement(constArtistElement);
-        writer.writeAttribute(constNameAttribute, artist->data());
-        if (!artist->actualArtist().isEmpty()) {
-            writer.writeAttribute(constActualAttribute, artist->actualArtist());
+        writer.writeAttribute(constNameAttribute, artist.name);
+        if (!artist.actual.isEmpty()) {
+            writer.writeAttribute(constActualAttribute, artist.actual);
         }
-        if (artist->hasSort()) {
-            writer.writeAttribute(constSortAttribute, artist->sortString());
+        if (!artist.sort.isEmpty()) {
+            writer.writeAttribute(constSortAttribute, artist.sort);
         }
-        foreach (const MusicLibraryItem *al, artist->childItems()) {
+        QString artistName=artist.actual.isEmpty() ? artist.name : artist.actual;
+        foreach (const Album &album, artist.albums) {
             if (prog && prog->wasStopped()) {
                 return;
             }
-            const MusicLibraryItemAlbum *album = static_cast<const MusicLibraryItemAlbum *>(al);
-            QString albumGenre=Song::combineGenres(album->genres());
             writer.writeStartElement(constAlbumElement);
-            writer.writeAttribute(constNameAttribute, album->originalName().isEmpty() ? album->data() : album->originalName());
-            writer.writeAttribute(constYearAttribute, QString::number(album->year()));
-            if (!albumGenre.isEmpty() && albumGenre!=Song::unknown()) {
-                writer.writeAttribute(constGenreAttribute, albumGenre);
+            writer.writeAttribute(constNameAttribute, album.name);
+            writer.writeAttribute(constYearAttribute, QString::number(album.year));
+            if (!album.genre.isEmpty() && album.genre!=Song::unknown()) {
+                writer.writeAttribute(constGenreAttribute, album.genre);
             }
-            if (album->isSingleTracks()) {
+            if (album.singleTracks) {
                 writer.writeAttribute(constSingleTracksAttribute, constTrueValue);
             }
-            if (!album->imageUrl().isEmpty()) {
-                writer.writeAttribute(constImageAttribute, album->imageUrl());
+            if (!album.imageUrl.isEmpty()) {
+                writer.writeAttribute(constImageAttribute, album.imageUrl);
             }
-            if (!album->id().isEmpty()) {
-                writer.writeAttribute(constMbIdAttribute, album->id());
+            if (!album.id.isEmpty()) {
+                writer.writeAttribute(constMbIdAttribute, album.id);
             }
-            if (album->hasSort()) {
-                writer.writeAttribute(constSortAttribute, album->sortString());
+            if (!album.sort.isEmpty()) {
+                writer.writeAttribute(constSortAttribute, album.sort);
             }
-            QString artistName=artist->actualArtist().isEmpty() ? artist->data() : artist->actualArtist();
 
-            foreach (const MusicLibraryItem *t, album->childItems()) {
-                const MusicLibraryItemSong *track = static_cast<const MusicLibraryItemSong *>(t);
+            foreach (const Song &song, album.tracks) {
                 writer.writeEmptyElement(constTrackElement);
-                if (!track->song().title.isEmpty()) {
-                    writer.writeAttribute(constNameAttribute, track->song().title);
+                if (!song.title.isEmpty()) {
+                    writer.writeAttribute(constNameAttribute, song.title);
                 }
-                writer.writeAttribute(constFileAttribute, track->file());
-                if (0!=track->time()) {
-                    writer.writeAttribute(constTimeAttribute, QString::number(track->time()));
+                writer.writeAttribute(constFileAttribute, song.file);
+                if (0!=song.time) {
+                    writer.writeAttribute(constTimeAttribute, QString::number(song.time));
                 }
                 //Only write track number if it is set
-                if (track->track() != 0) {
-                    writer.writeAttribute(constTrackAttribute, QString::number(track->track()));
+                if (song.track != 0) {
+                    writer.writeAttribute(constTrackAttribute, QString::number(song.track));
                 }
-                if (track->disc() != 0) {
-                    writer.writeAttribute(constDiscAttribute, QString::number(track->disc()));
+                if (song.disc != 0) {
+                    writer.writeAttribute(constDiscAttribute, QString::number(song.disc));
                 }
-                if (!track->song().artist.isEmpty() && track->song().artist!=artistName) {
-                    writer.writeAttribute(constArtistAttribute, track->song().artist);
+                if (!song.artist.isEmpty() && song.artist!=artistName) {
+                    writer.writeAttribute(constArtistAttribute, song.artist);
                 }
-                if (supportsAlbumArtist && track->song().albumartist!=artistName) {
-                    writer.writeAttribute(constAlbumArtistAttribute, track->song().albumartist);
+                if (supportsAlbumArtist && song.albumartist!=artistName) {
+                    writer.writeAttribute(constAlbumArtistAttribute, song.albumartist);
                 }
-                if (!track->song().composer().isEmpty()) {
-                    writer.writeAttribute(constComposerAttribute, track->song().composer());
+                if (!song.composer().isEmpty()) {
+                    writer.writeAttribute(constComposerAttribute, song.composer());
                 }
-                QString trackGenre=track->multipleGenres() ? Song::combineGenres(track->allGenres()) : track->genre();
-                if (!trackGenre.isEmpty() && trackGenre!=albumGenre && trackGenre!=Song::unknown()) {
-                    writer.writeAttribute(constGenreAttribute, track->song().genre);
+                QStringList genres=song.genres();
+                QString trackGenre=genres.count()>1 ? Song::combineGenres(genres.toSet()) : song.genre;
+                if (!trackGenre.isEmpty() && trackGenre!=album.genre && trackGenre!=Song::unknown()) {
+                    writer.writeAttribute(constGenreAttribute, song.genre);
                 }
-                if (album->isSingleTracks()) {
-                    writer.writeAttribute(constAlbumAttribute, track->song().album);
+                if (album.singleTracks) {
+                    writer.writeAttribute(constAlbumAttribute, song.album);
                 }
-                if (Song::Playlist==track->song().type) {
+                if (Song::Playlist==song.type) {
                     writer.writeAttribute(constPlaylistAttribute, constTrueValue);
                 }
-                if (track->song().year != album->year()) {
-                    writer.writeAttribute(constYearAttribute, QString::number(track->song().year));
+                if (song.year != album.year) {
+                    writer.writeAttribute(constYearAttribute, QString::number(song.year));
                 }
-                if (track->song().guessed) {
+                if (song.guessed) {
                     writer.writeAttribute(constGuessedAttribute, constTrueValue);
                 }
-                if (prog && !prog->wasStopped() && total>0) {
+                if (prog && !prog->wasStopped() && numTracks>0) {
                     count++;
-                    int pc=((count*100.0)/(total*1.0))+0.5;
+                    int pc=((count*100.0)/(numTracks*1.0))+0.5;
                     if (pc!=percent && timer.elapsed()>=250) {
                         prog->writeProgress(pc);
                         timer.restart();
@@ -411,6 +471,20 @@ void MusicLibraryItemRoot::toXML(QXmlStreamWriter &writer, const QDateTime &date
     writer.writeEndDocument();
 }
 
+CacheSnapshot * MusicLibraryItemRoot::snapshot(const QDateTime &date, bool dateUnreliable) const
+{
+    return new MusicLibraryCacheSnapshot(this, date, dateUnreliable, supportsAlbumArtist);
+}
+
+void MusicLibraryItemRoot::toXML(QXmlStreamWriter &writer, const QDateTime &date, bool dateUnreliable, MusicLibraryProgressMonitor *prog) const
+{
+    if (isFlat) {
+        return;
+    }
+
+    MusicLibraryCacheSnapshot(this, date, dateUnreliable, supportsAlbumArtist).write(writer, prog);
+}
+
 quint32 MusicLibraryItemRoot::fromXML(const QString &filename, const QDateTime &date, bool *dateUnreliable, const QString &baseFolder, MusicLibraryProgressMonitor *prog, MusicLibraryErrorMonitor *em)
 {
     if (isFlat) {
@@ -43,6 +43,7 @@ class QXmlStreamReader;
 class QXmlStreamWriter;
 class MusicLibraryItemArtist;
 class MusicModel;
+class CacheSnapshot;
 
 class MusicLibraryErrorMonitor
 {
@@ -87,6 +88,8 @@ public:
     QSet<Song> allSongs(bool revertVa=false) const;
     void getDetails(QSet<QString> &artists, QSet<QString> &albumArtists, QSet<QString> &composers, QSet<QString> &albums, QSet<QString> &genres);
     void updateSongFile(const Song &from, const Song &to);
+    // Copy of the tree, for saving to the cache on another thread.
+    CacheSnapshot * snapshot(const QDateTime &date, bool dateUnreliable) const;
     void toXML(const QString &filename, const QDateTime &date=QDateTime(), bool dateUnreliable=false, MusicLibraryProgressMonitor *prog=0) const;
     void toXML(QXmlStreamWriter &writer, const QDateTime &date=QDateTime(), bool dateUnreliable=false, MusicLibraryProgressMonitor *prog=0) const;
     quint32 fromXML(const QString &filename, const QDateTime &date=QDateTime(), bool *dateUnreliable=0, const QString &baseFolder=QString(), MusicLibraryProgressMonitor *prog=0, MusicLibraryErrorMonitor *em=0);
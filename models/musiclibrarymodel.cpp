@@ -32,11 +32,13 @@
 #include "albumsmodel.h"
 #include "playqueuemodel.h"
 #include "dirviewmodel.h"
+#include "cachewriter.h"
 #include "config.h"
 #include "roles.h"
 #include "gui/covers.h"
 #include "mpd-interface/mpdparseutils.h"
 #include "mpd-interface/mpdconnection.h"
+#include "mpd-interface/cuecache.h"
 #include "support/localize.h"
 #include "support/utils.h"
 #include "widgets/icons.h"
@@ -120,6 +122,8 @@ void MusicLibraryModel::cleanCache()
         fileName=fileName.left(fileName.length()-QString(constLibraryCompressedExt).length());
         fileName+=DirViewModel::constCacheName+(constLibraryCompressedExt);
         existing.insert(fileName);
+        // Cue file cache...
+        existing.insert(CueCache::cacheFileName(conn).mid(dirPath.length()));
     }
     QFileInfoList files=QDir(dirPath).entryInfoList(QStringList() << "*"+constLibraryExt << "*"+constLibraryCompressedExt, QDir::Files);
     foreach (const QFileInfo &file, files) {
@@ -416,9 +420,7 @@ QModelIndex MusicLibraryModel::findAlbumIndex(const QString &artist, const QStri
 void MusicLibraryModel::removeCache()
 {
     QString cacheFile(cacheFileName());
-    if (QFile::exists(cacheFile)) {
-        QFile::remove(cacheFile);
-    }
+    CacheWriter::self()->remove(cacheFile);
 
     // Remove old (non-compressed) cache file as well...
     QString cacheFileWithoutPort(cacheFileName(false));
@@ -488,7 +490,7 @@ void MusicLibraryModel::updateMusicLibrary(MusicLibraryItemRoot *newroot, QDateT
     bool needToSave=!databaseTime.isValid() || (validCacheDate(dbUpdate) && dbUpdate>databaseTime);
     bool incremental=rootItem->childCount() && newroot->childCount();
 
-    if (incremental && !QFile::exists(cacheFileName())) {
+    if (incremental && !CacheWriter::self()->exists(cacheFileName())) {
         incremental=false;
     }
 
@@ -523,7 +525,7 @@ void MusicLibraryModel::updateMusicLibrary(MusicLibraryItemRoot *newroot, QDateT
     }
 
     if (!fromFile && (needToSave || updatedSongs)) {
-        rootItem->toXML(cacheFileName(), databaseTime, databaseTimeUnreliable);
+        CacheWriter::self()->save(cacheFileName(), rootItem->snapshot(databaseTime, databaseTimeUnreliable));
     }
 
     AlbumsModel::self()->update(rootItem, incremental);
@@ -666,7 +668,7 @@ void MusicLibraryModel::toggleGrouping()
 {
     beginResetModel();
     rootItem->toggleGrouping();
-    rootItem->toXML(cacheFileName(), databaseTime, databaseTimeUnreliable);
+    CacheWriter::self()->save(cacheFileName(), rootItem->snapshot(databaseTime, databaseTimeUnreliable));
     endResetModel();
     if (mpdModel) {
         AlbumsModel::self()->update(rootItem, false);
@@ -806,6 +808,7 @@ bool MusicLibraryModel::fromXML()
         QFile::rename(withoutPort, withPort);
     }
 
+    CacheWriter::recover(cacheFileName());
     convertCache(cacheFileName());
     MusicLibraryItemRoot *root=new MusicLibraryItemRoot;
     quint32 date=root->fromXML(cacheFileName(), MPDStats::self()->dbUpdate(), &databaseTimeUnreliable, QString(), 0, this);
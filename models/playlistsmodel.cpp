@@ -84,7 +84,7 @@ PlaylistsModel::PlaylistsModel(QObject *parent)
 {
     connect(MPDConnection::self(), SIGNAL(stateChanged(bool)), SLOT(mpdConnectionStateChanged(bool)));
     connect(MPDConnection::self(), SIGNAL(playlistsRetrieved(const QList<Playlist> &)), this, SLOT(setPlaylists(const QList<Playlist> &)));
-    connect(MPDConnection::self(), SIGNAL(playlistInfoRetrieved(const QString &, const QList<Song> &)), this, SLOT(playlistInfoRetrieved(const QString &, const QList<Song> &)));
+    connect(MPDConnection::self(), SIGNAL(playlistInfoRetrieved(const QString &, const QList<Song> &, int, bool)), this, SLOT(playlistInfoRetrieved(const QString &, const QList<Song> &, int, bool)));
     connect(MPDConnection::self(), SIGNAL(removedFromPlaylist(const QString &, const QList<quint32> &)),
             this, SLOT(removedFromPlaylist(const QString &, const QList<quint32> &)));
     connect(MPDConnection::self(), SIGNAL(playlistRenamed(const QString &, const QString &)),
@@ -153,8 +153,7 @@ void PlaylistsModel::fetchMore(const QModelIndex &index)
     }
     Item *item=static_cast<Item *>(index.internalPointer());
     if (item->isPlaylist() && !static_cast<PlaylistItem *>(item)->loaded) {
-        static_cast<PlaylistItem *>(item)->loaded=true;
-        emit playlistInfo(static_cast<PlaylistItem *>(item)->name);
+        requestSongs(static_cast<PlaylistItem *>(item));
     }
 }
 
@@ -287,8 +286,7 @@ QVariant PlaylistsModel::data(const QModelIndex &index, int role) const
             return pl->totalTime();
         case Cantata::Role_SongCount:
             if (!pl->loaded) {
-                pl->loaded=true;
-                emit playlistInfo(pl->name);
+                requestSongs(pl);
             }
             return pl->songs.count();
         case Cantata::Role_CurrentStatus:
@@ -313,8 +311,7 @@ QVariant PlaylistsModel::data(const QModelIndex &index, int role) const
                     return QVariant();
                 case COL_LENGTH:
                     if (!pl->loaded) {
-                        pl->loaded=true;
-                        emit playlistInfo(pl->name);
+                        requestSongs(pl);
                     }
                     return pl->loaded && !pl->isSmartPlaylist ? Utils::formatTime(pl->totalTime()) : QVariant();
                 case COL_YEAR:
@@ -330,8 +327,7 @@ QVariant PlaylistsModel::data(const QModelIndex &index, int role) const
                 return QVariant();
             }
             if (!pl->loaded) {
-                pl->loaded=true;
-                emit playlistInfo(pl->name);
+                requestSongs(pl);
             }
             return 0==pl->songs.count()
                 ? pl->visibleName()
@@ -342,8 +338,7 @@ QVariant PlaylistsModel::data(const QModelIndex &index, int role) const
         #endif
         case Cantata::Role_SubText:
             if (!pl->loaded) {
-                pl->loaded=true;
-                emit playlistInfo(pl->name);
+                requestSongs(pl);
             }
             if (pl->isSmartPlaylist) {
                 return i18n("Smart Playlist");
@@ -684,6 +679,7 @@ void PlaylistsModel::getPlaylists()
 void PlaylistsModel::clear()
 {
     beginResetModel();
+    cacheSongs();
     clearPlaylists();
     updateItemMenu();
     endResetModel();
@@ -721,21 +717,31 @@ void PlaylistsModel::setPlaylists(const QList<Playlist> &playlists)
 
     if (items.isEmpty()) {
         if (playlists.isEmpty()) {
+            songCache.clear();
             return;
         }
+        if (!songCache.isEmpty() && cacheDetails!=MPDConnection::self()->getDetails()) {
+            songCache.clear();
+        }
         beginResetModel();
         foreach (const Playlist &p, playlists) {
             if (p.name!=StreamsModel::constPlayListName) {
-                items.append(new PlaylistItem(p, allocateKey()));
+                PlaylistItem *pl=new PlaylistItem(p, allocateKey());
+                restoreSongs(pl);
+                items.append(pl);
             }
         }
+        // Anything left in the cache is for playlists that have since been modified, or removed.
+        songCache.clear();
         endResetModel();
+        updateGenreList();
         updateItemMenu();
         #ifdef ENABLE_UBUNTU
         emit updated();
         #endif
     } else if (playlists.isEmpty()) {
         clear();
+        songCache.clear();
         #ifdef ENABLE_UBUNTU
         emit updated();
         #endif
@@ -760,7 +766,7 @@ void PlaylistsModel::setPlaylists(const QList<Playlist> &playlists)
             if (pl && pl->lastModified<p.lastModified) {
                 pl->lastModified=p.lastModified;
                 if (pl->loaded && !pl->isSmartPlaylist) {
-                    emit playlistInfo(pl->name);
+                    requestSongs(pl);
                 }
             }
         }
@@ -776,6 +782,7 @@ void PlaylistsModel::setPlaylists(const QList<Playlist> &playlists)
                     beginRemoveRows(parent, index, index);
                     usedKeys.remove(pl->key);
                     emit playlistRemoved(pl->key);
+                    pendingSongs.remove(pl->name);
                     delete items.takeAt(index);
                     endRemoveRows();
                 }
@@ -801,28 +808,62 @@ void PlaylistsModel::setPlaylists(const QList<Playlist> &playlists)
     }
 }
 
-void PlaylistsModel::playlistInfoRetrieved(const QString &name, const QList<Song> &songs)
+void PlaylistsModel::playlistInfoRetrieved(const QString &name, const QList<Song> &songs, int start, bool complete)
 {
     PlaylistItem *pl=getPlaylist(name);
 
-    if (pl) {
-        QModelIndex idx=createIndex(items.indexOf(pl), 0, pl);
+    if (!pl) {
+        pendingSongs.remove(name);
+        if (0==start) {
+            emit listPlaylists();
+        }
+        return;
+    }
+
+    if (0==start) {
+        // If the playlist has no songs, then each page is shown as it arrives. Otherwise, pages are
+        // collected so that the current songs can be updated in one go once all have been received.
         if (pl->songs.isEmpty()) {
-            if (songs.isEmpty()) {
-                return;
-            }
-            beginInsertRows(idx, 0, songs.count()-1);
+            pendingSongs.remove(name);
+        } else {
+            pendingSongs.insert(name, QList<Song>());
+        }
+    }
+
+    QModelIndex idx=createIndex(items.indexOf(pl), 0, pl);
+    QMap<QString, QList<Song> >::Iterator pending=pendingSongs.find(name);
+    if (pending==pendingSongs.end()) {
+        // Ignore pages that do not follow on from the songs we have - e.g. if the playlists were
+        // cleared, and re-read, whilst this playlist was being loaded.
+        if (start!=pl->songs.count()) {
+            return;
+        }
+        if (!songs.isEmpty()) {
+            beginInsertRows(idx, pl->songs.count(), pl->songs.count()+songs.count()-1);
             foreach (const Song &s, songs) {
-                pl->songs.append(new SongItem(s, pl));
+                SongItem *si=new SongItem(s, pl);
+                if (!si->genre.isEmpty()) {
+                    pl->genres+=si->allGenres();
+                }
+                pl->songs.append(si);
             }
             endInsertRows();
-        } else if (songs.isEmpty()) {
+        }
+    } else {
+        pending.value()+=songs;
+        if (!complete) {
+            return;
+        }
+        QList<Song> allSongs=pending.value();
+        pendingSongs.erase(pending);
+
+        if (allSongs.isEmpty()) {
             beginRemoveRows(idx, 0, pl->songs.count()-1);
             pl->clearSongs();
             endRemoveRows();
         } else {
-            for (qint32 i=0; i<songs.count(); ++i) {
-                Song s=songs.at(i);
+            for (qint32 i=0; i<allSongs.count(); ++i) {
+                Song s=allSongs.at(i);
                 SongItem *si=i<pl->songs.count() ? pl->songs.at(i) : 0;
                 if (i>=pl->songs.count() || !(s==*static_cast<Song *>(si))) {
                     si=i<pl->songs.count() ? pl->getSong(s, i) : 0;
@@ -843,8 +884,8 @@ void PlaylistsModel::playlistInfoRetrieved(const QString &name, const QList<Song
                 }
             }
 
-            if (pl->songs.count()>songs.count()) {
-                int toRemove=pl->songs.count()-songs.count();
+            if (pl->songs.count()>allSongs.count()) {
+                int toRemove=pl->songs.count()-allSongs.count();
                 beginRemoveRows(idx, pl->songs.count()-toRemove, pl->songs.count()-1);
                 for (int i=0; i<toRemove; ++i) {
                     delete pl->songs.takeLast();
@@ -853,11 +894,14 @@ void PlaylistsModel::playlistInfoRetrieved(const QString &name, const QList<Song
             }
         }
         pl->updateGenres();
-        emit updated(idx);
-        emit dataChanged(idx, idx);
-    } else {
-        emit listPlaylists();
     }
+
+    if (complete) {
+        pl->loading=false;
+    }
+    pl->time=0;
+    emit updated(idx);
+    emit dataChanged(idx, idx);
     updateGenreList();
 }
 
@@ -1019,6 +1063,46 @@ PlaylistsModel::PlaylistItem * PlaylistsModel::getPlaylist(const QString &name)
     return 0;
 }
 
+void PlaylistsModel::requestSongs(PlaylistItem *pl) const
+{
+    pl->loaded=true;
+    pl->loading=true;
+    emit playlistInfo(pl->name);
+}
+
+// Keep a copy of the songs of each loaded playlist, so that these do not need to be re-read from MPD
+// when the playlists are next listed - as long as the playlist's Last-Modified time has not changed.
+void PlaylistsModel::cacheSongs()
+{
+    songCache.clear();
+    cacheDetails=MPDConnection::self()->getDetails();
+    foreach (PlaylistItem *p, items) {
+        if (p->loaded && !p->loading && !p->isSmartPlaylist && p->lastModified.isValid()) {
+            CachedPlaylist &cached=songCache[p->name];
+            cached.lastModified=p->lastModified;
+            foreach (const SongItem *s, p->songs) {
+                cached.songs.append(*s);
+            }
+        }
+    }
+}
+
+void PlaylistsModel::restoreSongs(PlaylistItem *pl)
+{
+    QMap<QString, CachedPlaylist>::Iterator it=songCache.find(pl->name);
+    if (it==songCache.end()) {
+        return;
+    }
+    if (!pl->isSmartPlaylist && pl->lastModified==it.value().lastModified) {
+        foreach (const Song &s, it.value().songs) {
+            pl->songs.append(new SongItem(s, pl));
+        }
+        pl->loaded=true;
+        pl->updateGenres();
+    }
+    songCache.erase(it);
+}
+
 void PlaylistsModel::clearPlaylists()
 {
     foreach (PlaylistItem *p, items) {
@@ -1028,6 +1112,7 @@ void PlaylistsModel::clearPlaylists()
 
     qDeleteAll(items);
     items.clear();
+    pendingSongs.clear();
     updateGenreList();
 }
 
@@ -1070,6 +1155,7 @@ PlaylistsModel::SongItem::SongItem(const Song &s, PlaylistItem *p)
 
 PlaylistsModel::PlaylistItem::PlaylistItem(const Playlist &pl, quint32 k)
     : name(pl.name)
+    , loading(false)
     , time(0)
     , key(k)
     , lastModified(pl.lastModified)
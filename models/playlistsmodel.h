@@ -33,6 +33,7 @@
 #include <QMap>
 #include "mpd-interface/playlist.h"
 #include "mpd-interface/song.h"
+#include "mpd-interface/mpdconnection.h"
 #include "actionmodel.h"
 
 class QMenu;
@@ -78,7 +79,7 @@ public:
 
     struct PlaylistItem : public Item
     {
-        PlaylistItem(quint32 k) : loaded(false), isSmartPlaylist(false), time(0), key(k) { }
+        PlaylistItem(quint32 k) : loaded(false), loading(false), isSmartPlaylist(false), time(0), key(k) { }
         PlaylistItem(const Playlist &pl, quint32 k);
         virtual ~PlaylistItem();
         bool isPlaylist() { return true; }
@@ -90,6 +91,7 @@ public:
         QString name;
         QString shortName;
         bool loaded;
+        bool loading; // Songs have been requested, but not all have been received
         bool isSmartPlaylist;
         QList<SongItem *> songs;
         QSet<QString> genres;
@@ -156,7 +158,7 @@ Q_SIGNALS:
 
 private Q_SLOTS:
     void setPlaylists(const QList<Playlist> &playlists);
-    void playlistInfoRetrieved(const QString &name, const QList<Song> &songs);
+    void playlistInfoRetrieved(const QString &name, const QList<Song> &songs, int start, bool complete);
     void removedFromPlaylist(const QString &name, const QList<quint32> &positions);
     void movedInPlaylist(const QString &name, const QList<quint32> &idx, quint32 pos);
     void emitAddToExisting();
@@ -168,13 +170,24 @@ private:
     void updateGenreList();
     void updateItemMenu(bool craete=false);
     PlaylistItem * getPlaylist(const QString &name);
+    void requestSongs(PlaylistItem *pl) const;
+    void cacheSongs();
+    void restoreSongs(PlaylistItem *pl);
     void clearPlaylists();
     quint32 allocateKey();
 
 private:
+    struct CachedPlaylist {
+        QDateTime lastModified;
+        QList<Song> songs;
+    };
+
     bool enabled;
     bool multiCol;
     QList<PlaylistItem *> items;
+    QMap<QString, QList<Song> > pendingSongs; // Pages received whilst updating a playlist that already has songs
+    QMap<QString, CachedPlaylist> songCache;
+    MPDConnectionDetails cacheDetails;
     QSet<quint32> usedKeys;
     QSet<QString> plGenres;
     #ifndef ENABLE_UBUNTU
@@ -222,6 +222,7 @@ PlayQueueModel::PlayQueueModel(QObject *parent)
     connect(this, SIGNAL(getRating(QString)), MPDConnection::self(), SLOT(getRating(QString)));
     connect(this, SIGNAL(setRating(QStringList,quint8)), MPDConnection::self(), SLOT(setRating(QStringList,quint8)));
     connect(MPDConnection::self(), SIGNAL(rating(QString,quint8)), SLOT(ratingResult(QString,quint8)));
+    connect(MPDConnection::self(), SIGNAL(ratings(QStringList,QList<quint8>)), SLOT(ratingsResult(QStringList,QList<quint8>)));
     connect(MPDConnection::self(), SIGNAL(stickerDbChanged()), SLOT(stickerDbChanged()));
     #ifdef ENABLE_DEVICES_SUPPORT //TODO: Problems here with devices support!!!
     connect(DevicesModel::self(), SIGNAL(invalid(QList<Song>)), SLOT(remove(QList<Song>)));
@@ -1343,6 +1344,31 @@ void PlayQueueModel::ratingResult(const QString &file, quint8 r)
     }
 }
 
+void PlayQueueModel::ratingsResult(const QStringList &files, const QList<quint8> &vals)
+{
+    QHash<QString, quint8> ratings;
+    for (int i=0; i<files.count() && i<vals.count(); ++i) {
+        ratings.insert(files.at(i), vals.at(i));
+    }
+
+    QList<Song>::iterator it=songs.begin();
+    QList<Song>::iterator end=songs.end();
+    int numCols=columnCount(QModelIndex())-1;
+
+    for (int row=0; it!=end; ++it, ++row) {
+        if (Song::Standard==(*it).type) {
+            QHash<QString, quint8>::ConstIterator r=ratings.find((*it).file);
+            if (ratings.constEnd()!=r && r.value()!=(*it).rating) {
+                (*it).rating=r.value();
+                emit dataChanged(index(row, 0), index(row, numCols));
+                if ((*it).id==currentSongId) {
+                    emit currentSongRating((*it).file, r.value());
+                }
+            }
+        }
+    }
+}
+
 void PlayQueueModel::stickerDbChanged()
 {
     // Sticker DB changed, need to re-request ratings...
@@ -164,6 +164,7 @@ private Q_SLOTS:
     void redo();
     void removeDuplicates();
     void ratingResult(const QString &file, quint8 r);
+    void ratingsResult(const QStringList &files, const QList<quint8> &vals);
     void stickerDbChanged();
     // Touch version...
     void setCover(const Song &song, const QImage &img, const QString &file);
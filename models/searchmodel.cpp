@@ -34,6 +34,7 @@
 #include <QMimeData>
 #include <QLocale>
 #include <QUrl>
+#include <QHash>
 #if QT_VERSION >= 0x050000
 #include <QUrlQuery>
 #endif
@@ -65,11 +66,14 @@ SearchModel::SearchModel(QObject *parent)
     : ActionModel(parent)
     , multiCol(false)
     , currentId(0)
+    , partialResults(false)
 {
     connect(this, SIGNAL(getRating(QString)), MPDConnection::self(), SLOT(getRating(QString)));
     connect(this, SIGNAL(search(QString,QString,int)), MPDConnection::self(), SLOT(search(QString,QString,int)));
-    connect(MPDConnection::self(), SIGNAL(searchResponse(int,QList<Song>)), this, SLOT(searchFinished(int,QList<Song>)));
+    connect(this, SIGNAL(cancelSearch()), MPDConnection::self(), SLOT(cancelSearch()));
+    connect(MPDConnection::self(), SIGNAL(searchResponse(int,QList<Song>,bool)), this, SLOT(searchFinished(int,QList<Song>,bool)));
     connect(MPDConnection::self(), SIGNAL(rating(QString,quint8)), SLOT(ratingResult(QString,quint8)));
+    connect(MPDConnection::self(), SIGNAL(ratings(QStringList,QList<quint8>)), SLOT(ratingsResult(QStringList,QList<quint8>)));
     #ifndef ENABLE_UBUNTU
     connect(Covers::self(), SIGNAL(loaded(Song,int)), this, SLOT(coverLoaded(Song,int)));
     alignments[COL_TITLE]=alignments[COL_ARTIST]=alignments[COL_ALBUM]=alignments[COL_GENRE]=alignments[COL_COMPOSER]=alignments[COL_PERFORMER]=int(Qt::AlignVCenter|Qt::AlignLeft);
@@ -324,6 +328,8 @@ void SearchModel::clear()
     }
     currentKey=currentValue=QString();
     currentId++;
+    partialResults=false;
+    emit cancelSearch();
     emit statsUpdated(0, 0);
 }
 
@@ -340,16 +346,30 @@ void SearchModel::search(const QString &key, const QString &value)
     emit search(key, value, currentId);
 }
 
-void SearchModel::searchFinished(int id, const QList<Song> &result)
+void SearchModel::searchFinished(int id, const QList<Song> &result, bool complete)
 {
     if (id!=currentId) {
         return;
     }
 
-    beginResetModel();
-    songList.clear();
-    songList=result;
-    endResetModel();
+    // Large searches are returned in windows, each of which is sorted. Append these as they arrive, and
+    // then sort the whole list once all have been received.
+    if (!result.isEmpty()) {
+        beginInsertRows(QModelIndex(), songList.count(), songList.count()+result.count()-1);
+        songList+=result;
+        endInsertRows();
+    }
+
+    if (!complete) {
+        partialResults=true;
+        return;
+    }
+
+    if (partialResults) {
+        sortSongs();
+        partialResults=false;
+    }
+
     quint32 time=0;
     foreach (const Song &s, songList) {
         time+=s.time;
@@ -359,6 +379,29 @@ void SearchModel::searchFinished(int id, const QList<Song> &result)
     emit searched();
 }
 
+void SearchModel::sortSongs()
+{
+    emit layoutAboutToBeChanged();
+    QModelIndexList oldIndexes=persistentIndexList();
+    QStringList oldFiles;
+    foreach (const QModelIndex &idx, oldIndexes) {
+        oldFiles.append(songList.at(idx.row()).file);
+    }
+    qSort(songList);
+    if (!oldIndexes.isEmpty()) {
+        QHash<QString, int> rows;
+        for (int i=0; i<songList.count(); ++i) {
+            rows.insert(songList.at(i).file, i);
+        }
+        QModelIndexList newIndexes;
+        for (int i=0; i<oldIndexes.count(); ++i) {
+            newIndexes.append(index(rows.value(oldFiles.at(i)), oldIndexes.at(i).column()));
+        }
+        changePersistentIndexList(oldIndexes, newIndexes);
+    }
+    emit layoutChanged();
+}
+
 void SearchModel::coverLoaded(const Song &song, int s)
 {
     Q_UNUSED(s)
@@ -391,3 +434,25 @@ void SearchModel::ratingResult(const QString &file, quint8 r)
         }
     }
 }
+
+void SearchModel::ratingsResult(const QStringList &files, const QList<quint8> &vals)
+{
+    QHash<QString, quint8> ratings;
+    for (int i=0; i<files.count() && i<vals.count(); ++i) {
+        ratings.insert(files.at(i), vals.at(i));
+    }
+
+    QList<Song>::iterator it=songList.begin();
+    QList<Song>::iterator end=songList.end();
+    int numCols=columnCount(QModelIndex())-1;
+
+    for (int row=0; it!=end; ++it, ++row) {
+        if (Song::Standard==(*it).type) {
+            QHash<QString, quint8>::ConstIterator r=ratings.find((*it).file);
+            if (ratings.constEnd()!=r && r.value()!=(*it).rating) {
+                (*it).rating=r.value();
+                emit dataChanged(index(row, 0), index(row, numCols));
+            }
+        }
+    }
+}
@@ -85,21 +85,25 @@ Q_SIGNALS:
     void statsUpdated(int songs, quint32 time);
 
     void search(const QString &field, const QString &value, int id);
+    void cancelSearch();
     void getRating(const QString &file) const;
 
 private Q_SLOTS:
-    void searchFinished(int id, const QList<Song> &result);
+    void searchFinished(int id, const QList<Song> &result, bool complete);
     void coverLoaded(const Song &song, int s);
     void ratingResult(const QString &file, quint8 r);
+    void ratingsResult(const QStringList &files, const QList<quint8> &vals);
 
 private:
     void clearItems();
+    void sortSongs();
     const Song * toSong(const QModelIndex &index) const { return index.isValid() ? static_cast<const Song *>(index.internalPointer()) : 0; }
 
 private:
     bool multiCol;
     QList<Song> songList;
     int currentId;
+    bool partialResults;
     QString currentKey;
     QString currentValue;
     #ifndef ENABLE_UBUNTU
@@ -0,0 +1,266 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2014 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#include "cuecache.h"
+#include "cuefile.h"
+#include "mpdconnection.h"
+#include "models/cachewriter.h"
+#include "models/musiclibrarymodel.h"
+#include "support/utils.h"
+#include "qtiocompressor/qtiocompressor.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+#include <QDebug>
+
+static bool debugIsEnabled=false;
+#define DBUG if (debugIsEnabled) qWarning() << "CueCache" << __FUNCTION__
+void CueCache::enableDebug()
+{
+    debugIsEnabled=true;
+}
+
+const QLatin1String CueCache::constCacheName("-cue-files");
+
+static const quint32 constVersion=1;
+static const QString constTopTag=QLatin1String("CueFiles");
+static const QString constCueTag=QLatin1String("CueFile");
+static const QString constTrackTag=QLatin1String("Track");
+static const QString constSourceTag=QLatin1String("Source");
+static const QString constVersionAttribute=QLatin1String("version");
+static const QString constNameAttribute=QLatin1String("name");
+static const QString constModifiedAttribute=QLatin1String("modified");
+static const QString constOkAttribute=QLatin1String("ok");
+static const QString constFileAttribute=QLatin1String("file");
+static const QString constSourceAttribute=QLatin1String("source");
+static const QString constTitleAttribute=QLatin1String("title");
+static const QString constArtistAttribute=QLatin1String("artist");
+static const QString constAlbumArtistAttribute=QLatin1String("albumartist");
+static const QString constAlbumAttribute=QLatin1String("album");
+static const QString constComposerAttribute=QLatin1String("composer");
+static const QString constGenreAttribute=QLatin1String("genre");
+static const QString constYearAttribute=QLatin1String("year");
+static const QString constTrackAttribute=QLatin1String("track");
+static const QString constTimeAttribute=QLatin1String("time");
+static const QString constTrueValue=QLatin1String("true");
+
+// Written on the calling (MPD bulk) thread, so a copy of the entries is not required.
+class CueCacheSnapshot : public CacheSnapshot
+{
+public:
+    CueCacheSnapshot(const QMap<QString, CueCache::Entry> &e) : entries(e) { }
+    void write(QXmlStreamWriter &writer) const;
+
+private:
+    const QMap<QString, CueCache::Entry> &entries;
+};
+
+static void writeAttribute(QXmlStreamWriter &writer, const QString &name, const QString &value)
+{
+    if (!value.isEmpty()) {
+        writer.writeAttribute(name, value);
+    }
+}
+
+static void writeAttribute(QXmlStreamWriter &writer, const QString &name, quint32 value)
+{
+    if (0!=value) {
+        writer.writeAttribute(name, QString::number(value));
+    }
+}
+
+void CueCacheSnapshot::write(QXmlStreamWriter &writer) const
+{
+    writer.writeStartDocument();
+    writer.writeStartElement(constTopTag);
+    writer.writeAttribute(constVersionAttribute, QString::number(constVersion));
+    QMap<QString, CueCache::Entry>::ConstIterator it=entries.constBegin();
+    QMap<QString, CueCache::Entry>::ConstIterator end=entries.constEnd();
+    for (; it!=end; ++it) {
+        const CueCache::Entry &entry=it.value();
+        if (!entry.used) {
+            continue;
+        }
+        writer.writeStartElement(constCueTag);
+        writer.writeAttribute(constNameAttribute, it.key());
+        writer.writeAttribute(constModifiedAttribute, QString::number(entry.modified));
+        if (entry.ok) {
+            writer.writeAttribute(constOkAttribute, constTrueValue);
+        }
+        foreach (const Song &song, entry.songs) {
+            writer.writeEmptyElement(constTrackTag);
+            writer.writeAttribute(constFileAttribute, song.file);
+            writeAttribute(writer, constSourceAttribute, song.name()); // CueFile places source file name here
+            writeAttribute(writer, constTitleAttribute, song.title);
+            writeAttribute(writer, constArtistAttribute, song.artist);
+            writeAttribute(writer, constAlbumArtistAttribute, song.albumartist);
+            writeAttribute(writer, constAlbumAttribute, song.album);
+            writeAttribute(writer, constComposerAttribute, song.composer());
+            writeAttribute(writer, constGenreAttribute, song.genre);
+            writeAttribute(writer, constYearAttribute, song.year);
+            writeAttribute(writer, constTrackAttribute, song.track);
+            writeAttribute(writer, constTimeAttribute, song.time);
+        }
+        foreach (const QString &file, entry.files) {
+            writer.writeEmptyElement(constSourceTag);
+            writer.writeAttribute(constNameAttribute, file);
+        }
+        writer.writeEndElement();
+    }
+    writer.writeEndElement();
+    writer.writeEndDocument();
+}
+
+QString CueCache::cacheFileName(const MPDConnectionDetails &details)
+{
+    QString fileName=(!details.isLocal() ? details.hostname+'_'+QString::number(details.port) : details.hostname)
+                     +constCacheName+MusicLibraryModel::constLibraryCompressedExt;
+    fileName.replace('/', '_');
+    fileName.replace('~', '_');
+    return Utils::cacheDir(MusicLibraryModel::constLibraryCache)+fileName;
+}
+
+CueCache::CueCache(const QString &f)
+    : fileName(f)
+    , changed(false)
+{
+    load();
+}
+
+CueCache::Status CueCache::parse(const QString &cueFile, const QString &dir, QList<Song> &songs, QSet<QString> &files)
+{
+    QFileInfo info(dir+cueFile);
+    if (!info.exists()) {
+        return NotFound;
+    }
+
+    uint modified=info.lastModified().toTime_t();
+    QMap<QString, Entry>::Iterator it=entries.find(cueFile);
+    if (it==entries.end() || it.value().modified!=modified) {
+        DBUG << "Parsing cue file:" << cueFile << "mpdDir:" << dir;
+        Entry entry;
+        entry.modified=modified;
+        entry.ok=CueFile::parse(cueFile, dir, entry.songs, entry.files);
+        it=entries.insert(cueFile, entry);
+        changed=true;
+    } else {
+        DBUG << "Using cached cue file:" << cueFile;
+    }
+
+    Entry &entry=it.value();
+    entry.used=true;
+    if (!entry.ok) {
+        return Failed;
+    }
+    songs=entry.songs;
+    files=entry.files;
+    return Parsed;
+}
+
+void CueCache::save()
+{
+    if (fileName.isEmpty()) {
+        return;
+    }
+    if (!changed) {
+        // Also re-write the cache if some cue files have been removed.
+        foreach (const Entry &entry, entries) {
+            if (!entry.used) {
+                changed=true;
+                break;
+            }
+        }
+        if (!changed) {
+            return;
+        }
+    }
+    DBUG << fileName << entries.count();
+    if (CacheWriter::write(fileName, CueCacheSnapshot(entries))) {
+        changed=false;
+    }
+}
+
+void CueCache::load()
+{
+    if (fileName.isEmpty()) {
+        return;
+    }
+    CacheWriter::recover(fileName);
+    QFile file(fileName);
+    QtIOCompressor compressor(&file);
+    compressor.setStreamFormat(QtIOCompressor::GzipFormat);
+    if (!compressor.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QXmlStreamReader reader(&compressor);
+    Entry *entry=0;
+    while (!reader.atEnd()) {
+        reader.readNext();
+        if (reader.error()) {
+            DBUG << "failed to read" << fileName;
+            entries.clear();
+            break;
+        }
+        if (reader.isStartElement()) {
+            QString element = reader.name().toString();
+            QXmlStreamAttributes attributes=reader.attributes();
+
+            if (constTopTag==element) {
+                if (attributes.value(constVersionAttribute).toString().toUInt()<constVersion) {
+                    break;
+                }
+            } else if (constCueTag==element) {
+                entry=&entries[attributes.value(constNameAttribute).toString()];
+                entry->modified=attributes.value(constModifiedAttribute).toString().toUInt();
+                entry->ok=constTrueValue==attributes.value(constOkAttribute).toString();
+            } else if (entry && constTrackTag==element) {
+                Song song;
+                song.file=attributes.value(constFileAttribute).toString();
+                song.setName(attributes.value(constSourceAttribute).toString());
+                song.title=attributes.value(constTitleAttribute).toString();
+                song.artist=attributes.value(constArtistAttribute).toString();
+                song.albumartist=attributes.value(constAlbumArtistAttribute).toString();
+                song.album=attributes.value(constAlbumAttribute).toString();
+                QString composer=attributes.value(constComposerAttribute).toString();
+                if (!composer.isEmpty()) {
+                    song.setComposer(composer);
+                }
+                song.genre=attributes.value(constGenreAttribute).toString();
+                song.year=attributes.value(constYearAttribute).toString().toUInt();
+                song.track=attributes.value(constTrackAttribute).toString().toUInt();
+                song.time=attributes.value(constTimeAttribute).toString().toUInt();
+                entry->songs.append(song);
+            } else if (entry && constSourceTag==element) {
+                entry->files.insert(attributes.value(constNameAttribute).toString());
+            }
+        } else if (reader.isEndElement() && constCueTag==reader.name().toString()) {
+            entry=0;
+        }
+    }
+    compressor.close();
+    DBUG << fileName << entries.count();
+}
@@ -0,0 +1,78 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2014 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef CUE_CACHE_H
+#define CUE_CACHE_H
+
+#include <QMap>
+#include <QSet>
+#include <QList>
+#include <QString>
+#include "song.h"
+
+struct MPDConnectionDetails;
+
+// Results of parsing cue files, stored per connection and keyed on each cue file's path and
+// modification time. This way, unchanged cue files do not need to be re-read on each library load.
+class CueCache
+{
+public:
+    enum Status {
+        NotFound,
+        Failed,
+        Parsed
+    };
+
+    struct Entry {
+        Entry() : modified(0), ok(false), used(false) { }
+        uint modified;
+        bool ok;
+        bool used;
+        QList<Song> songs;
+        QSet<QString> files;
+    };
+
+    static void enableDebug();
+    static const QLatin1String constCacheName;
+    static QString cacheFileName(const MPDConnectionDetails &details);
+
+    // If fileName is empty, then results are not loaded or saved.
+    CueCache(const QString &f=QString());
+    ~CueCache() { }
+
+    // As CueFile::parse(), but re-uses the previous result if the cue file has not been modified.
+    Status parse(const QString &cueFile, const QString &dir, QList<Song> &songs, QSet<QString> &files);
+    // Writes the cache, if it has changed. Only cue files that have been looked up are kept.
+    void save();
+
+private:
+    void load();
+
+private:
+    QString fileName;
+    QMap<QString, Entry> entries;
+    bool changed;
+};
+
+#endif
@@ -41,9 +41,13 @@
 #include <QHostInfo>
 #include <QDateTime>
 #include <QPropertyAnimation>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
 #include "support/thread.h"
 #include "gui/settings.h"
 #include "cuefile.h"
+#include "cuecache.h"
 #if defined Q_OS_LINUX && defined QT_QTDBUS_FOUND
 #include "dbus/powermanagement.h"
 #elif defined Q_OS_MAC && defined IOKIT_FOUND
@@ -57,6 +61,41 @@ void MPDConnection::enableDebug()
     debugEnabled=true;
 }
 
+static QMutex statsMutex;
+static MPDConnection::LaneStats laneStatistics[MPDConnection::Lane_Count];
+static MPDConnection::StatusCounters statusCount;
+
+MPDConnection::LaneStats MPDConnection::laneStats(Lane lane)
+{
+    QMutexLocker locker(&statsMutex);
+    return laneStatistics[lane];
+}
+
+MPDConnection::StatusCounters MPDConnection::statusCounters()
+{
+    QMutexLocker locker(&statsMutex);
+    return statusCount;
+}
+
+static void statusAvoided()
+{
+    QMutexLocker locker(&statsMutex);
+    statusCount.avoided++;
+}
+
+void MPDConnection::recordLatency(Lane lane, qint64 ms)
+{
+    QMutexLocker locker(&statsMutex);
+    LaneStats &stats=laneStatistics[lane];
+    stats.commands++;
+    stats.totalTime+=ms;
+    if (ms>stats.maxTime) {
+        stats.maxTime=ms;
+    }
+    DBUG << (Lane_Interactive==lane ? "interactive" : "bulk") << "latency:" << ms << "ms, average:" << (stats.totalTime/stats.commands)
+         << "ms, max:" << stats.maxTime << "ms, commands:" << stats.commands;
+}
+
 // Uncomment the following to report error strings in MPDStatus to the UI
 // ...disabled, as stickers (for ratings) can cause lots of errors to be reported - and these all need clearing, etc.
 // #define REPORT_MPD_ERRORS
@@ -87,6 +126,13 @@ static const QByteArray constDynamicIn("cantata-dynamic-in");
 static const QByteArray constDynamicOut("cantata-dynamic-out");
 #endif
 static const QByteArray constRatingSticker("rating");
+// Time, in milliseconds, to wait for the bulk lane's thread to finish when stopping
+static const int constBulkStopTimeout=2000;
+// Time, in milliseconds, to collect rating requests for - so that these can be retrieved in one go
+static const int constRatingRequestDelay=50;
+static const int constSearchWindow=1000;
+// Number of songs in each page of a stored playlist's contents
+static const int constPlaylistPage=1000;
 
 static inline int socketTimeout(int dataSize)
 {
@@ -223,8 +269,14 @@ void MPDConnectionDetails::setDirReadable()
 
 MPDConnection::MPDConnection()
     : thread(0)
+    , bulk(0)
     , ver(0)
     , canUseStickers(false)
+    , canFindStickers(false)
+    , ratingsCached(false)
+    , loadingRatings(false)
+    , ratingsLoadId(0)
+    , ratingTimer(0)
     , sock(this)
     , idleSocket(this)
     , lastStatusPlayQueueVersion(0)
@@ -268,7 +320,7 @@ MPDConnection::MPDConnection()
     seekStep=Settings::self()->seekStep();
     #endif
     connTimer=new QTimer(this);
-    connect(connTimer, SIGNAL(timeout()), SLOT(getStatus()));
+    connect(connTimer, SIGNAL(timeout()), SLOT(keepAlive()));
     connTimer->setSingleShot(false);
 }
 
@@ -292,6 +344,30 @@ void MPDConnection::start()
         moveToThread(thread);
         thread->start();
     }
+    if (!bulk) {
+        bulk=new MPDBulkConnection();
+        connect(this, SIGNAL(bulkDetails(MPDConnectionDetails,long,bool)), bulk, SLOT(setDetails(MPDConnectionDetails,long,bool)), Qt::QueuedConnection);
+        connect(this, SIGNAL(bulkLoadLibrary(QDateTime)), bulk, SLOT(loadLibrary(QDateTime)), Qt::QueuedConnection);
+        connect(this, SIGNAL(bulkLoadFolders(QDateTime)), bulk, SLOT(loadFolders(QDateTime)), Qt::QueuedConnection);
+        connect(this, SIGNAL(bulkListFolder(QString)), bulk, SLOT(listFolder(QString)), Qt::QueuedConnection);
+        connect(this, SIGNAL(bulkListPlaylists()), bulk, SLOT(listPlaylists()), Qt::QueuedConnection);
+        connect(this, SIGNAL(bulkPlaylistInfo(QString)), bulk, SLOT(playlistInfo(QString)), Qt::QueuedConnection);
+        connect(this, SIGNAL(bulkSearch(QString,QString,int)), bulk, SLOT(search(QString,QString,int)), Qt::QueuedConnection);
+        connect(this, SIGNAL(bulkLoadRatings(int)), bulk, SLOT(loadRatings(int)), Qt::QueuedConnection);
+        connect(bulk, SIGNAL(ratingsLoaded(int,QStringList,QList<quint8>,bool)), this, SLOT(ratingsLoaded(int,QStringList,QList<quint8>,bool)), Qt::QueuedConnection);
+        // Forward bulk lane results via our own signals, so that the rest of Cantata does not need to care which lane was used.
+        connect(bulk, SIGNAL(musicLibraryUpdated(MusicLibraryItemRoot*,QDateTime)), this, SIGNAL(musicLibraryUpdated(MusicLibraryItemRoot*,QDateTime)), Qt::DirectConnection);
+        connect(bulk, SIGNAL(dirViewUpdated(DirViewItemRoot*,QDateTime)), this, SIGNAL(dirViewUpdated(DirViewItemRoot*,QDateTime)), Qt::DirectConnection);
+        connect(bulk, SIGNAL(folderListed(QString,QStringList,QStringList,bool)), this, SIGNAL(folderListed(QString,QStringList,QStringList,bool)), Qt::DirectConnection);
+        connect(bulk, SIGNAL(playlistsRetrieved(QList<Playlist>)), this, SIGNAL(playlistsRetrieved(QList<Playlist>)), Qt::DirectConnection);
+        connect(bulk, SIGNAL(playlistInfoRetrieved(QString,QList<Song>,int,bool)), this, SIGNAL(playlistInfoRetrieved(QString,QList<Song>,int,bool)), Qt::DirectConnection);
+        connect(bulk, SIGNAL(updatingLibrary()), this, SIGNAL(updatingLibrary()), Qt::DirectConnection);
+        connect(bulk, SIGNAL(updatedLibrary()), this, SIGNAL(updatedLibrary()), Qt::DirectConnection);
+        connect(bulk, SIGNAL(updatingFileList()), this, SIGNAL(updatingFileList()), Qt::DirectConnection);
+        connect(bulk, SIGNAL(updatedFileList()), this, SIGNAL(updatedFileList()), Qt::DirectConnection);
+        connect(bulk, SIGNAL(searchResponse(int,QList<Song>,bool)), this, SIGNAL(searchResponse(int,QList<Song>,bool)), Qt::DirectConnection);
+        connect(bulk, SIGNAL(error(QString,bool)), this, SIGNAL(error(QString,bool)), Qt::DirectConnection);
+    }
 }
 
 void MPDConnection::stop()
@@ -302,6 +378,15 @@ void MPDConnection::stop()
     }
     #endif
 
+    if (bulk) {
+        disconnect(bulk, 0, this, 0);
+        // The bulk lane's thread has no event loop once stopped, so delete directly. If it is still
+        // busy with a long command, then leave it for ThreadCleaner to terminate.
+        if (bulk->stop()) {
+            delete bulk;
+        }
+        bulk=0;
+    }
     if (thread) {
         thread->stop();
         thread=0;
@@ -427,6 +512,7 @@ MPDConnection::ConnectionReturn MPDConnection::connectToMPD()
     if (Success==(status=connectToMPD(sock)) && Success==(status=connectToMPD(idleSocket, true))) {
         state=State_Connected;
         emit socketAddress(sock.address());
+        updateBulkDetails();
     } else {
         disconnectFromMPD();
         state=State_Disconnected;
@@ -451,6 +537,7 @@ void MPDConnection::disconnectFromMPD()
     idleSocket.close();
     state=State_Disconnected;
     ver=0;
+    statusClock.invalidate();
     emit socketAddress(QString());
 }
 
@@ -616,6 +703,8 @@ MPDConnection::Response MPDConnection::sendCommand(const QByteArray &command, bo
     }
 
     Response response;
+    QElapsedTimer timer;
+    timer.start();
     if (-1==sock.write(command+'\n')) {
         DBUG << "Failed to write";
         // If we fail to write, dont wait for bytes to be written!!
@@ -627,6 +716,7 @@ MPDConnection::Response MPDConnection::sendCommand(const QByteArray &command, bo
         sock.waitForBytesWritten(timeout);
         DBUG << "Socket state after write:" << (int)sock.state();
         response=readReply(sock);
+        recordLatency(Lane_Interactive, timer.elapsed());
     }
 
     if (!response.ok) {
@@ -948,10 +1038,10 @@ void MPDConnection::playListChanges()
     }
 
     QByteArray data = "plchangesposid "+quote(lastUpdatePlayQueueVersion);
-    Response status=sendCommand("status"); // We need an updated status so as to detect deletes at end of list...
+    MPDStatusValues sv;
+    bool statusOk=requestStatus(sv, Status_Internal); // We need an updated status so as to detect deletes at end of list...
     Response response=sendCommand(data, false);
-    if (response.ok && status.ok) {
-        MPDStatusValues sv=MPDParseUtils::parseStatus(status.data);
+    if (response.ok && statusOk) {
         lastUpdatePlayQueueVersion=lastStatusPlayQueueVersion=sv.playlist;
         emitStatusUpdated(sv);
         QList<MPDParseUtils::IdPos> changes=MPDParseUtils::parseChanges(response.data);
@@ -1081,9 +1171,8 @@ void MPDConnection::playListInfo()
         if (songs.isEmpty()) {
             stopVolumeFade();
         }
-        Response status=sendCommand("status");
-        if (status.ok) {
-            MPDStatusValues sv=MPDParseUtils::parseStatus(status.data);
+        MPDStatusValues sv;
+        if (requestStatus(sv, Status_Internal)) {
             lastUpdatePlayQueueVersion=lastStatusPlayQueueVersion=sv.playlist;
             emitStatusUpdated(sv);
         }
@@ -1252,13 +1341,10 @@ void MPDConnection::toggleMute()
         sendCommand("setvol "+quote(unmuteVol), false);
         unmuteVol=-1;
     } else {
-        Response status=sendCommand("status");
-        if (status.ok) {
-            MPDStatusValues sv=MPDParseUtils::parseStatus(status.data);
-            if (sv.volume>0) {
-                unmuteVol=sv.volume;
-                sendCommand("setvol "+quote(0), false);
-            }
+        int vol=getVolume();
+        if (vol>0) {
+            unmuteVol=vol;
+            sendCommand("setvol "+quote(0), false);
         }
     }
 }
@@ -1284,17 +1370,62 @@ void MPDConnection::getStats()
     if (response.ok) {
         MPDStatsValues stats=MPDParseUtils::parseStats(response.data);
         dbUpdate=stats.dbUpdate;
+        bool wasMopidy=mopidy;
         mopidy=0==stats.artists && 0==stats.albums && 0==stats.songs &&
                0==stats.uptime && 0==stats.playtime && 0==stats.dbPlaytime && 0==dbUpdate.toTime_t();
+        if (wasMopidy!=mopidy) {
+            updateBulkDetails();
+        }
         emit statsUpdated(stats);
     }
 }
 
 void MPDConnection::getStatus()
 {
+    updateStatus(Status_Poll);
+}
+
+void MPDConnection::keepAlive()
+{
+    // Elapsed time is interpolated from the last status, and MPD informs us of any state changes via idle. So
+    // there is no need to ask for the status here - just make sure MPD does not close the connection.
+    sendCommand("ping");
+}
+
+bool MPDConnection::requestStatus(MPDStatusValues &sv, StatusReason reason)
+{
+    {
+        QMutexLocker locker(&statsMutex);
+        switch (reason) {
+        case Status_Idle:     statusCount.idle++;     break;
+        case Status_Poll:     statusCount.polled++;   break;
+        case Status_Internal: statusCount.internal++; break;
+        }
+    }
+
     Response response=sendCommand("status");
     if (response.ok) {
-        MPDStatusValues sv=MPDParseUtils::parseStatus(response.data);
+        sv=MPDParseUtils::parseStatus(response.data);
+        lastStatus=sv;
+        statusClock.restart();
+        return true;
+    }
+    return false;
+}
+
+qint32 MPDConnection::elapsed() const
+{
+    if (MPDState_Playing!=lastStatus.state || lastStatus.timeElapsed<0) {
+        return lastStatus.timeElapsed;
+    }
+    qint32 e=lastStatus.timeElapsed+(qint32)((statusClock.elapsed()+500)/1000);
+    return lastStatus.timeTotal>0 && e>lastStatus.timeTotal ? lastStatus.timeTotal : e;
+}
+
+void MPDConnection::updateStatus(StatusReason reason)
+{
+    MPDStatusValues sv;
+    if (requestStatus(sv, reason)) {
         lastStatusPlayQueueVersion=sv.playlist;
         if (currentSongId!=sv.songId) {
             stopVolumeFade();
@@ -1413,12 +1544,12 @@ void MPDConnection::parseIdleReturn(const QByteArray &data)
             QByteArray value=line.mid(constIdleChangedKey.length());
             if (constIdleDbValue==value) {
                 getStats();
-                getStatus();
+                updateStatus(Status_Idle);
                 playListInfo();
                 playListUpdated=true;
             } else if (constIdleUpdateValue==value) {
                 getStats();
-                getStatus();
+                updateStatus(Status_Idle);
             } else if (constIdleStoredPlaylistValue==value) {
                 listPlaylists();
             } else if (constIdlePlaylistValue==value) {
@@ -1426,12 +1557,13 @@ void MPDConnection::parseIdleReturn(const QByteArray &data)
                     playListChanges();
                 }
             } else if (!statusUpdated && (constIdlePlayerValue==value || constIdleMixerValue==value || constIdleOptionsValue==value)) {
-                getStatus();
+                updateStatus(Status_Idle);
                 getReplayGain();
                 statusUpdated=true;
             } else if (constIdleOutputValue==value) {
                 outputs();
             } else if (constIdleStickerValue==value) {
+                invalidateRatings();
                 emit stickerDbChanged();
             }
             #ifdef ENABLE_DYNAMIC
@@ -1486,35 +1618,17 @@ void MPDConnection::update()
  */
 void MPDConnection::loadLibrary()
 {
-    emit updatingLibrary();
-    Response response=alwaysUseLsInfo || !details.topLevel.isEmpty() ? Response(false) : sendCommand("listallinfo", false);
-    MusicLibraryItemRoot *root=0;
-    if (response.ok) {
-        root = new MusicLibraryItemRoot;
-        MPDParseUtils::parseLibraryItems(response.data, details.dir, ver, mopidy, root);
-    } else { // MPD >=0.18 can fail listallinfo for large DBs, so get info dir by dir...
-        root = new MusicLibraryItemRoot;
-        if (!listDirInfo(details.topLevel.isEmpty() ? "/" : details.topLevel, root)) {
-            delete root;
-            root=0;
-        }
-    }
-
-    if (root) {
-        root->applyGrouping();
-        emit musicLibraryUpdated(root, dbUpdate);
-    }
-    emit updatedLibrary();
+    emit bulkLoadLibrary(dbUpdate);
 }
 
 void MPDConnection::loadFolders()
 {
-    emit updatingFileList();
-    Response response=sendCommand("listall");
-    if (response.ok) {
-        emit dirViewUpdated(MPDParseUtils::parseDirViewItems(response.data, mopidy), dbUpdate);
-    }
-    emit updatedFileList();
+    emit bulkLoadFolders(dbUpdate);
+}
+
+void MPDConnection::listFolder(const QString &dir)
+{
+    emit bulkListFolder(dir);
 }
 
 /*
@@ -1529,18 +1643,12 @@ void MPDConnection::loadFolders()
 
 void MPDConnection::listPlaylists()
 {
-    Response response=sendCommand("listplaylists");
-    if (response.ok) {
-        emit playlistsRetrieved(MPDParseUtils::parsePlaylists(response.data));
-    }
+    emit bulkListPlaylists();
 }
 
 void MPDConnection::playlistInfo(const QString &name)
 {
-    Response response=sendCommand("listplaylistinfo "+encodeName(name));
-    if (response.ok) {
-        emit playlistInfoRetrieved(name, MPDParseUtils::parseSongs(response.data, MPDParseUtils::Loc_Playlists));
-    }
+    emit bulkPlaylistInfo(name);
 }
 
 void MPDConnection::loadPlaylist(const QString &name, bool replace)
@@ -1666,42 +1774,17 @@ void MPDConnection::setPriority(const QList<qint32> &ids, quint8 priority)
 
 void MPDConnection::search(const QString &field, const QString &value, int id)
 {
-    QList<Song> songs;
-    QByteArray cmd;
-
-    if (constModifiedSince==field) {
-        QString dateVal;
-        if (value.length()>7 && (value.contains(QLatin1Char('/')) || value.contains(QLatin1Char('-')))) {
-            QDateTime dt=QDateTime::fromString(value, Qt::SystemLocaleShortDate);
-            if (!dt.isValid()) {
-                dt=QDateTime::fromString(value, Qt::DefaultLocaleShortDate);
-            }
-            if (!dt.isValid()) {
-                dt=QDateTime::fromString(value, Qt::ISODate);
-            }
-            if (dt.isValid()) {
-                cmd="find "+field.toLatin1()+" "+encodeName(dt.toString(Qt::ISODate));
-            }
-        }
-        if (dateVal.isEmpty() && !value.contains(QLatin1Char('/')) && !value.contains(QLatin1Char('-'))) {
-            bool ok=false;
-            int numDays=value.simplified().trimmed().toInt(&ok);
-            if (ok && numDays<0xFFFF) {
-                cmd="find "+field.toLatin1()+" "+quote(QDateTime::currentDateTime().toTime_t()-(numDays*24*60*60));
-            }
-        }
-    } else {
-        cmd="search "+field.toLatin1()+" "+encodeName(value);
+    if (bulk) {
+        bulk->setCurrentSearch(id);
     }
+    emit bulkSearch(field, value, id);
+}
 
-    if (!cmd.isEmpty()) {
-        Response response=sendCommand(cmd);
-        if (response.ok) {
-            songs=MPDParseUtils::parseSongs(response.data, MPDParseUtils::Loc_Search);
-            qSort(songs);
-        }
+void MPDConnection::cancelSearch()
+{
+    if (bulk) {
+        bulk->setCurrentSearch(0);
     }
-    emit searchResponse(id, songs);
 }
 
 void MPDConnection::listStreams()
@@ -1859,9 +1942,11 @@ void MPDConnection::toggleStopAfterCurrent(bool afterCurrent)
         stopAfterCurrent=afterCurrent;
         songPos=0;
         if (stopAfterCurrent && 1==playQueueIds.count()) {
-            Response response=sendCommand("status");
-            if (response.ok) {
-                MPDStatusValues sv=MPDParseUtils::parseStatus(response.data);
+            MPDStatusValues sv;
+            if (haveStatus()) {
+                statusAvoided();
+                songPos=elapsed();
+            } else if (requestStatus(sv, Status_Internal)) {
                 songPos=sv.timeElapsed;
             }
         }
@@ -1869,22 +1954,9 @@ void MPDConnection::toggleStopAfterCurrent(bool afterCurrent)
     }
 }
 
-bool MPDConnection::listDirInfo(const QString &dir, MusicLibraryItemRoot *root)
+void MPDConnection::updateBulkDetails()
 {
-    bool topLevel="/"==dir;
-    Response response=sendCommand(topLevel ? "lsinfo" : ("lsinfo "+encodeName(dir)));
-    if (response.ok) {
-        QSet<QString> childDirs;
-        MPDParseUtils::parseLibraryItems(response.data, details.dir, ver, mopidy, root, !topLevel, &childDirs);
-        foreach (const QString &child, childDirs) {
-            if (!listDirInfo(child, root)) {
-                return false;
-            }
-        }
-        return true;
-    } else {
-        return false;
-    }
+    emit bulkDetails(details, ver, mopidy);
 }
 
 #ifdef ENABLE_DYNAMIC
@@ -1976,12 +2048,13 @@ void MPDConnection::readRemoteDynamicMessages()
 
 int MPDConnection::getVolume()
 {
-    Response response=sendCommand("status");
-    if (response.ok) {
-        MPDStatusValues sv=MPDParseUtils::parseStatus(response.data);
-        return sv.volume;
+    // Volume changes are reported via the 'mixer' idle event, so last status should be current.
+    if (haveStatus()) {
+        statusAvoided();
+        return lastStatus.volume;
     }
-    return -1;
+    MPDStatusValues sv;
+    return requestStatus(sv, Status_Internal) ? sv.volume : -1;
 }
 
 void MPDConnection::setRating(const QString &file, quint8 val)
@@ -2004,6 +2077,13 @@ void MPDConnection::setRating(const QString &file, quint8 val)
     }
 
     if (ok) {
+        if (ratingsCached) {
+            if (0==val) {
+                ratingCache.remove(file);
+            } else {
+                ratingCache.insert(file, val);
+            }
+        }
         emit rating(file, val);
     } else {
         getRating(file);
@@ -2056,24 +2136,99 @@ void MPDConnection::setRating(const QStringList &files, quint8 val)
     }
 }
 
+// Views request the ratings of songs as they are drawn, so collect these requests for a short while
+// and then retrieve them all at once.
 void MPDConnection::getRating(const QString &file)
 {
-    quint8 r=0;
-    if (canUseStickers) {
-        Response resp=sendCommand("sticker get song "+encodeName(file)+' '+constRatingSticker, false);
-        if (resp.ok) {
-            QByteArray val=MPDParseUtils::parseSticker(resp.data, constRatingSticker);
-            if (!val.isEmpty()) {
-                r=val.toUInt();
+    ratingRequests.insert(file);
+    if (!ratingTimer) {
+        ratingTimer=new QTimer(this);
+        ratingTimer->setSingleShot(true);
+        connect(ratingTimer, SIGNAL(timeout()), SLOT(getRatings()));
+    }
+    if (!ratingTimer->isActive()) {
+        ratingTimer->start(constRatingRequestDelay);
+    }
+}
+
+void MPDConnection::getRatings()
+{
+    if (ratingRequests.isEmpty()) {
+        return;
+    }
+
+    if (canUseStickers && canFindStickers && !ratingsCached) {
+        // Listing all ratings may take a while, so this is done via the bulk lane. Requests are
+        // answered once the ratings have been received.
+        if (!loadingRatings) {
+            loadingRatings=true;
+            emit bulkLoadRatings(++ratingsLoadId);
+        }
+        return;
+    }
+
+    QStringList files=ratingRequests.toList();
+    QList<quint8> vals;
+    ratingRequests.clear();
+
+    if (canUseStickers && ratingsCached) {
+        foreach (const QString &file, files) {
+            vals.append(ratingCache.value(file, 0));
+        }
+    } else {
+        // Cannot list all stickers, so fallback to querying each song...
+        foreach (const QString &file, files) {
+            quint8 r=0;
+            if (canUseStickers) {
+                Response resp=sendCommand("sticker get song "+encodeName(file)+' '+constRatingSticker, false);
+                if (resp.ok) {
+                    QByteArray val=MPDParseUtils::parseSticker(resp.data, constRatingSticker);
+                    if (!val.isEmpty()) {
+                        r=val.toUInt();
+                    }
+                } else { // Ignore errors about uknown sticker...
+                    clearError();
+                }
+                if (r>Song::Rating_Max) {
+                    r=0;
+                }
             }
-        } else { // Ignore errors about uknown sticker...
-            clearError();
+            vals.append(r);
         }
-        if (r>Song::Rating_Max) {
-            r=0;
+    }
+    DBUG << files.count();
+    emit ratings(files, vals);
+}
+
+void MPDConnection::ratingsLoaded(int id, const QStringList &files, const QList<quint8> &vals, bool ok)
+{
+    if (id!=ratingsLoadId || !loadingRatings) {
+        // Sticker DB changed whilst these were being read...
+        return;
+    }
+
+    loadingRatings=false;
+    if (ok) {
+        ratingCache.clear();
+        for (int i=0; i<files.count() && i<vals.count(); ++i) {
+            ratingCache.insert(files.at(i), vals.at(i));
         }
+        ratingsCached=true;
+        DBUG << ratingCache.count();
+    } else {
+        canFindStickers=false;
+    }
+    getRatings();
+}
+
+void MPDConnection::invalidateRatings()
+{
+    ratingsCached=false;
+    ratingCache.clear();
+    if (loadingRatings) {
+        // Ratings being read may already be out of date, so ask again.
+        emit bulkLoadRatings(++ratingsLoadId);
     }
-    emit rating(file, r);
 }
 
 void MPDConnection::getStickerSupport()
@@ -2081,6 +2236,8 @@ void MPDConnection::getStickerSupport()
     Response response=sendCommand("commands");
     canUseStickers=response.ok &&
         MPDParseUtils::parseList(response.data, QByteArray("command: ")).toSet().contains("sticker");
+    canFindStickers=canUseStickers;
+    invalidateRatings();
 }
 
 bool MPDConnection::fadingVolume()
@@ -2148,6 +2305,348 @@ void MPDConnection::clearError()
     #endif
 }
 
+MPDBulkConnection::MPDBulkConnection()
+    : sock(this)
+    , ver(0)
+    , mopidy(false)
+    , currentSearch(0)
+{
+    thread=new Thread(metaObject()->className());
+    moveToThread(thread);
+    thread->start();
+}
+
+bool MPDBulkConnection::stop()
+{
+    if (thread) {
+        thread->stop();
+        if (!thread->wait(constBulkStopTimeout)) {
+            return false;
+        }
+        thread=0;
+    }
+    return true;
+}
+
+void MPDBulkConnection::setDetails(const MPDConnectionDetails &d, long v, bool m)
+{
+    if (d!=details) {
+        DBUG << "bulk" << d.hostname << d.port;
+        if (QAbstractSocket::ConnectedState==sock.state()) {
+            sock.disconnectFromHost();
+        }
+        sock.close();
+    }
+    details=d;
+    ver=v;
+    mopidy=m;
+}
+
+void MPDBulkConnection::loadLibrary(const QDateTime &dbUpdate)
+{
+    emit updatingLibrary();
+    MPDConnection::Response response=alwaysUseLsInfo || !details.topLevel.isEmpty() ? MPDConnection::Response(false) : sendCommand("listallinfo", false);
+    MusicLibraryItemRoot *root=0;
+    CueCache cueCache(CueCache::cacheFileName(details));
+    if (response.ok) {
+        root = new MusicLibraryItemRoot;
+        MPDParseUtils::parseLibraryItems(response.data, details.dir, ver, mopidy, root, true, 0, &cueCache);
+    } else { // MPD >=0.18 can fail listallinfo for large DBs, so get info dir by dir...
+        root = new MusicLibraryItemRoot;
+        if (!listDirInfo(details.topLevel.isEmpty() ? "/" : details.topLevel, root, &cueCache)) {
+            delete root;
+            root=0;
+        }
+    }
+
+    if (root) {
+        cueCache.save();
+        root->applyGrouping();
+        emit musicLibraryUpdated(root, dbUpdate);
+    }
+    emit updatedLibrary();
+}
+
+void MPDBulkConnection::loadFolders(const QDateTime &dbUpdate)
+{
+    emit updatingFileList();
+    MPDConnection::Response response=sendCommand("listall");
+    if (response.ok) {
+        emit dirViewUpdated(MPDParseUtils::parseDirViewItems(response.data, mopidy), dbUpdate);
+    }
+    emit updatedFileList();
+}
+
+void MPDBulkConnection::listFolder(const QString &dir)
+{
+    // Errors are not shown, as the folder may have been removed since it was listed in its parent.
+    bool topLevel=dir.isEmpty();
+    MPDConnection::Response response=sendCommand(topLevel ? "lsinfo" : ("lsinfo "+MPDConnection::encodeName(dir)), false);
+    QStringList dirs;
+    QStringList files;
+    if (response.ok) {
+        // lsinfo / will return all stored playlists - but this is deprecated.
+        MPDParseUtils::parseDirListing(response.data, !topLevel, dirs, files);
+    }
+    emit folderListed(dir, dirs, files, response.ok);
+}
+
+void MPDBulkConnection::listPlaylists()
+{
+    MPDConnection::Response response=sendCommand("listplaylists");
+    if (response.ok) {
+        emit playlistsRetrieved(MPDParseUtils::parsePlaylists(response.data));
+    }
+}
+
+// Returns the position of the song that follows 'count' songs from 'from', or -1 if there are no more.
+static int skipSongs(const QByteArray &data, int from, int count)
+{
+    static const QByteArray constNextFile("\nfile: ");
+    int pos=from;
+    for (int i=0; i<count && -1!=pos; ++i) {
+        pos=data.indexOf(constNextFile, pos+1);
+    }
+    return -1==pos ? -1 : pos+1;
+}
+
+void MPDBulkConnection::playlistInfo(const QString &name)
+{
+    // Songs are passed on in pages, so that the model can show the start of a large playlist without
+    // waiting for all of it. MPD>=0.24 can return a range of a playlist. For older versions, the whole
+    // playlist is read at once - but is still parsed, and passed on, a page at a time.
+    QByteArray cmd="listplaylistinfo "+MPDConnection::encodeName(name);
+    bool windowed=!mopidy && ver>=CANTATA_MAKE_VERSION(0, 24, 0);
+    int start=0;
+    if (windowed) {
+        for (;;) {
+            // Errors are only shown for the first page - a playlist whose length is a multiple of the page
+            // size may cause the request for the next (empty) page to fail.
+            MPDConnection::Response response=sendCommand(cmd+' '+QByteArray::number(start)+':'+QByteArray::number(start+constPlaylistPage), 0==start);
+            if (!response.ok) {
+                break;
+            }
+            QList<Song> songs=MPDParseUtils::parseSongs(response.data, MPDParseUtils::Loc_Playlists);
+            bool complete=songs.count()<constPlaylistPage;
+            emit playlistInfoRetrieved(name, songs, start, complete);
+            if (complete) {
+                return;
+            }
+            start+=songs.count();
+        }
+    } else {
+        MPDConnection::Response response=sendCommand(cmd);
+        if (response.ok) {
+            int pos=0;
+            while (-1!=pos) {
+                int next=skipSongs(response.data, pos, constPlaylistPage);
+                QList<Song> songs=MPDParseUtils::parseSongs(-1==next ? response.data.mid(pos) : response.data.mid(pos, next-pos),
+                                                            MPDParseUtils::Loc_Playlists);
+                emit playlistInfoRetrieved(name, songs, start, -1==next);
+                start+=songs.count();
+                pos=next;
+            }
+            return;
+        }
+    }
+    if (0!=start) {
+        // Failed part way through, so let the model know that no more songs will arrive.
+        emit playlistInfoRetrieved(name, QList<Song>(), start, true);
+    }
+}
+
+void MPDBulkConnection::search(const QString &field, const QString &value, int id)
+{
+    if (!isCurrentSearch(id)) {
+        DBUG << "search" << id << "superseded";
+        return;
+    }
+
+    QByteArray cmd;
+
+    if (MPDConnection::constModifiedSince==field) {
+        QString dateVal;
+        if (value.length()>7 && (value.contains(QLatin1Char('/')) || value.contains(QLatin1Char('-')))) {
+            QDateTime dt=QDateTime::fromString(value, Qt::SystemLocaleShortDate);
+            if (!dt.isValid()) {
+                dt=QDateTime::fromString(value, Qt::DefaultLocaleShortDate);
+            }
+            if (!dt.isValid()) {
+                dt=QDateTime::fromString(value, Qt::ISODate);
+            }
+            if (dt.isValid()) {
+                cmd="find "+field.toLatin1()+" "+MPDConnection::encodeName(dt.toString(Qt::ISODate));
+            }
+        }
+        if (dateVal.isEmpty() && !value.contains(QLatin1Char('/')) && !value.contains(QLatin1Char('-'))) {
+            bool ok=false;
+            int numDays=value.simplified().trimmed().toInt(&ok);
+            if (ok && numDays<0xFFFF) {
+                cmd="find "+field.toLatin1()+" "+MPDConnection::quote(QDateTime::currentDateTime().toTime_t()-(numDays*24*60*60));
+            }
+        }
+    } else {
+        cmd="search "+field.toLatin1()+" "+MPDConnection::encodeName(value);
+    }
+
+    if (!cmd.isEmpty()) {
+        // MPD>=0.20 can return results in windows. Use this so that results are shown as they arrive, and so
+        // that a search can be abandoned if the user has since started another.
+        bool windowed=!mopidy && ver>=CANTATA_MAKE_VERSION(0, 20, 0);
+        int start=0;
+        for (;;) {
+            MPDConnection::Response response=sendCommand(windowed
+                                                            ? cmd+" window "+QByteArray::number(start)+':'+QByteArray::number(start+constSearchWindow)
+                                                            : cmd);
+            if (!response.ok) {
+                break;
+            }
+            QList<Song> songs=MPDParseUtils::parseSongs(response.data, MPDParseUtils::Loc_Search);
+            bool complete=!windowed || songs.count()<constSearchWindow;
+            qSort(songs);
+            emit searchResponse(id, songs, complete);
+            if (complete) {
+                return;
+            }
+            start+=constSearchWindow;
+            if (!isCurrentSearch(id)) {
+                DBUG << "search" << id << "superseded after" << start << "songs";
+                return;
+            }
+        }
+    }
+    emit searchResponse(id, QList<Song>(), true);
+}
+
+void MPDBulkConnection::loadRatings(int id)
+{
+    QStringList files;
+    QList<quint8> vals;
+    MPDConnection::Response resp=sendCommand("sticker find song \"\" "+constRatingSticker, false);
+    if (resp.ok) {
+        QMap<QString, QByteArray> stickers=MPDParseUtils::parseStickers(resp.data, constRatingSticker);
+        QMap<QString, QByteArray>::ConstIterator it=stickers.constBegin();
+        QMap<QString, QByteArray>::ConstIterator end=stickers.constEnd();
+        for (; it!=end; ++it) {
+            quint8 r=it.value().toUInt();
+            if (r>0 && r<=Song::Rating_Max) {
+                files.append(it.key());
+                vals.append(r);
+            }
+        }
+    }
+    DBUG << "bulk" << resp.ok << files.count();
+    emit ratingsLoaded(id, files, vals, resp.ok);
+}
+
+void MPDBulkConnection::setCurrentSearch(int id)
+{
+    QMutexLocker locker(&searchMutex);
+    currentSearch=id;
+}
+
+bool MPDBulkConnection::isCurrentSearch(int id)
+{
+    QMutexLocker locker(&searchMutex);
+    return id==currentSearch;
+}
+
+bool MPDBulkConnection::listDirInfo(const QString &dir, MusicLibraryItemRoot *root, CueCache *cueCache)
+{
+    bool topLevel="/"==dir;
+    MPDConnection::Response response=sendCommand(topLevel ? "lsinfo" : ("lsinfo "+MPDConnection::encodeName(dir)));
+    if (response.ok) {
+        QSet<QString> childDirs;
+        MPDParseUtils::parseLibraryItems(response.data, details.dir, ver, mopidy, root, !topLevel, &childDirs, cueCache);
+        foreach (const QString &child, childDirs) {
+            if (!listDirInfo(child, root, cueCache)) {
+                return false;
+            }
+        }
+        return true;
+    } else {
+        return false;
+    }
+}
+
+
+bool MPDBulkConnection::connectToMPD()
+{
+    if (QAbstractSocket::ConnectedState==sock.state()) {
+        return true;
+    }
+    if (details.isEmpty()) {
+        DBUG << "no hostname and/or port supplied.";
+        return false;
+    }
+
+    DBUG << (void *)(&sock) << "Connecting (bulk)";
+    sock.connectToHost(details.hostname, details.port);
+    if (!sock.waitForConnected(constSocketCommsTimeout)) {
+        DBUG << (void *)(&sock) << "Couldn't connect - " << sock.errorString();
+        sock.close();
+        return false;
+    }
+
+    if (!readFromSocket(sock).startsWith(constOkMpdValue)) {
+        DBUG << (void *)(&sock) << "Failed to read identification string";
+        sock.close();
+        return false;
+    }
+
+    if (!details.password.isEmpty()) {
+        DBUG << (void *)(&sock) << "setting password...";
+        sock.write("password "+details.password.toUtf8()+'\n');
+        sock.waitForBytesWritten(constSocketCommsTimeout);
+        if (!readReply(sock).ok) {
+            DBUG << (void *)(&sock) << "password rejected";
+            sock.close();
+            return false;
+        }
+    }
+    return true;
+}
+
+MPDConnection::Response MPDBulkConnection::sendCommand(const QByteArray &command, bool emitErrors, bool retry)
+{
+    DBUG << (void *)(&sock) << "sendCommand (bulk):" << log(command) << emitErrors << retry;
+
+    if (!connectToMPD()) {
+        emit error(i18n("Failed to send command to %1 - not connected", details.description()), true);
+        return MPDConnection::Response(false);
+    }
+
+    MPDConnection::Response response;
+    QElapsedTimer timer;
+    timer.start();
+    if (-1==sock.write(command+'\n')) {
+        DBUG << "Failed to write";
+        response=MPDConnection::Response(false);
+        sock.close();
+    } else {
+        sock.waitForBytesWritten(socketTimeout(command.length()));
+        response=readReply(sock);
+        MPDConnection::recordLatency(MPDConnection::Lane_Bulk, timer.elapsed());
+    }
+
+    if (!response.ok) {
+        DBUG << log(command) << "failed";
+        if (response.data.isEmpty() && retry && QAbstractSocket::ConnectedState!=sock.state()) {
+            // Socket may have been closed by MPD (e.g. connection_timeout), so reconnect and try again...
+            return sendCommand(command, emitErrors, false);
+        }
+        if (emitErrors) {
+            if (!response.getError(command).isEmpty()) {
+                emit error(i18n("MPD reported the following error: %1", response.getError(command)));
+            } else {
+                sock.close();
+                emit error(i18n("Failed to send command to %1 - not connected", details.description()), true);
+            }
+        }
+    }
+    return response;
+}
+
 MpdSocket::MpdSocket(QObject *parent)
     : QObject(parent)
     , tcp(0)
@@ -34,6 +34,9 @@
 #include <QDateTime>
 #include <QStringList>
 #include <QSet>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QMutex>
 #include "mpdstats.h"
 #include "mpdstatus.h"
 #include "song.h"
@@ -49,6 +52,8 @@ class MusicLibraryItemRoot;
 class QTimer;
 class Thread;
 class QPropertyAnimation;
+class MPDBulkConnection;
+class CueCache;
 
 class MpdSocket : public QObject
 {
@@ -201,7 +206,37 @@ public:
         QByteArray data;
     };
 
+    // Commands are sent via two connections. Playback, volume, play queue, etc, commands use the
+    // interactive lane. Commands that return large amounts of data (library, folders, playlists,
+    // and searches) use the bulk lane - which has its own connection and thread.
+    enum Lane {
+        Lane_Interactive,
+        Lane_Bulk,
+
+        Lane_Count
+    };
+
+    struct LaneStats {
+        LaneStats() : commands(0), totalTime(0), maxTime(0) { }
+        quint32 commands;
+        quint64 totalTime; // Milliseconds
+        quint32 maxTime;   // Milliseconds
+    };
+
+    // Number of 'status' commands sent, and the reason for these. Cantata interpolates the elapsed
+    // time from the last status, so only needs to ask MPD when it reports a change.
+    struct StatusCounters {
+        StatusCounters() : idle(0), polled(0), internal(0), avoided(0) { }
+        quint32 idle;     // Player, mixer, or options idle event
+        quint32 polled;   // Explicit request (UI, config 'mpdPoll', clock drift, etc.)
+        quint32 internal; // Needed for play queue length, version, etc.
+        quint32 avoided;  // Answered from last status instead
+    };
+
     static void enableDebug();
+    static LaneStats laneStats(Lane lane);
+    static void recordLatency(Lane lane, qint64 ms);
+    static StatusCounters statusCounters();
 
     MPDConnection();
     ~MPDConnection();
@@ -285,6 +320,7 @@ public Q_SLOTS:
     // Database
     void loadLibrary();
     void loadFolders();
+    void listFolder(const QString &dir);
 
     // Admin
     void update();
@@ -305,6 +341,7 @@ public Q_SLOTS:
     void setPriority(const QList<qint32> &ids, quint8 priority);
 
     void search(const QString &field, const QString &value, int id);
+    void cancelSearch();
 
     void listStreams();
     void saveStream(const QString &url, const QString &name);
@@ -332,8 +369,9 @@ Q_SIGNALS:
     void outputsUpdated(const QList<Output> &outputs);
     void musicLibraryUpdated(MusicLibraryItemRoot *root, QDateTime dbUpdate);
     void dirViewUpdated(DirViewItemRoot *root, QDateTime dbUpdate);
+    void folderListed(const QString &dir, const QStringList &dirs, const QStringList &files, bool ok);
     void playlistsRetrieved(const QList<Playlist> &data);
-    void playlistInfoRetrieved(const QString &name, const QList<Song> &songs);
+    void playlistInfoRetrieved(const QString &name, const QList<Song> &songs, int start, bool complete);
     void playlistRenamed(const QString &from, const QString &to);
     void removedFromPlaylist(const QString &name, const QList<quint32> &positions);
     void movedInPlaylist(const QString &name, const QList<quint32> &items, quint32 pos);
@@ -354,7 +392,7 @@ Q_SIGNALS:
     void stopAfterCurrentChanged(bool afterCurrent);
     void streamUrl(const QString &url);
 
-    void searchResponse(int id, const QList<Song> &songs);
+    void searchResponse(int id, const QList<Song> &songs, bool complete);
 
     void socketAddress(const QString &addr);
     void cantataStreams(const QStringList &files);
@@ -371,11 +409,25 @@ Q_SIGNALS:
     void dynamicResponse(const QStringList &resp);
 
     void rating(const QString &file, quint8 val);
+    void ratings(const QStringList &files, const QList<quint8> &vals);
     void stickerDbChanged();
 
+    // Requests to the bulk lane...
+    void bulkDetails(const MPDConnectionDetails &d, long ver, bool mopidy);
+    void bulkLoadLibrary(const QDateTime &dbUpdate);
+    void bulkLoadFolders(const QDateTime &dbUpdate);
+    void bulkListFolder(const QString &dir);
+    void bulkListPlaylists();
+    void bulkPlaylistInfo(const QString &name);
+    void bulkSearch(const QString &field, const QString &value, int id);
+    void bulkLoadRatings(int id);
+
 private Q_SLOTS:
     void idleDataReady();
     void onSocketStateChanged(QAbstractSocket::SocketState socketState);
+    void getRatings();
+    void ratingsLoaded(int id, const QStringList &files, const QList<quint8> &vals, bool ok);
+    void keepAlive();
 
 private:
     enum ConnectionReturn
@@ -396,7 +448,7 @@ private:
     void parseIdleReturn(const QByteArray &data);
     bool doMoveInPlaylist(const QString &name, const QList<quint32> &items, quint32 pos, quint32 size);
     void toggleStopAfterCurrent(bool afterCurrent);
-    bool listDirInfo(const QString &dir, MusicLibraryItemRoot *root);
+    void updateBulkDetails();
     #ifdef ENABLE_DYNAMIC
     bool checkRemoteDynamicSupport();
     bool subscribe(const QByteArray &channel);
@@ -406,19 +458,40 @@ private:
     bool fadingVolume();
     bool startVolumeFade();
     void stopVolumeFade();
+    enum StatusReason {
+        Status_Idle,
+        Status_Poll,
+        Status_Internal
+    };
+
+    bool requestStatus(MPDStatusValues &sv, StatusReason reason);
+    bool haveStatus() const { return statusClock.isValid(); }
+    qint32 elapsed() const;
+    void updateStatus(StatusReason reason);
     void emitStatusUpdated(MPDStatusValues &v);
     void clearError();
-    void getRatings(QList<Song> &songs);
+    void invalidateRatings();
     void getStickerSupport();
     void playFirstTrack(bool emitErrors);
     void seek(bool fwd);
 
 private:
     Thread *thread;
+    MPDBulkConnection *bulk;
     long ver;
     QSet<QString> handlers;
     QSet<QString> tagTypes;
     bool canUseStickers;
+    // Ratings are requested in batches, and looked up in a cache of all song ratings. This cache is
+    // filled via a single 'sticker find' on the bulk lane, and cleared when MPD reports that the
+    // sticker DB changed.
+    bool canFindStickers;
+    bool ratingsCached;
+    bool loadingRatings;
+    int ratingsLoadId;
+    QHash<QString, quint8> ratingCache;
+    QSet<QString> ratingRequests;
+    QTimer *ratingTimer;
     MPDConnectionDetails details;
     QDateTime dbUpdate;
     // Use 2 sockets, 1 for commands and 1 to receive MPD idle events.
@@ -436,6 +509,10 @@ private:
     quint32 lastStatusPlayQueueVersion;
     quint32 lastUpdatePlayQueueVersion;
 
+    // Last status read from MPD, and when this was read - used to interpolate elapsed time.
+    MPDStatusValues lastStatus;
+    QElapsedTimer statusClock;
+
     enum State
     {
         State_Blank,
@@ -458,4 +535,61 @@ private:
     int restoreVolume;
 };
 
+// Bulk lane. Uses its own thread, and connection, so that long running commands do not delay
+// commands sent via MPDConnection.
+class MPDBulkConnection : public QObject
+{
+    Q_OBJECT
+
+public:
+    MPDBulkConnection();
+    ~MPDBulkConnection() { }
+
+    // Stops the thread, and waits for it to finish. Returns false if it did not finish in time, in
+    // which case this object must not be deleted.
+    bool stop();
+    // Called from MPDConnection's thread, so that a search that is being read in windows can be
+    // abandoned as soon as a newer one is requested.
+    void setCurrentSearch(int id);
+
+public Q_SLOTS:
+    void setDetails(const MPDConnectionDetails &d, long v, bool m);
+    void loadLibrary(const QDateTime &dbUpdate);
+    void loadFolders(const QDateTime &dbUpdate);
+    void listFolder(const QString &dir);
+    void listPlaylists();
+    void playlistInfo(const QString &name);
+    void search(const QString &field, const QString &value, int id);
+    void loadRatings(int id);
+
+Q_SIGNALS:
+    void musicLibraryUpdated(MusicLibraryItemRoot *root, QDateTime dbUpdate);
+    void dirViewUpdated(DirViewItemRoot *root, QDateTime dbUpdate);
+    void folderListed(const QString &dir, const QStringList &dirs, const QStringList &files, bool ok);
+    void playlistsRetrieved(const QList<Playlist> &data);
+    void playlistInfoRetrieved(const QString &name, const QList<Song> &songs, int start, bool complete);
+    void updatingLibrary();
+    void updatedLibrary();
+    void updatingFileList();
+    void updatedFileList();
+    void searchResponse(int id, const QList<Song> &songs, bool complete);
+    void ratingsLoaded(int id, const QStringList &files, const QList<quint8> &vals, bool ok);
+    void error(const QString &err, bool showActions=false);
+
+private:
+    bool connectToMPD();
+    MPDConnection::Response sendCommand(const QByteArray &command, bool emitErrors=true, bool retry=true);
+    bool listDirInfo(const QString &dir, MusicLibraryItemRoot *root, CueCache *cueCache);
+    bool isCurrentSearch(int id);
+
+private:
+    Thread *thread;
+    MpdSocket sock;
+    MPDConnectionDetails details;
+    long ver;
+    bool mopidy;
+    QMutex searchMutex;
+    int currentSearch;
+};
+
 #endif
@@ -29,6 +29,9 @@
 #include <QStringList>
 #include <QUrl>
 #include <QFile>
+#include <QHash>
+#include <QPair>
+#include <QtConcurrentMap>
 #include "models/dirviewitemroot.h"
 #include "models/dirviewitemdir.h"
 #include "models/dirviewitemfile.h"
@@ -47,7 +50,7 @@
 #include "http/httpserver.h"
 #endif
 #include "support/utils.h"
-#include "cuefile.h"
+#include "cuecache.h"
 #include "mpdconnection.h"
 #ifdef ENABLE_ONLINE_SERVICES
 #include "online/onlineservice.h"
@@ -416,6 +419,7 @@ Song MPDParseUtils::parseSong(const QList<QByteArray> &lines, Location location)
         }
         #endif
     }
+    song.internTags();
     return song;
 }
 
@@ -539,17 +543,60 @@ void MPDParseUtils::setGroupSingle(bool g)
     groupSingleTracks=g;
 }
 
+static Song parseLibrarySong(const QList<QByteArray> &lines)
+{
+    Song song=MPDParseUtils::parseSong(lines, MPDParseUtils::Loc_Library);
+    if (Song::Playlist!=song.type) {
+        song.fillEmptyFields();
+    }
+    return song;
+}
+
+// Songs for one artist. The albums and tracks of each partition are created on a separate thread.
+struct LibraryPartition
+{
+    LibraryPartition(MusicLibraryItemArtist *a=0) : artist(a) { }
+    MusicLibraryItemArtist *artist;
+    QList<int> songs; // Indexes into list of parsed songs, in the order MPD sent them
+};
+
+struct LibraryPartitionBuilder
+{
+    LibraryPartitionBuilder(const QList<Song> &s) : songs(s) { }
+    typedef void result_type;
+
+    void operator()(LibraryPartition &partition) const
+    {
+        MusicLibraryItemAlbum *albumItem=0;
+        foreach (int i, partition.songs) {
+            const Song &song=songs.at(i);
+            if (!albumItem || song.year!=albumItem->year() || song.albumId()!=albumItem->albumId()) {
+                albumItem = partition.artist->album(song);
+            }
+            MusicLibraryItemSong *songItem=new MusicLibraryItemSong(song, albumItem);
+            QSet<QString> songGenres=songItem->allGenres();
+            albumItem->append(songItem);
+            albumItem->addGenres(songGenres);
+            partition.artist->addGenres(songGenres);
+        }
+    }
+
+    const QList<Song> &songs;
+};
+
+// Below this number of items, songs are parsed and the library tree is built on the calling thread - as
+// the cost of starting threads would outweigh any gain.
+static const int constParallelLibrarySize=2000;
+
 void MPDParseUtils::parseLibraryItems(const QByteArray &data, const QString &mpdDir, long mpdVersion,
                                       bool isMopidy, MusicLibraryItemRoot *rootItem, bool parsePlaylists,
-                                      QSet<QString> *childDirs)
+                                      QSet<QString> *childDirs, CueCache *cueCache)
 {
     bool canSplitCue=mpdVersion>=CANTATA_MAKE_VERSION(0,17,0);
+    QList<QList<QByteArray> > items;
     QList<QByteArray> currentItem;
     QList<QByteArray> lines = data.split('\n');
     int amountOfLines = lines.size();
-    MusicLibraryItemArtist *artistItem = 0;
-    MusicLibraryItemAlbum *albumItem = 0;
-    MusicLibraryItemSong *songItem = 0;
 
     for (int i = 0; i < amountOfLines; i++) {
         const QByteArray &line=lines.at(i);
@@ -558,198 +605,272 @@ void MPDParseUtils::parseLibraryItems(const QByteArray &data, const QString &mpd
         }
         currentItem.append(line);
         if (i == amountOfLines - 1 || lines.at(i + 1).startsWith(constFileKey) || lines.at(i + 1).startsWith(constPlaylistKey)) {
-            Song currentSong = parseSong(currentItem, Loc_Library);
+            items.append(currentItem);
             currentItem.clear();
-            if (currentSong.file.isEmpty() || (isMopidy && !currentSong.file.startsWith(Song::constMopidyLocal))) {
-                continue;
+        }
+    }
+    lines.clear();
+
+    bool parallel=items.count()>=constParallelLibrarySize;
+    QList<Song> songs;
+    if (parallel) {
+        songs=QtConcurrent::blockingMapped(items, parseLibrarySong);
+    } else {
+        foreach (const QList<QByteArray> &item, items) {
+            songs.append(parseLibrarySong(item));
+        }
+    }
+    items.clear();
+
+    // Partition songs by artist. Artist items are created here, so that they are in the same order as
+    // if the tree was built serially. Playlists (and cue files) are handled once all tracks have been
+    // added, as these may modify albums.
+    QList<LibraryPartition> partitions;
+    QHash<MusicLibraryItemArtist *, int> partitionIndexes;
+    QList<QPair<int, int> > playlists; // Index of playlist, and index of the track preceding it
+    MusicLibraryItemArtist *artistItem = 0;
+    int partition=-1;
+    int prevSong=-1;
+    for (int i=0; i<songs.count(); ++i) {
+        const Song &currentSong=songs.at(i);
+        if (currentSong.file.isEmpty() || (isMopidy && !currentSong.file.startsWith(Song::constMopidyLocal))) {
+            continue;
+        }
+
+        if (Song::Playlist==currentSong.type) {
+            // lsinfo / will return all stored playlists - but this is deprecated.
+            if (parsePlaylists) {
+                playlists.append(QPair<int, int>(i, prevSong));
             }
+            continue;
+        }
 
-            if (Song::Playlist==currentSong.type) {
-                // lsinfo / will return all stored playlists - but this is deprecated.
-                if (!parsePlaylists) {
-                    continue;
-                }
+        if (!artistItem || currentSong.artistOrComposer()!=artistItem->data()) {
+            artistItem = rootItem->artist(currentSong);
+            QHash<MusicLibraryItemArtist *, int>::ConstIterator it=partitionIndexes.constFind(artistItem);
+            if (it==partitionIndexes.constEnd()) {
+                partition=partitions.count();
+                partitionIndexes.insert(artistItem, partition);
+                partitions.append(LibraryPartition(artistItem));
+            } else {
+                partition=it.value();
+            }
+        }
+        partitions[partition].songs.append(i);
+        prevSong=i;
+    }
 
-                MusicLibraryItemAlbum *prevAlbum=albumItem;
-                QString prevSongFile=songItem ? songItem->file() : QString();
-                QList<Song> cueSongs; // List of songs from cue file
-                QSet<QString> cueFiles; // List of source (flac, mp3, etc) files referenced in cue file
-
-                DBUG << "Got playlist item" << currentSong.file << "prevFile:" << prevSongFile;
-
-                bool parseCue=canSplitCue && currentSong.isCueFile() && !mpdDir.startsWith(constHttpProtocol) && QFile::exists(mpdDir+currentSong.file);
-                bool cueParseStatus=false;
-                if (parseCue) {
-                    DBUG << "Parsing cue file:" << currentSong.file << "mpdDir:" << mpdDir;
-                    cueParseStatus=CueFile::parse(currentSong.file, mpdDir, cueSongs, cueFiles);
-                    if (!cueParseStatus) {
-                        DBUG << "Failed to parse cue file!";
-                        continue;
-                    } else DBUG << "Parsed cue file, songs:" << cueSongs.count() << "files:" << cueFiles;
-                }
-                if (cueParseStatus &&
-                    (cueFiles.count()<cueSongs.count() || (albumItem && albumItem->data()==Song::unknown() && albumItem->parentItem()->data()==Song::unknown()))) {
-
-                    bool canUseThisCueFile=true;
-                    foreach (const Song &s, cueSongs) {
-                        if (!QFile::exists(mpdDir+s.name())) {
-                            DBUG << QString(mpdDir+s.name()) << "is referenced in cue file, but does not exist in MPD folder";
-                            canUseThisCueFile=false;
-                            break;
-                        }
-                    }
+    DBUG << "Songs:" << songs.count() << "artists:" << partitions.count() << "playlists:" << playlists.count() << "parallel:" << parallel;
+    if (parallel) {
+        QtConcurrent::blockingMap(partitions, LibraryPartitionBuilder(songs));
+    } else {
+        LibraryPartitionBuilder builder(songs);
+        for (int i=0; i<partitions.count(); ++i) {
+            builder(partitions[i]);
+        }
+    }
+    foreach (const LibraryPartition &p, partitions) {
+        rootItem->addGenres(p.artist->genres());
+    }
 
-                    if (!canUseThisCueFile) {
-                        continue;
-                    }
+    MusicLibraryItemAlbum *albumItem = 0;
+    QString lastSongFile;
+    int lastPrevSong=-2;
+    CueCache noCueCache; // Used if the caller has not passed a cache - results are then not saved
+    QSet<QString> libraryFiles;
+    for (int pl=0; pl<playlists.count(); ++pl) {
+        Song currentSong=songs.at(playlists.at(pl).first);
+        int prev=playlists.at(pl).second;
+
+        // If there have been tracks since the last playlist, then start from the album of the track that
+        // preceded this playlist. Otherwise, continue from where the previous playlist left off.
+        if (prev!=lastPrevSong) {
+            lastPrevSong=prev;
+            if (prev<0) {
+                artistItem=0;
+                albumItem=0;
+                lastSongFile=QString();
+            } else {
+                const Song &prevTrack=songs.at(prev);
+                artistItem=rootItem->artist(prevTrack, false);
+                albumItem=artistItem ? artistItem->album(prevTrack, false) : 0;
+                lastSongFile=prevTrack.file;
+            }
+        }
 
-                    bool canUseCueFileTracks=false;
-                    QList<Song> fixedCueSongs; // Songs taken from cueSongs that have been updated...
-
-                    if (albumItem) {
-                        QMap<QString, Song> origFiles=albumItem->getSongs(cueFiles);
-                        DBUG << "Original files:" << origFiles.keys();
-                        if (origFiles.size()==cueFiles.size()) {
-                            // We have a previous album, if any of the details of the songs from the cue are empty,
-                            // use those from the album...
-                            bool setTimeFromSource=origFiles.size()==cueSongs.size();
-                            quint32 albumTime=1==cueFiles.size() ? albumItem->totalTime() : 0;
-                            quint32 usedAlbumTime=0;
-                            foreach (const Song &orig, cueSongs) {
-                                Song s=orig;
-                                Song albumSong=origFiles[s.name()];
-                                s.setName(QString()); // CueFile has placed source file name here!
-                                if (s.artist.isEmpty() && !albumSong.artist.isEmpty()) {
-                                    s.artist=albumSong.artist;
-                                    DBUG << "Get artist from album" << albumSong.artist;
-                                }
-                                if (s.composer().isEmpty() && !albumSong.composer().isEmpty()) {
-                                    s.setComposer(albumSong.composer());
-                                    DBUG << "Get composer from album" << albumSong.composer();
-                                }
-                                if (s.album.isEmpty() && !albumSong.album.isEmpty()) {
-                                    s.album=albumSong.album;
-                                    DBUG << "Get album from album" << albumSong.album;
-                                }
-                                if (s.albumartist.isEmpty() && !albumSong.albumartist.isEmpty()) {
-                                    s.albumartist=albumSong.albumartist;
-                                    DBUG << "Get albumartist from album" << albumSong.albumartist;
-                                }
-                                if (0==s.year && 0!=albumSong.year) {
-                                    s.year=albumSong.year;
-                                    DBUG << "Get year from album" << albumSong.year;
-                                }
-                                if (0==s.time && setTimeFromSource) {
-                                    s.time=albumSong.time;
-                                } else if (0!=albumTime) {
-                                    // Try to set duration of last track by subtracting previous track durations from album duration...
-                                    if (0==s.time) {
-                                        s.time=albumTime-usedAlbumTime;
-                                    } else {
-                                        usedAlbumTime+=s.time;
-                                    }
-                                }
-                                fixedCueSongs.append(s);
-                            }
-                            canUseCueFileTracks=true;
-                        } else DBUG << "ERROR: file count mismatch" << origFiles.size() << cueFiles.size();
-                    } else DBUG << "ERROR: No album???";
-
-                    if (!canUseCueFileTracks) {
-                        // No revious album, or album had a different number of source files to the CUE file. If so, then we need to ensure
-                        // all tracks have meta data - otherwise just fallback to listing file + cue
-                        foreach (const Song &orig, cueSongs) {
-                            Song s=orig;
-                            s.setName(QString()); // CueFile has placed source file name here!
-                            if (s.artist.isEmpty() || s.album.isEmpty()) {
-                                break;
-                            }
-                            fixedCueSongs.append(s);
-                        }
+        MusicLibraryItemAlbum *prevAlbum=albumItem;
+        QString prevSongFile=lastSongFile;
+        QList<Song> cueSongs; // List of songs from cue file
+        QSet<QString> cueFiles; // List of source (flac, mp3, etc) files referenced in cue file
 
-                        if (fixedCueSongs.count()==cueSongs.count()) {
-                            canUseCueFileTracks=true;
-                        } else DBUG << "ERROR: Not all cue tracks had meta data";
+        DBUG << "Got playlist item" << currentSong.file << "prevFile:" << prevSongFile;
+
+        bool parseCue=canSplitCue && currentSong.isCueFile() && !mpdDir.startsWith(constHttpProtocol);
+        bool cueParseStatus=false;
+        if (parseCue) {
+            if (!cueCache) {
+                cueCache=&noCueCache;
+            }
+            CueCache::Status status=cueCache->parse(currentSong.file, mpdDir, cueSongs, cueFiles);
+            if (CueCache::Failed==status) {
+                DBUG << "Failed to parse cue file!";
+                continue;
+            }
+            cueParseStatus=CueCache::Parsed==status;
+            if (cueParseStatus) {
+                DBUG << "Parsed cue file, songs:" << cueSongs.count() << "files:" << cueFiles;
+            }
+        }
+        if (cueParseStatus &&
+            (cueFiles.count()<cueSongs.count() || (albumItem && albumItem->data()==Song::unknown() && albumItem->parentItem()->data()==Song::unknown()))) {
+
+            // Files that MPD has just listed must exist, so only check the disk for others.
+            if (libraryFiles.isEmpty()) {
+                foreach (const Song &s, songs) {
+                    if (Song::Playlist!=s.type) {
+                        libraryFiles.insert(s.file);
                     }
+                }
+            }
+            bool canUseThisCueFile=true;
+            foreach (const Song &s, cueSongs) {
+                if (!libraryFiles.contains(s.name()) && !QFile::exists(mpdDir+s.name())) {
+                    DBUG << QString(mpdDir+s.name()) << "is referenced in cue file, but does not exist in MPD folder";
+                    canUseThisCueFile=false;
+                    break;
+                }
+            }
 
-                    if (canUseCueFileTracks) {
-                        QSet<MusicLibraryItemAlbum *> updatedAlbums;
-                        updatedAlbums.insert(albumItem);
-                        foreach (Song s, fixedCueSongs) {
-                            s.fillEmptyFields();
-                            if (!artistItem || s.albumArtist()!=artistItem->data()) {
-                                artistItem = rootItem->artist(s);
-                            }
-                            if (!albumItem || s.year!=albumItem->year() || albumItem->parentItem()!=artistItem || s.album!=albumItem->data()) {
-                                albumItem = artistItem->album(s);
-                            }
-                            DBUG << "Create new track from cue" << s.file << s.title << s.artist << s.albumartist << s.album;
-                            songItem=new MusicLibraryItemSong(s, albumItem);
-                            QSet<QString> songGenres=songItem->allGenres();
-                            albumItem->append(songItem);
-                            albumItem->addGenres(songGenres);
-                            artistItem->addGenres(songGenres);
-                            rootItem->addGenres(songGenres);
-                            updatedAlbums.insert(albumItem);
-                        }
+            if (!canUseThisCueFile) {
+                continue;
+            }
 
-                        // For each album that was updated/created, remove any source files referenced in cue file...
-                        foreach (MusicLibraryItemAlbum *al, updatedAlbums) {
-                            if (al) {
-                                al->removeAll(cueFiles);
-                            }
+            bool canUseCueFileTracks=false;
+            QList<Song> fixedCueSongs; // Songs taken from cueSongs that have been updated...
+
+            if (albumItem) {
+                QMap<QString, Song> origFiles=albumItem->getSongs(cueFiles);
+                DBUG << "Original files:" << origFiles.keys();
+                if (origFiles.size()==cueFiles.size()) {
+                    // We have a previous album, if any of the details of the songs from the cue are empty,
+                    // use those from the album...
+                    bool setTimeFromSource=origFiles.size()==cueSongs.size();
+                    quint32 albumTime=1==cueFiles.size() ? albumItem->totalTime() : 0;
+                    quint32 usedAlbumTime=0;
+                    foreach (const Song &orig, cueSongs) {
+                        Song s=orig;
+                        Song albumSong=origFiles[s.name()];
+                        s.setName(QString()); // CueFile has placed source file name here!
+                        if (s.artist.isEmpty() && !albumSong.artist.isEmpty()) {
+                            s.artist=albumSong.artist;
+                            DBUG << "Get artist from album" << albumSong.artist;
                         }
-                        if (prevAlbum && !updatedAlbums.contains(prevAlbum)) {
-                            DBUG << "Removing" << cueFiles.count() << " files from " << prevAlbum->data();
-                            prevAlbum->removeAll(cueFiles);
+                        if (s.composer().isEmpty() && !albumSong.composer().isEmpty()) {
+                            s.setComposer(albumSong.composer());
+                            DBUG << "Get composer from album" << albumSong.composer();
                         }
-
-                        // Remove any artist/album that was created and is now empty.
-                        // This will happen if the source file (e.g. the flac file) does not have any metadata...
-                        if (prevAlbum && 0==prevAlbum->childCount()) {
-                            DBUG << "Removing empty previous album" << prevAlbum->data();
-                            MusicLibraryItemArtist *ar=static_cast<MusicLibraryItemArtist *>(prevAlbum->parentItem());
-                            ar->remove(prevAlbum);
-                            if (0==ar->childCount()) {
-                                rootItem->remove(ar);
+                        if (s.album.isEmpty() && !albumSong.album.isEmpty()) {
+                            s.album=albumSong.album;
+                            DBUG << "Get album from album" << albumSong.album;
+                        }
+                        if (s.albumartist.isEmpty() && !albumSong.albumartist.isEmpty()) {
+                            s.albumartist=albumSong.albumartist;
+                            DBUG << "Get albumartist from album" << albumSong.albumartist;
+                        }
+                        if (0==s.year && 0!=albumSong.year) {
+                            s.year=albumSong.year;
+                            DBUG << "Get year from album" << albumSong.year;
+                        }
+                        if (0==s.time && setTimeFromSource) {
+                            s.time=albumSong.time;
+                        } else if (0!=albumTime) {
+                            // Try to set duration of last track by subtracting previous track durations from album duration...
+                            if (0==s.time) {
+                                s.time=albumTime-usedAlbumTime;
+                            } else {
+                                usedAlbumTime+=s.time;
                             }
                         }
+                        fixedCueSongs.append(s);
                     }
+                    canUseCueFileTracks=true;
+                } else DBUG << "ERROR: file count mismatch" << origFiles.size() << cueFiles.size();
+            } else DBUG << "ERROR: No album???";
+
+            if (!canUseCueFileTracks) {
+                // No revious album, or album had a different number of source files to the CUE file. If so, then we need to ensure
+                // all tracks have meta data - otherwise just fallback to listing file + cue
+                foreach (const Song &orig, cueSongs) {
+                    Song s=orig;
+                    s.setName(QString()); // CueFile has placed source file name here!
+                    if (s.artist.isEmpty() || s.album.isEmpty()) {
+                        break;
+                    }
+                    fixedCueSongs.append(s);
                 }
 
-                // Add playlist file (or cue file) to current album, if it has the same path!
-                // This assumes that MPD always send playlists as the last file...
-                if (!prevSongFile.isEmpty() && Utils::getDir(prevSongFile)==Utils::getDir(currentSong.file)) {
-                    currentSong.albumartist=currentSong.artist=artistItem->data();
-                    currentSong.album=albumItem->data();
-                    currentSong.time=albumItem->totalTime();
-                    DBUG << "Adding playlist file to" << albumItem->parentItem()->data() << albumItem->data() << (void *)albumItem;
-                    songItem = new MusicLibraryItemSong(currentSong, albumItem);
+                if (fixedCueSongs.count()==cueSongs.count()) {
+                    canUseCueFileTracks=true;
+                } else DBUG << "ERROR: Not all cue tracks had meta data";
+            }
+
+            if (canUseCueFileTracks) {
+                QSet<MusicLibraryItemAlbum *> updatedAlbums;
+                updatedAlbums.insert(albumItem);
+                foreach (Song s, fixedCueSongs) {
+                    s.fillEmptyFields();
+                    if (!artistItem || s.albumArtist()!=artistItem->data()) {
+                        artistItem = rootItem->artist(s);
+                    }
+                    if (!albumItem || s.year!=albumItem->year() || albumItem->parentItem()!=artistItem || s.album!=albumItem->data()) {
+                        albumItem = artistItem->album(s);
+                    }
+                    DBUG << "Create new track from cue" << s.file << s.title << s.artist << s.albumartist << s.album;
+                    MusicLibraryItemSong *songItem=new MusicLibraryItemSong(s, albumItem);
+                    lastSongFile=songItem->file();
+                    QSet<QString> songGenres=songItem->allGenres();
                     albumItem->append(songItem);
+                    albumItem->addGenres(songGenres);
+                    artistItem->addGenres(songGenres);
+                    rootItem->addGenres(songGenres);
+                    updatedAlbums.insert(albumItem);
+                }
+
+                // For each album that was updated/created, remove any source files referenced in cue file...
+                foreach (MusicLibraryItemAlbum *al, updatedAlbums) {
+                    if (al) {
+                        al->removeAll(cueFiles);
+                    }
+                }
+                if (prevAlbum && !updatedAlbums.contains(prevAlbum)) {
+                    DBUG << "Removing" << cueFiles.count() << " files from " << prevAlbum->data();
+                    prevAlbum->removeAll(cueFiles);
+                }
+
+                // Remove any artist/album that was created and is now empty.
+                // This will happen if the source file (e.g. the flac file) does not have any metadata...
+                if (prevAlbum && 0==prevAlbum->childCount()) {
+                    DBUG << "Removing empty previous album" << prevAlbum->data();
+                    MusicLibraryItemArtist *ar=static_cast<MusicLibraryItemArtist *>(prevAlbum->parentItem());
+                    ar->remove(prevAlbum);
+                    if (0==ar->childCount()) {
+                        rootItem->remove(ar);
+                    }
                 }
-                continue;
-            }
-//            if (currentSong.isEmpty()) {
-//                continue;
-//            }
-
-            currentSong.fillEmptyFields();
-            if (!artistItem || currentSong.artistOrComposer()!=artistItem->data()) {
-                artistItem = rootItem->artist(currentSong);
-                DBUG << "New artist item for " << currentSong.file << artistItem->data() << (void *)artistItem;
             }
-            if (!albumItem || currentSong.year!=albumItem->year() || albumItem->parentItem()!=artistItem || currentSong.albumId()!=albumItem->albumId()) {
-                albumItem = artistItem->album(currentSong);
-                DBUG << "New album item for " << currentSong.file << artistItem->data() << albumItem->data() << (void *)albumItem;
-            }           
-            songItem=new MusicLibraryItemSong(currentSong, albumItem);
-            QSet<QString> songGenres=songItem->allGenres();
+        }
+
+        // Add playlist file (or cue file) to current album, if it has the same path!
+        // This assumes that MPD always send playlists as the last file...
+        if (albumItem && !prevSongFile.isEmpty() && Utils::getDir(prevSongFile)==Utils::getDir(currentSong.file)) {
+            currentSong.albumartist=currentSong.artist=artistItem->data();
+            currentSong.album=albumItem->data();
+            currentSong.time=albumItem->totalTime();
+            DBUG << "Adding playlist file to" << albumItem->parentItem()->data() << albumItem->data() << (void *)albumItem;
+            MusicLibraryItemSong *songItem = new MusicLibraryItemSong(currentSong, albumItem);
+            lastSongFile=songItem->file();
             albumItem->append(songItem);
-            albumItem->addGenres(songGenres);
-            artistItem->addGenres(songGenres);
-            rootItem->addGenres(songGenres);
-        }/* else if (childDirs) {
-        }*/
+        }
     }
 }
 
@@ -794,6 +915,34 @@ DirViewItemRoot * MPDParseUtils::parseDirViewItems(const QByteArray &data, bool
     return rootItem;
 }
 
+// Parse the response to "lsinfo <dir>" - returning the names of the sub-folders, and files, it contains.
+void MPDParseUtils::parseDirListing(const QByteArray &data, bool parsePlaylists, QStringList &dirs, QStringList &files)
+{
+    QList<QByteArray> lines = data.split('\n');
+
+    foreach (const QByteArray &line, lines) {
+        QString path;
+        bool isDir=false;
+
+        if (line.startsWith(constDirectoryKey)) {
+            path=QString::fromUtf8(line.mid(constDirectoryKey.length()));
+            isDir=true;
+        } else if (line.startsWith(constFileKey)) {
+            path=QString::fromUtf8(line.mid(constFileKey.length()));
+        } else if (parsePlaylists && line.startsWith(constPlaylistKey)) {
+            path=QString::fromUtf8(line.mid(constPlaylistKey.length()));
+        }
+        if (!path.isEmpty()) {
+            QString name=path.mid(path.lastIndexOf(Utils::constDirSep)+1);
+            if (isDir) {
+                dirs.append(name);
+            } else {
+                files.append(name);
+            }
+        }
+    }
+}
+
 QList<Output> MPDParseUtils::parseOuputs(const QByteArray &data)
 {
     QList<Output> outputs;
@@ -838,6 +987,24 @@ QByteArray MPDParseUtils::parseSticker(const QByteArray &data, const QByteArray
     return QByteArray();
 }
 
+// Parse response of 'sticker find' - a list of file/sticker pairs.
+QMap<QString, QByteArray> MPDParseUtils::parseStickers(const QByteArray &data, const QByteArray &sticker)
+{
+    QMap<QString, QByteArray> stickers;
+    QList<QByteArray> lines = data.split('\n');
+    QByteArray key=constSticker+sticker+'=';
+    QString file;
+    foreach (const QByteArray &line, lines) {
+        if (line.startsWith(constFileKey)) {
+            file=QString::fromUtf8(line.mid(constFileKey.length()));
+        } else if (!file.isEmpty() && line.startsWith(key)) {
+            stickers.insert(file, line.mid(key.length()));
+            file=QString();
+        }
+    }
+    return stickers;
+}
+
 QString MPDParseUtils::addStreamName(const QString &url, const QString &name)
 {
     return name.isEmpty()
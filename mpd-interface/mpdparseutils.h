@@ -28,7 +28,9 @@
 #define MPD_PARSE_UTILS_H
 
 #include <QString>
+#include <QStringList>
 #include <QSet>
+#include <QMap>
 #include "config.h"
 
 struct Song;
@@ -38,6 +40,7 @@ struct MPDStatsValues;
 struct MPDStatusValues;
 class DirViewItemRoot;
 class MusicLibraryItemRoot;
+class CueCache;
 
 namespace MPDParseUtils
 {
@@ -76,10 +79,12 @@ namespace MPDParseUtils
     extern void setGroupSingle(bool g);
     extern void parseLibraryItems(const QByteArray &data, const QString &mpdDir, long mpdVersion,
                                   bool isMopidy, MusicLibraryItemRoot *rootItem, bool parsePlaylists=true,
-                                  QSet<QString> *childDirs=0);
+                                  QSet<QString> *childDirs=0, CueCache *cueCache=0);
     extern DirViewItemRoot * parseDirViewItems(const QByteArray &data, bool isMopidy);
+    extern void parseDirListing(const QByteArray &data, bool parsePlaylists, QStringList &dirs, QStringList &files);
     extern QList<Output> parseOuputs(const QByteArray &data);
     extern QByteArray parseSticker(const QByteArray &data, const QByteArray &sticker);
+    extern QMap<QString, QByteArray> parseStickers(const QByteArray &data, const QByteArray &sticker);
     extern QString addStreamName(const QString &url, const QString &name);
     extern QString getStreamName(const QString &url);
     extern QString getAndRemoveStreamName(QString &url);
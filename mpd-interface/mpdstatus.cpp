@@ -41,6 +41,20 @@ MPDStatus::MPDStatus()
 void MPDStatus::update(const MPDStatusValues &v)
 {
     values=v;
-    setGuessedElapsed(v.timeElapsed);
+    clock.restart();
     emit updated();
 }
+
+qint32 MPDStatus::guessedElapsed() const
+{
+    qint32 e=interpolatedElapsed();
+    return values.timeTotal>0 && e>values.timeTotal ? values.timeTotal : e;
+}
+
+qint32 MPDStatus::interpolatedElapsed() const
+{
+    if (MPDState_Playing!=values.state || values.timeElapsed<0 || !clock.isValid()) {
+        return values.timeElapsed;
+    }
+    return values.timeElapsed+(qint32)((clock.elapsed()+500)/1000);
+}
@@ -28,6 +28,7 @@
 #define MPD_STATUS_H
 
 #include <QObject>
+#include <QElapsedTimer>
 
 enum MPDState {
     MPDState_Inactive,
@@ -116,10 +117,11 @@ public:
     const QString & error() const { return values.error; }
     MPDStatusValues getValues() const { return values; }
 
-    // Cantata does not poll MPD for current position, but instead used a timer
-    // This timer will update its value here - so this can be used elsewhere...
-    void setGuessedElapsed(qint32 v) { guessed=v; }
-    qint32 guessedElapsed() const { return guessed; }
+    // Cantata does not poll MPD for current position, but instead interpolates this from the
+    // last status and the time since this was received. guessedElapsed() is limited to the
+    // song's duration, interpolatedElapsed() is not - and can be used to detect clock drift.
+    qint32 guessedElapsed() const;
+    qint32 interpolatedElapsed() const;
 
 public Q_SLOTS:
     void update(const MPDStatusValues &v);
@@ -132,8 +134,8 @@ private:
     MPDStatus& operator=(const MPDStatus& other);
 
 private:
-    qint32 guessed;
     MPDStatusValues values;
+    QElapsedTimer clock;
 };
 
 #endif
@@ -38,6 +38,8 @@
 #include <QLatin1Char>
 #include <QtAlgorithms>
 #include <QUrl>
+#include <QMutex>
+#include <QMutexLocker>
 
 //static const quint8 constOnlineDiscId=0xEE;
 
@@ -406,9 +408,61 @@ void Song::clear()
     genre.clear();
     size = 0;
     extra.clear();
+    extraFields = 0;
     type = Standard;
 }
 
+static QMutex internMutex;
+static QSet<QString> internPool;
+static const int constMinInternPruneSize=1024;
+static int internPruneSize=constMinInternPruneSize;
+
+QString Song::intern(const QString &str)
+{
+    if (str.isEmpty()) {
+        return str;
+    }
+
+    QMutexLocker locker(&internMutex);
+    QSet<QString>::ConstIterator it=internPool.constFind(str);
+    if (it!=internPool.constEnd()) {
+        return *it;
+    }
+
+    if (internPool.size()>=internPruneSize) {
+        // Remove any strings that are now only referenced by the pool - e.g. from a previous library...
+        QSet<QString>::Iterator i=internPool.begin();
+        while (i!=internPool.end()) {
+            if (i->isDetached()) {
+                i=internPool.erase(i);
+            } else {
+                ++i;
+            }
+        }
+        internPruneSize=qMax(constMinInternPruneSize, internPool.size()*2);
+    }
+    internPool.insert(str);
+    return str;
+}
+
+void Song::internTags()
+{
+    album=intern(album);
+    artist=intern(artist);
+    albumartist=intern(albumartist);
+    genre=intern(genre);
+    // Only intern extra fields that are likely to be repeated - not comments, names, etc.
+    static const quint16 constRepeatedFields=Composer|Performer|AlbumSort|ArtistSort|AlbumArtistSort;
+    if (extraFields&constRepeatedFields) {
+        for (quint16 f=Composer; f<=AlbumArtistSort; f<<=1) {
+            if ((f&constRepeatedFields) && hasExtraField(f)) {
+                int idx=extraIndex(f);
+                extra[idx]=intern(extra.at(idx));
+            }
+        }
+    }
+}
+
 const QLatin1Char Song::constGenreSep(',');
 const QLatin1Char Song::constFieldSep('\001');
 
@@ -545,11 +599,16 @@ QString Song::toolTip() const
 
 void Song::setExtraField(quint16 f, const QString &v)
 {
+    int idx=extraIndex(f);
     if (v.isEmpty()) {
-        extra.remove(f);
-        extraFields&=~f;
+        if (hasExtraField(f)) {
+            extra.remove(idx);
+            extraFields&=~f;
+        }
+    } else if (hasExtraField(f)) {
+        extra[idx]=v;
     } else {
-        extra[f]=v;
+        extra.insert(idx, v);
         extraFields|=f;
     }
 }
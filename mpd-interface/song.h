@@ -31,6 +31,7 @@
 #include <QString>
 #include <QSet>
 #include <QHash>
+#include <QVector>
 #include <QMetaType>
 #include "config.h"
 #include "support/utils.h"
@@ -90,7 +91,9 @@ struct Song
     QString albumartist;
     QString title;
     QString genre;
-    QHash<quint16, QString> extra;
+    // Values of extra fields, ordered by their bit in extraFields. Most songs have none, or only a few,
+    // so this is much smaller than a hash.
+    QVector<QString> extra;
     quint16 extraFields;
     quint8 disc;
     mutable quint8 priority;
@@ -120,6 +123,9 @@ struct Song
     static QString displayAlbum(const QString &albumName, quint16 albumYear);
     static QString combineGenres(const QSet<QString> &genres);
     static bool isComposerGenre(const QString &genre) { return composerGenres().contains(genre); }
+    // Artist, album, genre, etc. are repeated across many songs. intern() returns a shared copy of the
+    // string, so that each distinct value is only stored once.
+    static QString intern(const QString &str);
 
     Song();
     Song(const Song &o) { *this=o; }
@@ -128,14 +134,14 @@ struct Song
     bool operator!=(const Song &o) const { return !(*this==o); }
     bool operator<(const Song &o) const;
     int compareTo(const Song &o) const;
-    virtual ~Song() { }
     bool isEmpty() const;
     bool isDifferent(const Song &s) const { return year!=s.year || artist!=s.artist || album!=s.album || title!=s.title || name()!=s.name(); }
     void guessTags();
     void revertGuessedTags();
     void fillEmptyFields();
     void setKey(int location);
-    virtual void clear();
+    void clear();
+    void internTags();
     void addGenre(const QString &g);
     QStringList genres() const;
     void orderGenres();
@@ -150,8 +156,15 @@ struct Song
     QString toolTip() const;
     QString displayGenre() const { return QString(genre).replace(constGenreSep, QLatin1String(", ")); }
 
-    QString extraField(quint16 f) const { return hasExtraField(f) ? extra[f] : QString(); }
+    QString extraField(quint16 f) const { return hasExtraField(f) ? extra.at(extraIndex(f)) : QString(); }
     bool hasExtraField(quint16 f) const { return extraFields&f; }
+    int extraIndex(quint16 f) const {
+        int idx=0;
+        for (quint16 prev=extraFields&(f-1); prev; prev&=prev-1) {
+            ++idx;
+        }
+        return idx;
+    }
     void setExtraField(quint16 f, const QString &v);
     QString name() const { return extraField(Name); }
     void setName(const QString &v) { setExtraField(Name, v); }
@@ -181,7 +194,7 @@ struct Song
 
     QString artistSortString() const { return hasAlbumArtistSort() ? albumArtistSort() : hasArtistSort() ? artistSort() : QString(); }
 
-    void clearExtra() { extra.clear(); }
+    void clearExtra() { extra.clear(); extraFields=0; }
 
     static bool isVariousArtists(const QString &str);
     bool isVariousArtists() const { return isVariousArtists(albumArtist()); }
@@ -23,12 +23,14 @@
 
 #include "networkaccessmanager.h"
 #include "networkproxyfactory.h"
+#include "networkcache.h"
 #include "gui/settings.h"
 #include "config.h"
 #include "support/globalstatic.h"
 #include <QTimerEvent>
 #include <QTimer>
 #include <QSslSocket>
+#include <string.h>
 
 #include <QDebug>
 static bool debugEnabled=false;
@@ -39,6 +41,81 @@ void NetworkAccessManager::enableDebug()
 }
 
 static const int constMaxRedirects=5;
+// Qt itself allows 6 connections per host. Keep below this, so that jobs waiting for a connection
+// are queued by us - and can then be started in priority order.
+static const int constMaxJobsPerHost=4;
+
+static inline bool useCache(const QNetworkRequest &req)
+{
+    return QNetworkRequest::AlwaysNetwork!=req.attribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferNetwork).toInt();
+}
+
+// Returns the key used to detect identical requests, or an empty string if the request should not be
+// shared. Requests that bypass the cache (large downloads and streams), or that ask for part of a
+// resource, or set their own pre-conditions, are never shared.
+static QString requestKey(const QNetworkRequest &req)
+{
+    if (!useCache(req) || req.hasRawHeader("Range") || req.hasRawHeader("If-None-Match") || req.hasRawHeader("If-Modified-Since")) {
+        return QString();
+    }
+
+    QUrl u(req.url());
+    u.setFragment(QString());
+    if ((80==u.port() && QLatin1String("http")==u.scheme()) || (443==u.port() && QLatin1String("https")==u.scheme())) {
+        u.setPort(-1);
+    }
+    QString key=QString::fromLatin1(u.toEncoded());
+    QList<QByteArray> headers=req.rawHeaderList();
+    qSort(headers);
+    foreach (const QByteArray &h, headers) {
+        key+=QLatin1Char('\n')+QString::fromLatin1(h.toLower())+QLatin1Char(':')+QString::fromLatin1(req.rawHeader(h));
+    }
+    return key;
+}
+
+// Reply given to jobs that were attached to an identical request - contains a copy of its result.
+struct SharedNetworkReply : public QNetworkReply
+{
+    SharedNetworkReply(QNetworkReply *src, const QByteArray &d, QObject *parent)
+        : QNetworkReply(parent)
+        , data(d)
+        , offset(0)
+    {
+        setRequest(src->request());
+        setUrl(src->url());
+        setOperation(src->operation());
+        foreach (const QByteArray &h, src->rawHeaderList()) {
+            setRawHeader(h, src->rawHeader(h));
+        }
+        setAttribute(QNetworkRequest::HttpStatusCodeAttribute, src->attribute(QNetworkRequest::HttpStatusCodeAttribute));
+        setAttribute(QNetworkRequest::HttpReasonPhraseAttribute, src->attribute(QNetworkRequest::HttpReasonPhraseAttribute));
+        setError(src->error(), src->errorString());
+        open(QIODevice::ReadOnly|QIODevice::Unbuffered);
+        #if QT_VERSION >= 0x050000
+        setFinished(true);
+        #endif
+        if (!data.isEmpty()) {
+            QTimer::singleShot(0, this, SIGNAL(readyRead()));
+        }
+        QTimer::singleShot(0, this, SIGNAL(finished()));
+    }
+    void abort() { }
+    qint64 bytesAvailable() const { return (data.size()-offset)+QIODevice::bytesAvailable(); }
+    qint64 readData(char *d, qint64 maxlen)
+    {
+        qint64 len=qMin(maxlen, (qint64)(data.size()-offset));
+        if (len<=0) {
+            return -1;
+        }
+        memcpy(d, data.constData()+offset, len);
+        offset+=len;
+        return len;
+    }
+    qint64 writeData(const char *, qint64) { return -1; }
+
+    QByteArray data;
+    int offset;
+};
 
 NetworkJob::NetworkJob(NetworkAccessManager *p, const QUrl &u)
     : QObject(p)
@@ -46,15 +123,37 @@ NetworkJob::NetworkJob(NetworkAccessManager *p, const QUrl &u)
     , lastDownloadPc(0)
     , job(0)
     , origU(u)
+    , limiter(0)
+    , timeout(0)
+    , fresh(false)
+    , primary(0)
 {
     QTimer::singleShot(0, this, SLOT(jobFinished()));
 }
 
+NetworkJob::NetworkJob(NetworkAccessManager *p, const QNetworkRequest &req, int t)
+    : QObject(p)
+    , numRedirects(0)
+    , lastDownloadPc(0)
+    , job(0)
+    , origU(req.url())
+    , limiter(p)
+    , request(req)
+    , timeout(t)
+    , fresh(false)
+    , primary(0)
+{
+}
+
 NetworkJob::NetworkJob(QNetworkReply *j)
     : QObject(j->parent())
     , numRedirects(0)
     , lastDownloadPc(0)
     , job(j)
+    , limiter(0)
+    , timeout(0)
+    , fresh(false)
+    , primary(0)
 {
     origU=j->url();
     connectJob();
@@ -64,13 +163,17 @@ NetworkJob::NetworkJob(QNetworkReply *j)
 NetworkJob::~NetworkJob()
 {
     DBUG << (void *)this << (void *)job;
+    detach();
     cancelJob();
+    release();
 }
 
 void NetworkJob::cancelAndDelete()
 {
     DBUG << (void *)this << (void *)job;
+    detach();
     cancelJob();
+    release();
     deleteLater();
 }
 
@@ -88,9 +191,8 @@ void NetworkJob::connectJob()
     connect(job, SIGNAL(destroyed(QObject *)), this, SLOT(jobDestroyed(QObject *)));
 }
 
-void NetworkJob::cancelJob()
+void NetworkJob::disconnectJob()
 {
-    DBUG << (void *)this << (void *)job;
     if (job) {
         disconnect(job, SIGNAL(finished()), this, SLOT(jobFinished()));
         disconnect(job, SIGNAL(readyRead()), this, SLOT(handleReadyRead()));
@@ -98,6 +200,14 @@ void NetworkJob::cancelJob()
         disconnect(job, SIGNAL(uploadProgress(qint64, qint64)), this, SIGNAL(uploadProgress(qint64, qint64)));
         disconnect(job, SIGNAL(downloadProgress(qint64, qint64)), this, SLOT(downloadProg(qint64, qint64)));
         disconnect(job, SIGNAL(destroyed(QObject *)), this, SLOT(jobDestroyed(QObject *)));
+    }
+}
+
+void NetworkJob::cancelJob()
+{
+    DBUG << (void *)this << (void *)job;
+    if (job) {
+        disconnectJob();
         job->close();
         job->abort();
         job->deleteLater();
@@ -113,6 +223,45 @@ void NetworkJob::abortJob()
     }
 }
 
+void NetworkJob::release()
+{
+    if (limiter) {
+        NetworkAccessManager *l=limiter;
+        limiter=0;
+        l->released(this);
+    }
+}
+
+void NetworkJob::detach()
+{
+    if (primary) {
+        primary->followers.removeAll(this);
+        primary=0;
+    } else if (limiter && !followers.isEmpty()) {
+        // Others are still waiting for this result, so let one of them take over the request...
+        limiter->transfer(this, followers.takeFirst());
+    }
+}
+
+void NetworkJob::shareResult()
+{
+    if (followers.isEmpty()) {
+        return;
+    }
+
+    // Callers only read the data once finished() has been emitted, so it is all still available.
+    QByteArray data=job->peek(job->bytesAvailable());
+    DBUG << (void *)this << job->url().toString() << "share with" << followers.count() << "jobs," << data.length() << "bytes";
+    foreach (NetworkJob *f, followers) {
+        f->primary=0;
+        // The shared reply's headers are those of the final (redirected) response - so do not follow them again.
+        f->numRedirects=constMaxRedirects;
+        f->job=new SharedNetworkReply(job, data, f->parent());
+        f->connectJob();
+    }
+    followers.clear();
+}
+
 void NetworkJob::jobFinished()
 {
     DBUG << (void *)this << (void *)job;
@@ -127,7 +276,10 @@ void NetworkJob::jobFinished()
 
     QVariant redirect = j->header(QNetworkRequest::LocationHeader);
     if (redirect.isValid() && ++numRedirects<constMaxRedirects) {
-        QNetworkReply *newJob=static_cast<BASE_NETWORK_ACCESS_MANAGER *>(j->manager())->get(QNetworkRequest(redirect.toUrl()));
+        // Keep original request headers (e.g. User-Agent, Range) when following redirects
+        QNetworkRequest req(j->request());
+        req.setUrl(redirect.toUrl());
+        QNetworkReply *newJob=static_cast<BASE_NETWORK_ACCESS_MANAGER *>(j->manager())->get(req);
         DBUG << j->url().toString() << "redirected to" << newJob->url().toString();
         cancelJob();
         job=newJob;
@@ -136,6 +288,13 @@ void NetworkJob::jobFinished()
     }
 
     DBUG << job->url().toString() << job->error() << (0==job->error() ? QLatin1String("OK") : job->errorString());
+    if (job->manager() && job->manager()->cache() && useCache(job->request())) {
+        NetworkCache::record(origU, !job->attribute(QNetworkRequest::SourceIsFromCacheAttribute).toBool()
+                                        ? NetworkCache::Miss
+                                        : fresh ? NetworkCache::Hit : NetworkCache::Revalidated);
+    }
+    release();
+    shareResult();
     emit finished();
 }
 
@@ -144,6 +303,7 @@ void NetworkJob::jobDestroyed(QObject *o)
     DBUG << (void *)this << (void *)job;
     if (o==job) {
         job=0;
+        release();
     }
 }
 
@@ -187,6 +347,26 @@ NetworkAccessManager::NetworkAccessManager(QObject *parent)
         NetworkProxyFactory::self();
     }
     //#endif
+    if (enabled && NetworkCache::isEnabled()) {
+        setCache(new NetworkCache(this));
+    }
+}
+
+NetworkAccessManager::~NetworkAccessManager()
+{
+    // Jobs are our children, and so will be deleted after our members - therefore, they must not
+    // try to remove themselves from the queue.
+    foreach (NetworkJob *job, findChildren<NetworkJob *>()) {
+        job->limiter=0;
+        job->primary=0;
+        job->followers.clear();
+    }
+}
+
+void NetworkAccessManager::disableCache(QNetworkRequest &req)
+{
+    req.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysNetwork);
+    req.setAttribute(QNetworkRequest::CacheSaveControlAttribute, false);
 }
 
 NetworkJob * NetworkAccessManager::get(const QNetworkRequest &req, int timeout)
@@ -205,26 +385,128 @@ NetworkJob * NetworkAccessManager::get(const QNetworkRequest &req, int timeout)
     request.setRawHeader("User-Agent", userAgent);
 
     // Windows builds do not support HTTPS - unless QtNetwork is recompiled...
-    NetworkJob *reply=0;
     if (QLatin1String("https")==req.url().scheme() && !QSslSocket::supportsSsl()) {
         QUrl httpUrl=request.url();
         httpUrl.setScheme(QLatin1String("http"));
         request.setUrl(httpUrl);
         DBUG << "no ssl, use" << httpUrl.toString();
-        reply = new NetworkJob(BASE_NETWORK_ACCESS_MANAGER::get(request));
-        reply->setOrigUrl(req.url());
-    } else {
-        reply = new NetworkJob(BASE_NETWORK_ACCESS_MANAGER::get(request));
     }
 
-    if (0!=timeout) {
-        connect(reply, SIGNAL(destroyed()), SLOT(replyFinished()));
-        connect(reply, SIGNAL(finished()), SLOT(replyFinished()));
-        timers[reply] = startTimer(timeout);
+    QString key=requestKey(request);
+    if (!key.isEmpty()) {
+        QHash<QString, NetworkJob *>::ConstIterator it=inFlight.constFind(key);
+        if (it!=inFlight.constEnd()) {
+            NetworkJob *follower=new NetworkJob(this, request, timeout);
+            follower->setOrigUrl(req.url());
+            follower->limiter=0;
+            follower->primary=it.value();
+            it.value()->followers.append(follower);
+            DBUG << "attach to existing request" << request.url().toString() << it.value()->followers.count();
+            return follower;
+        }
+    }
+
+    NetworkJob *reply=new NetworkJob(this, request, timeout);
+    reply->setOrigUrl(req.url());
+    if (!key.isEmpty()) {
+        reply->key=key;
+        inFlight.insert(key, reply);
+    }
+    QString host=request.url().host();
+    if (running.value(host)<constMaxJobsPerHost) {
+        start(reply);
+    } else {
+        // Queue behind all jobs of the same, or higher, priority...
+        int pos=0;
+        for (; pos<queued.count() && queued.at(pos)->request.priority()<=request.priority(); ++pos) {
+        }
+        DBUG << "queue" << request.url().toString() << request.priority() << pos;
+        queued.insert(pos, reply);
     }
     return reply;
 }
 
+void NetworkAccessManager::start(NetworkJob *job)
+{
+    running[job->request.url().host()]++;
+    if (cache() && useCache(job->request)) {
+        job->fresh=NetworkCache::isFresh(job->request.url());
+    }
+    job->job=BASE_NETWORK_ACCESS_MANAGER::get(job->request);
+    job->connectJob();
+
+    if (0!=job->timeout) {
+        connect(job, SIGNAL(destroyed()), SLOT(replyFinished()));
+        connect(job, SIGNAL(finished()), SLOT(replyFinished()));
+        timers[job] = startTimer(job->timeout);
+    }
+}
+
+void NetworkAccessManager::released(NetworkJob *job)
+{
+    if (!job->key.isEmpty() && inFlight.value(job->key)==job) {
+        inFlight.remove(job->key);
+    }
+    if (queued.removeAll(job)) {
+        return;
+    }
+
+    QString host=job->request.url().host();
+    QHash<QString, int>::Iterator it=running.find(host);
+    if (it!=running.end() && --it.value()<=0) {
+        running.erase(it);
+    }
+    startQueued(host);
+}
+
+void NetworkAccessManager::transfer(NetworkJob *from, NetworkJob *to)
+{
+    DBUG << (void *)from << (void *)to << from->request.url().toString();
+    to->limiter=from->limiter;
+    to->request=from->request;
+    to->timeout=from->timeout;
+    to->fresh=from->fresh;
+    to->key=from->key;
+    to->numRedirects=from->numRedirects;
+    to->primary=0;
+    to->followers=from->followers;
+    foreach (NetworkJob *f, to->followers) {
+        f->primary=to;
+    }
+    from->limiter=0;
+    from->followers.clear();
+
+    if (!to->key.isEmpty()) {
+        inFlight.insert(to->key, to);
+    }
+    int idx=queued.indexOf(from);
+    if (-1!=idx) {
+        queued[idx]=to;
+    }
+    if (from->job) {
+        from->disconnectJob();
+        to->job=from->job;
+        from->job=0;
+        to->connectJob();
+    }
+    if (timers.contains(from)) {
+        timers.insert(to, timers.take(from));
+        connect(to, SIGNAL(destroyed()), SLOT(replyFinished()));
+        connect(to, SIGNAL(finished()), SLOT(replyFinished()));
+    }
+}
+
+void NetworkAccessManager::startQueued(const QString &host)
+{
+    for (int i=0; i<queued.count() && running.value(host)<constMaxJobsPerHost; ) {
+        if (queued.at(i)->request.url().host()==host) {
+            start(queued.takeAt(i));
+        } else {
+            ++i;
+        }
+    }
+}
+
 struct FakeNetworkReply : public QNetworkReply
 {
     FakeNetworkReply() : QNetworkReply(0)
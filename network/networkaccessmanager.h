@@ -34,7 +34,10 @@
 #define BASE_NETWORK_ACCESS_MANAGER QNetworkAccessManager
 //#endif
 #include <QNetworkReply>
+#include <QNetworkRequest>
 #include <QMap>
+#include <QHash>
+#include <QList>
 
 class QTimerEvent;
 class NetworkAccessManager;
@@ -61,6 +64,7 @@ public:
     QByteArray readAll() { return job ? job->readAll() : QByteArray(); }
     bool ok() const { return job && QNetworkReply::NoError==job->error(); }
     QVariant attribute(QNetworkRequest::Attribute code) const { return job ? job->attribute(code) : QVariant(); }
+    QByteArray rawHeader(const QByteArray &header) const { return job ? job->rawHeader(header) : QByteArray(); }
     qint64 bytesAvailable() const { return job ? job->bytesAvailable() : -1; }
     QByteArray read(qint64 maxlen) { return job ? job->read(maxlen) : QByteArray(); }
 
@@ -80,15 +84,30 @@ private Q_SLOTS:
 
 private:
     NetworkJob(NetworkAccessManager *p, const QUrl &u);
+    NetworkJob(NetworkAccessManager *p, const QNetworkRequest &req, int timeout);
     void connectJob();
+    void disconnectJob();
     void cancelJob();
     void abortJob();
+    void release();
+    void detach();
+    void shareResult();
 
 private:
     int numRedirects;
     int lastDownloadPc;
     QNetworkReply *job;
     QUrl origU;
+    // Only set for jobs that are queued, or running, within NetworkAccessManager's per-host limit
+    NetworkAccessManager *limiter;
+    QNetworkRequest request;
+    int timeout;
+    bool fresh; // Was there a fresh cache entry when the request was made?
+    // Identical requests made whilst this one is in progress are attached as followers, and are given
+    // a copy of the result when this job finishes.
+    QString key;
+    QList<NetworkJob *> followers;
+    NetworkJob *primary;
 
     friend class NetworkAccessManager;
 };
@@ -100,9 +119,11 @@ class NetworkAccessManager : public BASE_NETWORK_ACCESS_MANAGER
 public:
     static void enableDebug();
     static NetworkAccessManager * self();
+    // Large downloads, and streams, should not be stored in (or read from) the HTTP cache.
+    static void disableCache(QNetworkRequest &req);
 
     NetworkAccessManager(QObject *parent=0);
-    virtual ~NetworkAccessManager() { }
+    virtual ~NetworkAccessManager();
 
     NetworkJob * get(const QNetworkRequest &req, int timeout=0);
     NetworkJob * get(const QUrl &url, int timeout=0) { return get(QNetworkRequest(url), timeout); }
@@ -118,9 +139,18 @@ protected:
 private Q_SLOTS:
     void replyFinished();
 
+private:
+    void start(NetworkJob *job);
+    void released(NetworkJob *job);
+    void startQueued(const QString &host);
+    void transfer(NetworkJob *from, NetworkJob *to);
+
 private:
     bool enabled;
     QMap<NetworkJob *, int> timers;
+    QHash<QString, int> running; // Number of running jobs per host
+    QList<NetworkJob *> queued; // Sorted by priority
+    QHash<QString, NetworkJob *> inFlight; // Jobs that other identical requests may attach to
     friend class NetworkJob;
 };
 
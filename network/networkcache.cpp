@@ -0,0 +1,163 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2014 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "networkcache.h"
+#include "gui/settings.h"
+#include "support/utils.h"
+#include <QNetworkDiskCache>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QDateTime>
+#include <QDebug>
+
+static bool debugEnabled=false;
+#define DBUG if (debugEnabled) qWarning() << "NetworkCache" << __FUNCTION__
+void NetworkCache::enableDebug()
+{
+    debugEnabled=true;
+}
+
+const QLatin1String NetworkCache::constCacheDir("network/");
+
+static QMutex mutex;
+static QNetworkDiskCache *diskCache=0;
+static bool checkedConfig=false;
+static NetworkCache::Stats counters;
+
+// Must be called with mutex locked.
+static QNetworkDiskCache * cache()
+{
+    if (!checkedConfig) {
+        checkedConfig=true;
+        qint64 size=Settings::self()->networkCacheSize()*1024*1024;
+        QString dir=0==size ? QString() : Utils::cacheDir(NetworkCache::constCacheDir, true);
+        if (!dir.isEmpty()) {
+            diskCache=new QNetworkDiskCache();
+            diskCache->setCacheDirectory(dir);
+            diskCache->setMaximumCacheSize(size);
+        }
+        DBUG << dir << size;
+    }
+    return diskCache;
+}
+
+bool NetworkCache::isEnabled()
+{
+    QMutexLocker locker(&mutex);
+    return 0!=cache();
+}
+
+bool NetworkCache::isFresh(const QUrl &url)
+{
+    QMutexLocker locker(&mutex);
+    if (!cache()) {
+        return false;
+    }
+    QNetworkCacheMetaData md=diskCache->metaData(url);
+    return md.isValid() && md.expirationDate().isValid() && md.expirationDate()>QDateTime::currentDateTime();
+}
+
+void NetworkCache::record(const QUrl &url, Result r)
+{
+    QMutexLocker locker(&mutex);
+    switch (r) {
+    case Hit:         counters.hits++; break;
+    case Miss:        counters.misses++; break;
+    case Revalidated: counters.revalidations++; break;
+    }
+    DBUG << url.toString() << r << "hits:" << counters.hits << "misses:" << counters.misses << "revalidations:" << counters.revalidations;
+}
+
+NetworkCache::Stats NetworkCache::stats()
+{
+    QMutexLocker locker(&mutex);
+    return counters;
+}
+
+void NetworkCache::clearAll()
+{
+    QMutexLocker locker(&mutex);
+    if (cache()) {
+        diskCache->clear();
+    }
+}
+
+NetworkCache::NetworkCache(QObject *parent)
+    : QAbstractNetworkCache(parent)
+{
+}
+
+NetworkCache::~NetworkCache()
+{
+}
+
+QNetworkCacheMetaData NetworkCache::metaData(const QUrl &url)
+{
+    QMutexLocker locker(&mutex);
+    return cache() ? diskCache->metaData(url) : QNetworkCacheMetaData();
+}
+
+void NetworkCache::updateMetaData(const QNetworkCacheMetaData &metaData)
+{
+    QMutexLocker locker(&mutex);
+    if (cache()) {
+        diskCache->updateMetaData(metaData);
+    }
+}
+
+QIODevice * NetworkCache::data(const QUrl &url)
+{
+    QMutexLocker locker(&mutex);
+    return cache() ? diskCache->data(url) : 0;
+}
+
+bool NetworkCache::remove(const QUrl &url)
+{
+    QMutexLocker locker(&mutex);
+    return cache() ? diskCache->remove(url) : false;
+}
+
+qint64 NetworkCache::cacheSize() const
+{
+    QMutexLocker locker(&mutex);
+    return cache() ? diskCache->cacheSize() : 0;
+}
+
+QIODevice * NetworkCache::prepare(const QNetworkCacheMetaData &metaData)
+{
+    QMutexLocker locker(&mutex);
+    return cache() ? diskCache->prepare(metaData) : 0;
+}
+
+void NetworkCache::insert(QIODevice *device)
+{
+    QMutexLocker locker(&mutex);
+    if (cache()) {
+        diskCache->insert(device);
+    }
+}
+
+void NetworkCache::clear()
+{
+    clearAll();
+}
@@ -0,0 +1,75 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2014 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef NETWORK_CACHE_H
+#define NETWORK_CACHE_H
+
+#include <QAbstractNetworkCache>
+
+// HTTP cache used by all NetworkAccessManager instances. QNetworkAccessManager takes care of
+// Cache-Control, Expires, ETag, and Last-Modified handling (and revalidating stale entries), and
+// this class forwards to a single QNetworkDiskCache - so that the GUI thread, and the covers and
+// online service threads, all share the same on-disk cache.
+class NetworkCache : public QAbstractNetworkCache
+{
+    Q_OBJECT
+
+public:
+    struct Stats {
+        Stats() : hits(0), misses(0), revalidations(0) { }
+        quint64 hits;
+        quint64 misses;
+        quint64 revalidations;
+    };
+
+    enum Result {
+        Hit,
+        Miss,
+        Revalidated
+    };
+
+    static const QLatin1String constCacheDir;
+    static void enableDebug();
+    static bool isEnabled();
+    // Returns true if there is an entry for url that can be used without contacting the server.
+    static bool isFresh(const QUrl &url);
+    static void record(const QUrl &url, Result r);
+    static Stats stats();
+    static void clearAll();
+
+    NetworkCache(QObject *parent);
+    virtual ~NetworkCache();
+
+    QNetworkCacheMetaData metaData(const QUrl &url);
+    void updateMetaData(const QNetworkCacheMetaData &metaData);
+    QIODevice * data(const QUrl &url);
+    bool remove(const QUrl &url);
+    qint64 cacheSize() const;
+    QIODevice * prepare(const QNetworkCacheMetaData &metaData);
+    void insert(QIODevice *device);
+
+public Q_SLOTS:
+    void clear();
+};
+
+#endif
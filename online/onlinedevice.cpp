@@ -52,7 +52,9 @@ void OnlineDevice::copySongTo(const Song &s, const QString &musicPath, bool over
         return;
     }
 
-    job=NetworkAccessManager::self()->get(QUrl(s.file));
+    QNetworkRequest req(QUrl(s.file));
+    NetworkAccessManager::disableCache(req);
+    job=NetworkAccessManager::self()->get(req);
     connect(job, SIGNAL(finished()), SLOT(downloadFinished()));
     connect(job, SIGNAL(downloadProgress(qint64,qint64)), SLOT(downloadProgress(qint64,qint64)));
 }
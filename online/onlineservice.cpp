@@ -34,13 +34,92 @@
 #include "podcastservice.h"
 #include "soundcloudservice.h"
 #include <QFile>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
 #include <QXmlStreamReader>
 
-static QString cacheFileName(OnlineService *srv, bool create=false)
+static const QLatin1String constCacheName("catalog");
+static const QLatin1String constLegacyCacheName("library");
+static const QLatin1String constTempExt(".tmp");
+
+static QString cacheFileName(OnlineService *srv, bool create=false, const QString &name=constCacheName)
 {
-    return Utils::cacheDir(srv->id().toLower(), create)+QLatin1String("library")+MusicLibraryModel::constLibraryCompressedExt;
+    return Utils::cacheDir(srv->id().toLower(), create)+name+MusicLibraryModel::constLibraryCompressedExt;
 }
 
+// Pipe between the network job (in the loader's thread) and the catalog parser (in its own thread).
+// Reads block until either more data has been downloaded, or the download has finished.
+class CatalogStream : public QIODevice
+{
+public:
+    CatalogStream() : finished(false), aborted(false) { }
+    virtual ~CatalogStream() { }
+
+    bool isSequential() const { return true; }
+    qint64 bytesAvailable() const {
+        QMutexLocker locker(&mutex);
+        return buffer.size()+QIODevice::bytesAvailable();
+    }
+
+    void append(const QByteArray &data) {
+        QMutexLocker locker(&mutex);
+        buffer+=data;
+        cond.wakeAll();
+    }
+
+    void finish() {
+        QMutexLocker locker(&mutex);
+        finished=true;
+        cond.wakeAll();
+    }
+
+    void abort() {
+        QMutexLocker locker(&mutex);
+        aborted=true;
+        cond.wakeAll();
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) {
+        QMutexLocker locker(&mutex);
+        while (buffer.isEmpty() && !finished && !aborted) {
+            cond.wait(&mutex);
+        }
+        if (aborted) {
+            return -1;
+        }
+        qint64 size=qMin(maxSize, (qint64)buffer.size());
+        if (size>0) {
+            memcpy(data, buffer.constData(), size);
+            buffer.remove(0, size);
+        }
+        return size;
+    }
+
+    qint64 writeData(const char *, qint64) { return -1; }
+
+private:
+    mutable QMutex mutex;
+    QWaitCondition cond;
+    QByteArray buffer;
+    bool finished;
+    bool aborted;
+};
+
+class CatalogParser : public QThread
+{
+public:
+    CatalogParser(OnlineMusicLoader *l) : loader(l), ok(false) { }
+    virtual ~CatalogParser() { }
+    void run() { ok=loader->parseStream(); }
+    bool succeeded() const { return ok; }
+
+private:
+    OnlineMusicLoader *loader;
+    bool ok;
+};
+
 OnlineMusicLoader::OnlineMusicLoader(const QUrl &src)
     : source(src)
     , library(0)
@@ -48,6 +127,11 @@ OnlineMusicLoader::OnlineMusicLoader(const QUrl &src)
     , downloadJob(0)
     , stopRequested(false)
     , lastProg(-1)
+    , stream(0)
+    , parser(0)
+    , cacheFile(0)
+    , downloadState(Running)
+    , parseState(Running)
 {
     connect(this, SIGNAL(load()), this, SLOT(doLoad()));
     thread=new Thread(metaObject()->className());
@@ -55,6 +139,11 @@ OnlineMusicLoader::OnlineMusicLoader(const QUrl &src)
     thread->start();
 }
 
+OnlineMusicLoader::~OnlineMusicLoader()
+{
+    stopParser();
+}
+
 void OnlineMusicLoader::start()
 {
     stopRequested=false;
@@ -72,15 +161,39 @@ void OnlineMusicLoader::doLoad()
         if (!network) {
             network=new NetworkAccessManager(this);
         }
-        downloadJob=network->get(source);
+
+        // Catalog is parsed, and saved to the cache, as it is downloaded...
+        stopParser();
+        downloadState=parseState=Running;
+        if (!cache.isEmpty()) {
+            cacheFile=new QFile(cache+constTempExt);
+            if (!cacheFile->open(QIODevice::WriteOnly)) {
+                delete cacheFile;
+                cacheFile=0;
+            }
+        }
+        stream=new CatalogStream();
+        stream->open(QIODevice::ReadOnly|QIODevice::Unbuffered);
+        parser=new CatalogParser(this);
+        connect(parser, SIGNAL(finished()), SLOT(parseFinished()));
+
+        QNetworkRequest req(source);
+        // Catalogue is cached by us, once parsed - so dont also store this in the HTTP cache.
+        NetworkAccessManager::disableCache(req);
+        downloadJob=network->get(req);
+        connect(downloadJob, SIGNAL(readyRead()), SLOT(downloadReadyRead()));
         connect(downloadJob, SIGNAL(finished()), SLOT(downloadFinished()));
         connect(downloadJob, SIGNAL(downloadProgress(qint64,qint64)), SLOT(downloadProgress(qint64,qint64)));
+        parser->start();
     }
 }
 
 void OnlineMusicLoader::stop()
 {
     stopRequested=true;
+    if (stream) {
+        stream->abort();
+    }
     thread->stop();
 }
 
@@ -95,18 +208,69 @@ bool OnlineMusicLoader::readFromCache()
 {
     if (!cache.isEmpty() && QFile::exists(cache)) {
         emit status(i18n("Reading cache"), 0);
-        if (library->fromXML(cache, QDateTime(), 0, QString(), this)) {
-            if (!stopRequested) {
+        QFile file(cache);
+        QtIOCompressor comp(&file);
+        comp.setStreamFormat(QtIOCompressor::GzipFormat);
+        if (comp.open(QIODevice::ReadOnly)) {
+            QXmlStreamReader reader(&comp);
+            bool ok=parse(reader);
+            if (stopRequested) {
+                return true;
+            }
+            if (ok && library && !library->childItems().isEmpty()) {
                 fixLibrary();
                 emit status(i18n("Updating display"), -100);
                 emit loaded();
+                return true;
             }
-            return true;
         }
+        // Cache is corrupt, so download again...
+        delete library;
+        library=new OnlineServiceMusicRoot;
     }
     return false;
 }
 
+// Called from parser thread!
+bool OnlineMusicLoader::parseStream()
+{
+    QtIOCompressor comp(stream);
+    comp.setStreamFormat(QtIOCompressor::GzipFormat);
+    if (!comp.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QXmlStreamReader reader;
+    reader.setDevice(&comp);
+    if (!parse(reader) || !library) {
+        return false;
+    }
+    fixLibrary();
+    return true;
+}
+
+void OnlineMusicLoader::stopParser()
+{
+    if (stream) {
+        stream->abort();
+    }
+    if (parser) {
+        disconnect(parser, SIGNAL(finished()), this, SLOT(parseFinished()));
+        parser->wait();
+        delete parser;
+        parser=0;
+    }
+    if (stream) {
+        delete stream;
+        stream=0;
+    }
+    if (cacheFile) {
+        cacheFile->remove();
+        delete cacheFile;
+        cacheFile=0;
+    }
+}
+
 void OnlineMusicLoader::fixLibrary()
 {
     emit status(i18n("Grouping tracks"), -100);
@@ -115,6 +279,25 @@ void OnlineMusicLoader::fixLibrary()
     }
 }
 
+void OnlineMusicLoader::downloadReadyRead()
+{
+    NetworkJob *reply=qobject_cast<NetworkJob *>(sender());
+    if (!reply || reply!=downloadJob) {
+        return;
+    }
+
+    QByteArray data=reply->readAll();
+    if (data.isEmpty()) {
+        return;
+    }
+    if (cacheFile) {
+        cacheFile->write(data);
+    }
+    if (stream) {
+        stream->append(data);
+    }
+}
+
 void OnlineMusicLoader::downloadFinished()
 {
     NetworkJob *reply=qobject_cast<NetworkJob *>(sender());
@@ -123,32 +306,64 @@ void OnlineMusicLoader::downloadFinished()
     }
 
     reply->deleteLater();
+    if (reply!=downloadJob) {
+        return;
+    }
+    downloadJob=0;
 
     if (stopRequested) {
         return;
     }
 
     if (reply->ok()) {
+        downloadState=Succeeded;
         emit status(i18n("Parsing response"), -100);
-        QtIOCompressor comp(reply->actualJob());
-        comp.setStreamFormat(QtIOCompressor::GzipFormat);
-        if (comp.open(QIODevice::ReadOnly)) {
-            QXmlStreamReader reader;
-            reader.setDevice(&comp);
-            if (parse(reader)) {
-                fixLibrary();
-                emit status(i18n("Saving cache"), 0);
-                library->toXML(cache, QDateTime(), false, this);
-                emit loaded();
-            } else {
-                emit error(i18n("Failed to parse"));
-            }
-        } else {
-            emit error(i18n("Failed to parse"));
+        if (stream) {
+            stream->finish();
         }
     } else {
+        downloadState=Failed;
+        if (stream) {
+            stream->abort();
+        }
+    }
+    checkFinished();
+}
+
+void OnlineMusicLoader::parseFinished()
+{
+    CatalogParser *p=static_cast<CatalogParser *>(sender());
+    if (!p || p!=parser) {
+        return;
+    }
+    parseState=p->succeeded() ? Succeeded : Failed;
+    checkFinished();
+}
+
+void OnlineMusicLoader::checkFinished()
+{
+    if (stopRequested || Running==downloadState || Running==parseState) {
+        return;
+    }
+
+    if (Failed==downloadState) {
         emit error(i18n("Failed to download"));
+    } else if (Failed==parseState) {
+        emit error(i18n("Failed to parse"));
+    } else {
+        // Catalog was written to the cache as it was downloaded, so just need to move into place.
+        if (cacheFile) {
+            cacheFile->close();
+            QFile::remove(cache);
+            if (!QFile::rename(cacheFile->fileName(), cache)) {
+                cacheFile->remove();
+            }
+            delete cacheFile;
+            cacheFile=0;
+        }
+        emit loaded();
     }
+    stopParser();
 }
 
 void OnlineMusicLoader::downloadProgress(qint64 bytesReceived, qint64 bytesTotal)
@@ -274,6 +489,11 @@ void OnlineService::reload(const bool fromCache)
     if (!fromCache && QFile::exists(cache)) {
         QFile::remove(cache);
     }
+    // Cache used to be a serialised copy of the library, now we store the downloaded catalog
+    QString legacyCache=cacheFileName(this, false, constLegacyCacheName);
+    if (QFile::exists(legacyCache)) {
+        QFile::remove(legacyCache);
+    }
     createLoader();
     if (!loader) {
         return;
@@ -315,6 +535,10 @@ void OnlineService::removeCache()
     if (QFile::exists(cn)) {
         QFile::remove(cn);
     }
+    cn=cacheFileName(this, false, constLegacyCacheName);
+    if (QFile::exists(cn)) {
+        QFile::remove(cn);
+    }
 }
 
 void OnlineService::applyUpdate()
@@ -36,6 +36,9 @@ class NetworkAccessManager;
 class MusicModel;
 class NetworkJob;
 class QXmlStreamReader;
+class QFile;
+class QThread;
+class CatalogStream;
 
 class OnlineServiceMusicRoot : public MusicLibraryItemRoot
 {
@@ -51,6 +54,7 @@ class OnlineMusicLoader : public QObject, public MusicLibraryProgressMonitor
 
 public:
     OnlineMusicLoader(const QUrl &src);
+    virtual ~OnlineMusicLoader();
 
     void start();
     void stop();
@@ -70,11 +74,16 @@ Q_SIGNALS:
 
 private Q_SLOTS:
     void doLoad();
+    void downloadReadyRead();
     void downloadFinished();
     void downloadProgress(qint64 bytesReceived, qint64 bytesTotal);
+    void parseFinished();
 
 private:
     bool readFromCache();
+    bool parseStream();
+    void stopParser();
+    void checkFinished();
     void fixLibrary();
     void readProgress(double pc);
     void writeProgress(double pc);
@@ -89,6 +98,21 @@ protected:
     NetworkJob *downloadJob;
     bool stopRequested;
     int lastProg;
+
+private:
+    enum LoadState {
+        Running,
+        Succeeded,
+        Failed
+    };
+
+    CatalogStream *stream;
+    QThread *parser;
+    QFile *cacheFile;
+    LoadState downloadState;
+    LoadState parseState;
+
+    friend class CatalogParser;
 };
 
 // MOC requires the QObject class to be first. But due to models storing void pointers, and
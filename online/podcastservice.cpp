@@ -34,6 +34,8 @@
 #include <QCoreApplication>
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
+#include <QHash>
 #include <QSet>
 #include <QTimer>
 #if QT_VERSION >= 0x050000
@@ -47,7 +49,13 @@ QString PodcastService::iconFile;
 static const char * constNewFeedProperty="new-feed";
 static const char * constRssUrlProperty="rss-url";
 static const char * constDestProperty="dest";
+static const char * constOffsetProperty="offset";
+// Offset asked for in the range request. Unlike constOffsetProperty, this is not reset if the server sends the whole file.
+static const char * constRequestedOffsetProperty="requested-offset";
 static const QLatin1String constPartialExt(".partial");
+// Partial downloads are kept so that they may be resumed, but remove any that have not been touched for this many days...
+static const int constMaxPartialAge=14;
+static const int constMaxRssJobs=4;
 
 bool PodcastService::isPodcastFile(const QString &file)
 {
@@ -102,9 +110,9 @@ QUrl PodcastService::fixUrl(const QUrl &orig)
 
 PodcastService::PodcastService(MusicModel *m)
     : OnlineService(m, i18n("Podcasts"))
-    , downloadJob(0)
     , rssUpdateTimer(0)
 {
+    maxDownloads=Settings::self()->maxPodcastDownloads();
     loaded=true;
     QMetaObject::invokeMethod(this, "loadAll", Qt::QueuedConnection);
     connect(MPDConnection::self(), SIGNAL(currentSongUpdated(const Song &)), this, SLOT(currentMpdSong(const Song &)));
@@ -177,8 +185,9 @@ void PodcastService::cancelAll()
         j->cancelAndDelete();
     }
     rssJobs.clear();
+    rssQueue.clear();
     cancelAllDownloads();
-    setBusy(!rssJobs.isEmpty() || 0!=downloadJob);
+    setBusy(!rssJobs.isEmpty() || !downloadJobs.isEmpty());
 }
 
 void PodcastService::rssJobFinished()
@@ -191,109 +200,146 @@ void PodcastService::rssJobFinished()
     j->deleteLater();
     rssJobs.removeAll(j);
     bool isNew=j->property(constNewFeedProperty).toBool();
-
-    if (j->ok()) {
-        if (updateUrls.contains(j->origUrl())){
-            updateUrls.remove(j->origUrl());
-            if (updateUrls.isEmpty()) {
-                lastRssUpdate=QDateTime::currentDateTime();
-                Settings::self()->saveLastRssUpdate(lastRssUpdate);
-                startRssUpdateTimer();
+    int status=j->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+    if (304==status) {
+        // Feed has not been modified since we last fetched it - nothing to do!
+        rssUpdated(j->origUrl());
+    } else if (j->ok()) {
+        rssUpdated(j->origUrl());
+
+        QByteArray data=j->readAll();
+        QString etag=QString::fromLatin1(j->actualJob()->rawHeader("ETag"));
+        QString lastModified=QString::fromLatin1(j->actualJob()->rawHeader("Last-Modified"));
+        QString hash=MusicLibraryItemPodcast::rssHash(data);
+        MusicLibraryItemPodcast *orig=isNew ? 0 : getPodcast(j->origUrl());
+
+        if (!isNew && !orig) {
+            // Unsubscribed whilst refreshing...
+        } else if (orig && orig->contentHash()==hash) {
+            // Server does not support ETag, or Last-Modified, but content is the same - so no need to parse
+            if (orig->setRssValidators(etag, lastModified, hash)) {
+                orig->save();
             }
-        }
-
-        MusicLibraryItemPodcast *podcast=new MusicLibraryItemPodcast(QString(), this);
-        MusicLibraryItemPodcast::RssStatus loadStatus=podcast->loadRss(j->actualJob());
-        if (MusicLibraryItemPodcast::Loaded==loadStatus) {
-            int autoDownload=Settings::self()->podcastAutoDownloadLimit();
-
-            if (isNew) {
-                podcast->save();
-                beginInsertRows(index(), childCount(), childCount());
-                m_childItems.append(podcast);
-                if (autoDownload) {
-                    int ep=0;
-                    foreach (MusicLibraryItem *i, podcast->childItems()) {
-                        MusicLibraryItemSong *song=static_cast<MusicLibraryItemSong *>(i);
-                        downloadEpisode(podcast, QUrl(song->file()));
-                        if (autoDownload<1000 && ++ep>=autoDownload) {
-                            break;
+        } else {
+            MusicLibraryItemPodcast *podcast=new MusicLibraryItemPodcast(QString(), this);
+            MusicLibraryItemPodcast::RssStatus loadStatus=podcast->loadRss(j->url(), data);
+            if (MusicLibraryItemPodcast::Loaded==loadStatus) {
+                if (isNew) {
+                    int autoDownload=Settings::self()->podcastAutoDownloadLimit();
+                    podcast->setRssValidators(etag, lastModified, hash);
+                    podcast->save();
+                    beginInsertRows(index(), childCount(), childCount());
+                    m_childItems.append(podcast);
+                    if (autoDownload) {
+                        int ep=0;
+                        foreach (MusicLibraryItem *i, podcast->childItems()) {
+                            MusicLibraryItemSong *song=static_cast<MusicLibraryItemSong *>(i);
+                            downloadEpisode(podcast, QUrl(song->file()));
+                            if (autoDownload<1000 && ++ep>=autoDownload) {
+                                break;
+                            }
                         }
                     }
-                }
-                endInsertRows();
-//                emitNeedToSort();
-            } else {
-                MusicLibraryItemPodcast *orig = getPodcast(j->origUrl());
-                if (!orig) {
+                    endInsertRows();
+//                    emitNeedToSort();
+                } else {
+                    bool modified=orig->setRssValidators(etag, lastModified, hash);
+                    if (updatePodcast(orig, podcast) || modified) {
+                        orig->save();
+                    }
                     delete podcast;
-                    return;
                 }
-                QSet<QString> origSongs;
-                QSet<QString> newSongs;
-                foreach (MusicLibraryItem *i, orig->childItems()) {
-                    MusicLibraryItemPodcastEpisode *episode=static_cast<MusicLibraryItemPodcastEpisode *>(i);
-                    origSongs.insert(episode->file());
-                }
-                foreach (MusicLibraryItem *i, podcast->childItems()) {
-                    MusicLibraryItemSong *song=static_cast<MusicLibraryItemSong *>(i);
-                    newSongs.insert(song->file());
+            } else {
+                delete podcast;
+                if (isNew) {
+                    if (MusicLibraryItemPodcast::VideoPodcast==loadStatus) {
+                        emitError(i18n("Cantata only supports audio podcasts! %1 contains only video podcasts.", j->origUrl().toString()), isNew);
+                    } else {
+                        emitError(i18n("Failed to parse %1", j->origUrl().toString()), isNew);
+                    }
                 }
+            }
+        }
+    } else {
+        emitError(i18n("Failed to download %1", j->origUrl().toString()), isNew);
+    }
+    doNextRssJob();
+    setBusy(!rssJobs.isEmpty() || !downloadJobs.isEmpty());
+}
 
-                QSet<QString> added=newSongs-origSongs;
-                QSet<QString> removed=origSongs-newSongs;
-                if (added.count() || removed.count()) {
-                    QModelIndex origIndex=createIndex(orig);
-                    if (removed.count()) {
-                        foreach (const QString &s, removed) {
-                            MusicLibraryItemPodcastEpisode *episode=orig->getEpisode(s);
-                            if (episode->localPath().isEmpty() || !QFile::exists(episode->localPath())) {
-                                int idx=orig->indexOf(episode);
-                                if (-1!=idx) {
-                                    beginRemoveRows(origIndex, idx, idx);
-                                    orig->remove(idx);
-                                    endRemoveRows();
-                                }
-                            }
-                        }
-                    }
-                    if (added.count()) {
-                        QList<MusicLibraryItemPodcastEpisode *> newSongs;
-                        foreach (const QString &s, added) {
-                            MusicLibraryItemPodcastEpisode *episode=podcast->getEpisode(s);
-                            if (episode) {
-                                newSongs.append(episode);
-                                if (autoDownload) {
-                                    downloadEpisode(orig, QUrl(episode->file()));
-                                }
-                            }
-                        }
+void PodcastService::rssUpdated(const QUrl &url)
+{
+    if (updateUrls.contains(url)){
+        updateUrls.remove(url);
+        if (updateUrls.isEmpty()) {
+            lastRssUpdate=QDateTime::currentDateTime();
+            Settings::self()->saveLastRssUpdate(lastRssUpdate);
+            startRssUpdateTimer();
+        }
+    }
+}
 
-                        beginInsertRows(origIndex, orig->childCount(), (orig->childCount()+newSongs.count())-1);
-                        orig->addAll(newSongs);
-                        endInsertRows();
-                    }
+bool PodcastService::updatePodcast(MusicLibraryItemPodcast *orig, MusicLibraryItemPodcast *podcast)
+{
+    QHash<QString, MusicLibraryItemPodcastEpisode *> origSongs;
+    QHash<QString, MusicLibraryItemPodcastEpisode *> newSongs;
+    foreach (MusicLibraryItem *i, orig->childItems()) {
+        MusicLibraryItemPodcastEpisode *episode=static_cast<MusicLibraryItemPodcastEpisode *>(i);
+        origSongs.insert(episode->file(), episode);
+    }
+    foreach (MusicLibraryItem *i, podcast->childItems()) {
+        MusicLibraryItemPodcastEpisode *episode=static_cast<MusicLibraryItemPodcastEpisode *>(i);
+        newSongs.insert(episode->file(), episode);
+    }
 
-                    orig->setUnplayedCount();
-                    orig->save();
-//                    emitNeedToSort();
-                }
+    QList<MusicLibraryItemPodcastEpisode *> removed;
+    QList<MusicLibraryItemPodcastEpisode *> added;
+    QHash<QString, MusicLibraryItemPodcastEpisode *>::ConstIterator it=origSongs.constBegin();
+    QHash<QString, MusicLibraryItemPodcastEpisode *>::ConstIterator end=origSongs.constEnd();
+    for (; it!=end; ++it) {
+        if (!newSongs.contains(it.key())) {
+            removed.append(it.value());
+        }
+    }
+    // Iterate new podcast's list, so that episode order is preserved
+    foreach (MusicLibraryItem *i, podcast->childItems()) {
+        MusicLibraryItemPodcastEpisode *episode=static_cast<MusicLibraryItemPodcastEpisode *>(i);
+        if (!origSongs.contains(episode->file())) {
+            added.append(episode);
+        }
+    }
 
-                delete podcast;
+    if (removed.isEmpty() && added.isEmpty()) {
+        return false;
+    }
+
+    QModelIndex origIndex=createIndex(orig);
+    foreach (MusicLibraryItemPodcastEpisode *episode, removed) {
+        if (episode->localPath().isEmpty() || !QFile::exists(episode->localPath())) {
+            int idx=orig->indexOf(episode);
+            if (-1!=idx) {
+                beginRemoveRows(origIndex, idx, idx);
+                orig->remove(idx);
+                endRemoveRows();
             }
+        }
+    }
+    if (!added.isEmpty()) {
+        beginInsertRows(origIndex, orig->childCount(), (orig->childCount()+added.count())-1);
+        orig->addAll(added);
+        endInsertRows();
 
-        } else if (isNew) {
-            delete podcast;
-            if (MusicLibraryItemPodcast::VideoPodcast==loadStatus) {
-                emitError(i18n("Cantata only supports audio podcasts! %1 contains only video podcasts.", j->origUrl().toString()), isNew);
-            } else {
-                emitError(i18n("Failed to parse %1", j->origUrl().toString()), isNew);
+        if (Settings::self()->podcastAutoDownloadLimit()) {
+            foreach (MusicLibraryItemPodcastEpisode *episode, added) {
+                downloadEpisode(orig, QUrl(episode->file()));
             }
         }
-    } else {
-        emitError(i18n("Failed to download %1", j->origUrl().toString()), isNew);
     }
-    setBusy(!rssJobs.isEmpty() || 0!=downloadJob);
+
+    orig->setUnplayedCount();
+//    emitNeedToSort();
+    return true;
 }
 
 void PodcastService::configure(QWidget *p)
@@ -371,24 +417,58 @@ bool PodcastService::processingUrl(const QUrl &url) const
             return true;
         }
     }
-    return false;
+    return rssQueue.contains(url);
 }
 
 void PodcastService::addUrl(const QUrl &url, bool isNew)
 {
     setBusy(true);
-    NetworkJob *job=NetworkAccessManager::self()->get(url);
+    // Refreshes are queued, so that we don't hammer the network when there are many subscriptions.
+    // New subscriptions are user initiated, so start these immediately.
+    if (!isNew && rssJobs.count()>=constMaxRssJobs) {
+        if (!rssQueue.contains(url)) {
+            rssQueue.append(url);
+        }
+        return;
+    }
+
+    QNetworkRequest req(url);
+    MusicLibraryItemPodcast *podcast=isNew ? 0 : getPodcast(url);
+    if (podcast) {
+        // Only fetch if the feed has changed since we last fetched it
+        if (!podcast->etag().isEmpty()) {
+            req.setRawHeader("If-None-Match", podcast->etag().toLatin1());
+        }
+        if (!podcast->lastModified().isEmpty()) {
+            req.setRawHeader("If-Modified-Since", podcast->lastModified().toLatin1());
+        }
+    }
+    NetworkJob *job=NetworkAccessManager::self()->get(req);
     connect(job, SIGNAL(finished()), this, SLOT(rssJobFinished()));
     job->setProperty(constNewFeedProperty, isNew);
     rssJobs.append(job);
 }
 
-bool PodcastService::downloadingEpisode(const QUrl &url) const
+void PodcastService::doNextRssJob()
+{
+    while (rssJobs.count()<constMaxRssJobs && !rssQueue.isEmpty()) {
+        addUrl(rssQueue.takeFirst(), false);
+    }
+}
+
+NetworkJob * PodcastService::downloadJobFor(const QUrl &url) const
 {
-    if (downloadJob && downloadJob->origUrl()==url) {
-        return true;
+    foreach (NetworkJob *j, downloadJobs) {
+        if (j->origUrl()==url) {
+            return j;
+        }
     }
-    return toDownload.contains(url);
+    return 0;
+}
+
+bool PodcastService::downloadingEpisode(const QUrl &url) const
+{
+    return 0!=downloadJobFor(url) || toDownload.contains(url);
 }
 
 void PodcastService::cancelAllDownloads()
@@ -398,8 +478,11 @@ void PodcastService::cancelAllDownloads()
     }
 
     toDownload.clear();
-    cancelDownload();
-    setBusy(!rssJobs.isEmpty() || 0!=downloadJob);
+    // Keep the partial files, so that these downloads may be resumed later...
+    foreach (NetworkJob *j, downloadJobs) {
+        cancelDownload(j, false);
+    }
+    setBusy(!rssJobs.isEmpty() || !downloadJobs.isEmpty());
 }
 
 void PodcastService::downloadPodcasts(MusicLibraryItemPodcast *pod, const QList<MusicLibraryItemPodcastEpisode *> &episodes)
@@ -481,72 +564,80 @@ void PodcastService::downloadEpisode(const MusicLibraryItemPodcast *podcast, con
 
 void PodcastService::cancelDownloads(const QList<MusicLibraryItemPodcastEpisode *> episodes)
 {
-    bool cancelDl=false;
+    bool cancelledDl=false;
     foreach (MusicLibraryItemPodcastEpisode *e, episodes) {
         QUrl u(e->file());
         toDownload.removeAll(u);
         e->setDownloadProgress(MusicLibraryItemPodcastEpisode::NotDownloading);
         emitDataChanged(createIndex(e));
-        if (!cancelDl && downloadJob && downloadJob->url()==u) {
-            cancelDl=true;
+        NetworkJob *job=downloadJobFor(u);
+        if (job) {
+            cancelDownload(job, true);
+            cancelledDl=true;
         }
     }
-    if (cancelDl) {
-        cancelDownload();
+    if (cancelledDl) {
+        doNextDownload();
     }
 }
 
 void PodcastService::cancelDownload(const QUrl &url)
 {
-    if (downloadJob && downloadJob->origUrl()==url) {
-        cancelDownload();
+    NetworkJob *job=downloadJobFor(url);
+    if (job) {
+        cancelDownload(job, true);
         doNextDownload();
     }
 }
 
-void PodcastService::cancelDownload()
+void PodcastService::cancelDownload(NetworkJob *job, bool removePartial)
 {
-    if (downloadJob) {
-        downloadJob->cancelAndDelete();
-        disconnect(downloadJob, SIGNAL(finished()), this, SLOT(downloadJobFinished()));
-        disconnect(downloadJob, SIGNAL(readyRead()), this, SLOT(downloadReadyRead()));
-        disconnect(downloadJob, SIGNAL(downloadPercent(int)), this, SLOT(downloadPercent(int)));
+    if (!job || !downloadJobs.contains(job)) {
+        return;
+    }
+
+    downloadJobs.removeAll(job);
+    job->cancelAndDelete();
+    disconnect(job, SIGNAL(finished()), this, SLOT(downloadJobFinished()));
+    disconnect(job, SIGNAL(readyRead()), this, SLOT(downloadReadyRead()));
+    disconnect(job, SIGNAL(downloadProgress(qint64, qint64)), this, SLOT(downloadProgress(qint64, qint64)));
 
-        QString dest=downloadJob->property(constDestProperty).toString();
+    if (removePartial) {
+        QString dest=job->property(constDestProperty).toString();
         QString partial=dest.isEmpty() ? QString() : QString(dest+constPartialExt);
         if (!partial.isEmpty() && QFile::exists(partial)) {
             QFile::remove(partial);
         }
-        updateEpisode(downloadJob->property(constRssUrlProperty).toUrl(), downloadJob->origUrl(), MusicLibraryItemPodcastEpisode::NotDownloading);
-        downloadJob=0;
     }
-    setBusy(!rssJobs.isEmpty() || 0!=downloadJob);
+    updateEpisode(job->property(constRssUrlProperty).toUrl(), job->origUrl(), MusicLibraryItemPodcastEpisode::NotDownloading);
+    setBusy(!rssJobs.isEmpty() || !downloadJobs.isEmpty());
 }
 
 void PodcastService::doNextDownload()
 {
-    if (downloadJob) {
-        return;
-    }
-
-    if (toDownload.isEmpty()) {
-        setBusy(!rssJobs.isEmpty());
-        return;
+    while (downloadJobs.count()<maxDownloads && !toDownload.isEmpty()) {
+        DownloadEntry entry=toDownload.takeFirst();
+        QNetworkRequest req(entry.url);
+        // If we have a partial download of this episode, then ask the server for just the remainder.
+        QFileInfo partial(entry.dest+constPartialExt);
+        qint64 offset=partial.exists() ? partial.size() : 0;
+        if (offset>0) {
+            req.setRawHeader("Range", "bytes="+QByteArray::number(offset)+"-");
+        }
+        NetworkAccessManager::disableCache(req);
+        NetworkJob *job=NetworkAccessManager::self()->get(req);
+        connect(job, SIGNAL(finished()), this, SLOT(downloadJobFinished()));
+        connect(job, SIGNAL(readyRead()), this, SLOT(downloadReadyRead()));
+        connect(job, SIGNAL(downloadProgress(qint64, qint64)), this, SLOT(downloadProgress(qint64, qint64)));
+        job->setProperty(constRssUrlProperty, entry.rssUrl);
+        job->setProperty(constDestProperty, entry.dest);
+        job->setProperty(constOffsetProperty, offset);
+        job->setProperty(constRequestedOffsetProperty, offset);
+        downloadJobs.append(job);
+        updateEpisode(entry.rssUrl, entry.url, 0);
     }
 
-    DownloadEntry entry=toDownload.takeFirst();
-    downloadJob=NetworkAccessManager::self()->get(entry.url);
-    connect(downloadJob, SIGNAL(finished()), this, SLOT(downloadJobFinished()));
-    connect(downloadJob, SIGNAL(readyRead()), this, SLOT(downloadReadyRead()));
-    connect(downloadJob, SIGNAL(downloadPercent(int)), this, SLOT(downloadPercent(int)));
-    downloadJob->setProperty(constRssUrlProperty, entry.rssUrl);
-    downloadJob->setProperty(constDestProperty, entry.dest);
-    updateEpisode(entry.rssUrl, entry.url, 0);
-
-    QString partial=entry.dest+constPartialExt;
-    if (QFile::exists(partial)) {
-        QFile::remove(partial);
-    }
+    setBusy(!rssJobs.isEmpty() || !downloadJobs.isEmpty());
 }
 
 void PodcastService::updateEpisode(const QUrl &rssUrl, const QUrl &url, int pc)
@@ -569,27 +660,63 @@ void PodcastService::clearPartialDownloads()
     }
 
     dest=Utils::fixPath(dest);
+    QDateTime oldest=QDateTime::currentDateTime().addDays(-constMaxPartialAge);
     QStringList sub=QDir(dest).entryList(QDir::Dirs|QDir::NoDotAndDotDot);
     foreach (const QString &d, sub) {
-        QStringList partials=QDir(dest+d).entryList(QStringList() << QLatin1Char('*')+constPartialExt, QDir::Files);
-        foreach (const QString &p, partials) {
-            QFile::remove(dest+d+Utils::constDirSep+p);
+        QFileInfoList partials=QDir(dest+d).entryInfoList(QStringList() << QLatin1Char('*')+constPartialExt, QDir::Files);
+        foreach (const QFileInfo &p, partials) {
+            if (p.lastModified()<oldest) {
+                QFile::remove(p.absoluteFilePath());
+            }
         }
     }
 }
 
+// Returns the complete length given in a "Content-Range: bytes */N" (or "bytes a-b/N") header, or -1 if unknown.
+static qint64 totalFromContentRange(const QByteArray &range)
+{
+    int slash=range.indexOf('/');
+    if (!range.startsWith("bytes ") || slash<0) {
+        return -1;
+    }
+    bool ok=false;
+    qint64 total=range.mid(slash+1).trimmed().toLongLong(&ok);
+    return ok ? total : -1;
+}
+
 void PodcastService::downloadJobFinished()
 {
     NetworkJob *job=dynamic_cast<NetworkJob *>(sender());
-    if (!job || job!=downloadJob) {
+    if (!job || !downloadJobs.contains(job)) {
         return;
     }
     job->deleteLater();
+    downloadJobs.removeAll(job);
 
     QString dest=job->property(constDestProperty).toString();
     QString partial=dest.isEmpty() ? QString() : QString(dest+constPartialExt);
 
-    if (job->ok()) {
+    int status=job->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    bool complete=job->ok();
+    if (416==status && job->property(constRequestedOffsetProperty).toLongLong()>0) {
+        qint64 total=totalFromContentRange(job->rawHeader("Content-Range"));
+        if (total>0 && !partial.isEmpty() && QFileInfo(partial).size()==total) {
+            // Partial file already contains the whole episode (e.g. Cantata exited before it was
+            // renamed), so there was nothing left to request.
+            complete=true;
+        } else {
+            // Server did not like our range request - so remove partial file, and download from the start.
+            if (!partial.isEmpty() && QFile::exists(partial)) {
+                QFile::remove(partial);
+            }
+            toDownload.prepend(DownloadEntry(job->origUrl(), job->property(constRssUrlProperty).toUrl(), dest));
+            updateEpisode(job->property(constRssUrlProperty).toUrl(), job->origUrl(), MusicLibraryItemPodcastEpisode::QueuedForDownload);
+            doNextDownload();
+            return;
+        }
+    }
+
+    if (complete) {
         QString dest=job->property(constDestProperty).toString();
         if (dest.isEmpty()) {
             return;
@@ -612,23 +739,37 @@ void PodcastService::downloadJobFinished()
                 }
             }
         }
-    } else if (!partial.isEmpty() && QFile::exists(partial)) {
+    }
+    // Failed downloads leave their partial file in place, so that a later attempt can resume from there. Error
+    // replies are never written to the partial file, but make sure one does not remain from a fresh download.
+    if (!job->ok() && 200!=status && 206!=status && 0==job->property(constRequestedOffsetProperty).toLongLong() &&
+        !partial.isEmpty() && QFile::exists(partial)) {
         QFile::remove(partial);
     }
     updateEpisode(job->property(constRssUrlProperty).toUrl(), job->origUrl(), MusicLibraryItemPodcastEpisode::NotDownloading);
-    downloadJob=0;
     doNextDownload();
 }
 
 void PodcastService::downloadReadyRead()
 {
     NetworkJob *job=dynamic_cast<NetworkJob *>(sender());
-    if (!job || job!=downloadJob) {
+    if (!job || !downloadJobs.contains(job)) {
         return;
     }
     QString dest=job->property(constDestProperty).toString();
     QString partial=dest.isEmpty() ? QString() : QString(dest+constPartialExt);
+    int status=job->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (200!=status && 206!=status) {
+        // Do not save error pages (or redirect bodies) as part of the episode.
+        job->readAll();
+        return;
+    }
     if (!partial.isEmpty()) {
+        if (job->property(constOffsetProperty).toLongLong()>0 && 200==status) {
+            // Server ignored our range request, and is sending the whole file - so start again...
+            job->setProperty(constOffsetProperty, 0);
+            QFile::remove(partial);
+        }
         QString dir=Utils::getDir(partial);
         if (!QDir(dir).exists()) {
             QDir(dir).mkpath(dir);
@@ -652,13 +793,16 @@ void PodcastService::downloadReadyRead()
     }
 }
 
-void PodcastService::downloadPercent(int pc)
+void PodcastService::downloadProgress(qint64 bytesReceived, qint64 bytesTotal)
 {
     NetworkJob *job=dynamic_cast<NetworkJob *>(sender());
-    if (!job || job!=downloadJob) {
+    if (!job || !downloadJobs.contains(job) || bytesTotal<=0) {
         return;
     }
-    updateEpisode(job->property(constRssUrlProperty).toUrl(), job->origUrl(), pc);
+    // When resuming, the reply only covers the remainder of the file - so add on what we already had.
+    qint64 offset=job->property(constOffsetProperty).toLongLong();
+    int pc=(((bytesReceived+offset)*100.0)/(bytesTotal+offset))+0.5;
+    updateEpisode(job->property(constRssUrlProperty).toUrl(), job->origUrl(), qMax(0, qMin(pc, 100)));
 }
 
 void PodcastService::startRssUpdateTimer()
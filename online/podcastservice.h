@@ -68,7 +68,7 @@ public:
     static QUrl fixUrl(const QUrl &orig);
     static bool isUrlOk(const QUrl &u) { return QLatin1String("http")==u.scheme() || QLatin1String("https")==u.scheme(); }
 
-    bool isDownloading() const { return 0!=downloadJob; }
+    bool isDownloading() const { return !downloadJobs.isEmpty(); }
     void cancelAllDownloads();
     void downloadPodcasts(MusicLibraryItemPodcast *pod, const QList<MusicLibraryItemPodcastEpisode *> &episodes);
     void deleteDownloadedPodcasts(MusicLibraryItemPodcast *pod, const QList<MusicLibraryItemPodcastEpisode *> &episodes);
@@ -80,13 +80,17 @@ public:
 private:
     void cancelAll();
     MusicLibraryItemPodcastEpisode * getEpisode(const MusicLibraryItemPodcast *podcast, const QUrl &episode);
+    void rssUpdated(const QUrl &url);
+    bool updatePodcast(MusicLibraryItemPodcast *orig, MusicLibraryItemPodcast *podcast);
+    void doNextRssJob();
     void startRssUpdateTimer();
     void stopRssUpdateTimer();
+    NetworkJob * downloadJobFor(const QUrl &url) const;
     bool downloadingEpisode(const QUrl &url) const;
     void downloadEpisode(const MusicLibraryItemPodcast *podcast, const QUrl &episode);
     void cancelDownloads(const QList<MusicLibraryItemPodcastEpisode *> episodes);
     void cancelDownload(const QUrl &url);
-    void cancelDownload();
+    void cancelDownload(NetworkJob *job, bool removePartial);
     void doNextDownload();
     void updateEpisode(const QUrl &rssUrl, const QUrl &url, int pc);
     void clearPartialDownloads();
@@ -98,7 +102,7 @@ private Q_SLOTS:
     void currentMpdSong(const Song &s);
     void downloadJobFinished();
     void downloadReadyRead();
-    void downloadPercent(int pc);
+    void downloadProgress(qint64 bytesReceived, qint64 bytesTotal);
 
 private:
     struct DownloadEntry {
@@ -111,7 +115,9 @@ private:
     };
 
     QList<NetworkJob *> rssJobs;
-    NetworkJob * downloadJob;
+    QList<QUrl> rssQueue;
+    QList<NetworkJob *> downloadJobs;
+    int maxDownloads;
     QList<DownloadEntry> toDownload;
     QTimer *rssUpdateTimer;
     QDateTime lastRssUpdate;
@@ -0,0 +1,306 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2014 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#include "scrobblejournal.h"
+#include <QFile>
+#include <QTimer>
+#include <QUrl>
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <QDebug>
+static bool debugIsEnabled=false;
+#define DBUG if (debugIsEnabled) qWarning() << metaObject()->className() << __FUNCTION__
+void ScrobbleJournal::enableDebug()
+{
+    debugIsEnabled=true;
+}
+
+const QLatin1String ScrobbleJournal::constExtension(".journal");
+static const QLatin1String constTempExt(".tmp");
+static const char constVersionRecord[]="#1\n";
+static const char constQueuedRecord='+';
+static const char constAcknowledgedRecord='-';
+static const char constSeparator='\t';
+static const int constFlushInterval=2000; // ms
+static const int constMaxBufferedRecords=32;
+static const int constCompactThreshold=256;
+
+static QByteArray encode(const Scrobbler::Track &t)
+{
+    return constQueuedRecord+QByteArray::number(t.id)+constSeparator+
+           QByteArray::number((qulonglong)t.timestamp)+constSeparator+
+           QByteArray::number(t.length)+constSeparator+
+           QByteArray::number(t.track)+constSeparator+
+           QUrl::toPercentEncoding(t.artist)+constSeparator+
+           QUrl::toPercentEncoding(t.albumartist)+constSeparator+
+           QUrl::toPercentEncoding(t.album)+constSeparator+
+           QUrl::toPercentEncoding(t.title)+'\n';
+}
+
+static bool decode(const QByteArray &record, Scrobbler::Track &t)
+{
+    QList<QByteArray> parts=record.trimmed().mid(1).split(constSeparator);
+    if (8!=parts.count()) {
+        return false;
+    }
+    t.id=parts.at(0).toULongLong();
+    t.timestamp=(time_t)parts.at(1).toULongLong();
+    t.length=parts.at(2).toUInt();
+    t.track=parts.at(3).toUInt();
+    t.artist=QString::fromUtf8(QByteArray::fromPercentEncoding(parts.at(4)));
+    t.albumartist=QString::fromUtf8(QByteArray::fromPercentEncoding(parts.at(5)));
+    t.album=QString::fromUtf8(QByteArray::fromPercentEncoding(parts.at(6)));
+    t.title=QString::fromUtf8(QByteArray::fromPercentEncoding(parts.at(7)));
+    return 0!=t.id;
+}
+
+static quint64 recordId(const QByteArray &record)
+{
+    int end=record.indexOf(constSeparator);
+    return record.mid(1, (-1==end ? record.length() : end)-1).trimmed().toULongLong();
+}
+
+static bool sync(QFile &f)
+{
+    if (!f.flush()) {
+        return false;
+    }
+    #ifdef Q_OS_WIN
+    return 0==_commit(f.handle());
+    #else
+    return 0==fsync(f.handle());
+    #endif
+}
+
+ScrobbleJournal::ScrobbleJournal(QObject *p)
+    : QObject(p)
+    , loaded(false)
+    , nextId(1)
+    , deadCount(0)
+    , bufferedCount(0)
+{
+    flushTimer=new QTimer(this);
+    flushTimer->setSingleShot(true);
+    flushTimer->setInterval(constFlushInterval);
+    connect(flushTimer, SIGNAL(timeout()), this, SLOT(flush()));
+}
+
+ScrobbleJournal::~ScrobbleJournal()
+{
+    flush();
+}
+
+void ScrobbleJournal::setFileName(const QString &f)
+{
+    if (f!=journalFile) {
+        flush();
+        journalFile=f;
+        loaded=false;
+    }
+}
+
+QQueue<Scrobbler::Track> ScrobbleJournal::load()
+{
+    QQueue<Scrobbler::Track> tracks;
+    live.clear();
+    buffer.clear();
+    bufferedCount=0;
+    deadCount=0;
+    loaded=true;
+
+    QString tempName=journalFile+constTempExt;
+    if (!journalFile.isEmpty() && !QFile::exists(journalFile) && QFile::exists(tempName)) {
+        // Killed whilst compacting...
+        QFile::rename(tempName, journalFile);
+    }
+
+    QFile f(journalFile);
+    if (journalFile.isEmpty() || !f.open(QIODevice::ReadOnly)) {
+        return tracks;
+    }
+
+    qint64 validSize=0;
+    while (!f.atEnd()) {
+        QByteArray record=f.readLine();
+        if (!record.endsWith('\n')) {
+            // Last record is incomplete - we must have been killed whilst writing it.
+            break;
+        }
+        validSize+=record.length();
+        if (record.startsWith(constQueuedRecord)) {
+            quint64 id=recordId(record);
+            if (id) {
+                live.insert(id, record);
+                if (id>=nextId) {
+                    nextId=id+1;
+                }
+            }
+        } else if (record.startsWith(constAcknowledgedRecord)) {
+            if (live.remove(recordId(record))) {
+                deadCount++;
+            }
+        }
+    }
+    bool truncated=validSize<f.size();
+    f.close();
+    if (truncated) {
+        DBUG << "truncate from" << f.size() << "to" << validSize;
+        QFile::resize(journalFile, validSize);
+    }
+
+    QMap<quint64, QByteArray>::ConstIterator it=live.constBegin();
+    QMap<quint64, QByteArray>::ConstIterator end=live.constEnd();
+    for (; it!=end; ++it) {
+        Scrobbler::Track t;
+        if (decode(it.value(), t)) {
+            tracks.append(t);
+        }
+    }
+    DBUG << journalFile << tracks.count() << deadCount;
+    if (deadCount>0 && (deadCount>=constCompactThreshold || live.isEmpty())) {
+        compact();
+    }
+    return tracks;
+}
+
+void ScrobbleJournal::append(Scrobbler::Track &t)
+{
+    t.id=nextId++;
+    QByteArray record=encode(t);
+    live.insert(t.id, record);
+    buffer+=record;
+    scheduleFlush();
+}
+
+void ScrobbleJournal::acknowledge(const Scrobbler::Track &t)
+{
+    if (t.id && live.remove(t.id)) {
+        buffer+=constAcknowledgedRecord+QByteArray::number(t.id)+'\n';
+        deadCount++;
+        scheduleFlush();
+    }
+}
+
+void ScrobbleJournal::acknowledge(const QList<Scrobbler::Track> &tracks)
+{
+    foreach (const Scrobbler::Track &t, tracks) {
+        acknowledge(t);
+    }
+}
+
+void ScrobbleJournal::clear()
+{
+    DBUG << journalFile;
+    flushTimer->stop();
+    buffer.clear();
+    bufferedCount=0;
+    deadCount=0;
+    live.clear();
+    loaded=false;
+    if (!journalFile.isEmpty() && QFile::exists(journalFile)) {
+        QFile::remove(journalFile);
+    }
+}
+
+void ScrobbleJournal::flush()
+{
+    flushTimer->stop();
+    if (buffer.isEmpty() || journalFile.isEmpty()) {
+        return;
+    }
+
+    DBUG << bufferedCount << live.count() << deadCount;
+    // Only compact once there are more acknowledged tracks than pending ones - otherwise we would
+    // be re-writing most of the file, just to remove a few records.
+    if ((live.isEmpty() || (deadCount>=constCompactThreshold && deadCount>live.count())) && compact()) {
+        return;
+    }
+    if (write(buffer)) {
+        buffer.clear();
+        bufferedCount=0;
+    }
+}
+
+bool ScrobbleJournal::write(const QByteArray &data)
+{
+    QFile f(journalFile);
+    if (!f.open(QIODevice::WriteOnly|QIODevice::Append)) {
+        DBUG << "failed to open" << journalFile;
+        return false;
+    }
+    if (0==f.size()) {
+        f.write(constVersionRecord);
+    }
+    return data.length()==f.write(data) && sync(f);
+}
+
+bool ScrobbleJournal::compact()
+{
+    DBUG << live.count() << deadCount;
+    if (!live.isEmpty()) {
+        QString tempName=journalFile+constTempExt;
+        QFile f(tempName);
+        if (!f.open(QIODevice::WriteOnly|QIODevice::Truncate)) {
+            DBUG << "failed to open" << tempName;
+            return false;
+        }
+        f.write(constVersionRecord);
+        QMap<quint64, QByteArray>::ConstIterator it=live.constBegin();
+        QMap<quint64, QByteArray>::ConstIterator end=live.constEnd();
+        for (; it!=end; ++it) {
+            f.write(it.value());
+        }
+        bool ok=sync(f);
+        f.close();
+        if (!ok) {
+            QFile::remove(tempName);
+            return false;
+        }
+        // If we are killed between removing the journal and renaming the new one, load() will use the temp file.
+        QFile::remove(journalFile);
+        if (!QFile::rename(tempName, journalFile)) {
+            return false;
+        }
+    } else if (QFile::exists(journalFile)) {
+        QFile::remove(journalFile);
+    }
+
+    buffer.clear();
+    bufferedCount=0;
+    deadCount=0;
+    return true;
+}
+
+void ScrobbleJournal::scheduleFlush()
+{
+    if (++bufferedCount>=constMaxBufferedRecords) {
+        flush();
+    } else if (!flushTimer->isActive()) {
+        flushTimer->start();
+    }
+}
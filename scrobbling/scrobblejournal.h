@@ -0,0 +1,83 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2014 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef SCROBBLE_JOURNAL_H
+#define SCROBBLE_JOURNAL_H
+
+#include <QObject>
+#include <QMap>
+#include <QByteArray>
+#include <QQueue>
+#include "scrobbler.h"
+
+class QTimer;
+
+// Append-only journal of pending scrobbles. Each queued track is written as one record, and each
+// track that has been accepted by the scrobbler is written as an 'acknowledged' record. Records are
+// buffered, and written (and synced to disk) in batches. Once the number of acknowledged records
+// exceeds the number of pending ones, the journal is compacted - by re-writing just the pending
+// tracks.
+class ScrobbleJournal : public QObject
+{
+    Q_OBJECT
+
+public:
+    static void enableDebug();
+    static const QLatin1String constExtension;
+
+    ScrobbleJournal(QObject *p=0);
+    virtual ~ScrobbleJournal();
+
+    void setFileName(const QString &f);
+    const QString & fileName() const { return journalFile; }
+    bool isLoaded() const { return loaded; }
+    // Replay journal - returns the tracks that have not been acknowledged, in the order they were queued
+    QQueue<Scrobbler::Track> load();
+    // Assigns the track an ID, and queues its record
+    void append(Scrobbler::Track &t);
+    void acknowledge(const Scrobbler::Track &t);
+    void acknowledge(const QList<Scrobbler::Track> &tracks);
+    void clear();
+    int pending() const { return live.count(); }
+
+public Q_SLOTS:
+    void flush();
+
+private:
+    bool write(const QByteArray &data);
+    bool compact();
+    void scheduleFlush();
+
+private:
+    QString journalFile;
+    bool loaded;
+    quint64 nextId;
+    int deadCount;
+    int bufferedCount;
+    QByteArray buffer;
+    QMap<quint64, QByteArray> live; // ID -> record
+    QTimer *flushTimer;
+};
+
+#endif
@@ -27,6 +27,7 @@
 
 #include "scrobbler.h"
 #include "pausabletimer.h"
+#include "scrobblejournal.h"
 #include "config.h"
 #include "gui/covers.h"
 #include "network/networkaccessmanager.h"
@@ -44,6 +45,7 @@
 #include <QDir>
 #include <QXmlStreamReader>
 #include <QSslSocket>
+#include <QDateTime>
 
 #include <QDebug>
 static bool debugIsEnabled=false;
@@ -53,13 +55,23 @@ static bool fakeScrobbling=false;
 void Scrobbler::enableDebug()
 {
     debugIsEnabled=true;
+    ScrobbleJournal::enableDebug();
 }
 
 const QLatin1String Scrobbler::constCacheDir("scrobbling");
 const QLatin1String Scrobbler::constCacheFile("tracks.xml.gz");
+static const QLatin1String constJournalFile("tracks");
 static const QLatin1String constSettingsGroup("Scrobbling");
 static const QString constSecretKey=QLatin1String("0753a75ccded9b17b872744d4bb60b35");
-static const int constMaxBatchSize=50;
+static const int constMaxBatchSize=50; // Max allowed by Last.fm API
+static const int constMinBatchSize=5;
+static const int constBatchSizeStep=10;
+static const int constMaxInFlight=3;
+static const int constTargetLatency=5000; // If a batch takes longer than this, then reduce batch size
+static const int constBatchTimeout=60000;
+static const int constRetryInterval=10000;
+static const int constMaxRetryInterval=30*60*1000;
+static const int constMaxAttempts=5; // For batches that the server says are invalid
 static const int constNowPlayingInterval=5000;
 
 GLOBAL_STATIC(Scrobbler, instance)
@@ -106,6 +118,11 @@ static QString errorString(int code, const QString &msg)
     }
 }
 
+static bool journalOrder(const Scrobbler::Track &a, const Scrobbler::Track &b)
+{
+    return a.id<b.id;
+}
+
 static QString md5(const QString &s)
 {
     return QString::fromLatin1(QCryptographicHash::hash(s.toUtf8(), QCryptographicHash::Md5).toHex());
@@ -139,10 +156,10 @@ static QByteArray format(const QMap<QString, QString> &params)
     return data;
 }
 
-static QString cacheName(bool createDir)
+static QString cacheName(const QString &file, bool createDir)
 {
     QString dir=Utils::cacheDir(Scrobbler::constCacheDir, createDir);
-    return dir.isEmpty() ? QString() : (dir+Scrobbler::constCacheFile);
+    return dir.isEmpty() ? QString() : (dir+file);
 }
 
 Scrobbler::Track::Track(const Song &s)
@@ -154,6 +171,7 @@ Scrobbler::Track::Track(const Song &s)
     track=s.track;
     length=s.time;
     timestamp=0;
+    id=0;
 }
 
 Scrobbler::Scrobbler()
@@ -172,8 +190,8 @@ Scrobbler::Scrobbler()
     , failedCount(0)
     , lastState(MPDState_Inactive)
     , authJob(0)
-    , scrobbleJob(0)
 {
+    batchSize=constMaxBatchSize;
     hardFailTimer = new QTimer(this);
     hardFailTimer->setInterval(60*1000);
     hardFailTimer->setSingleShot(true);
@@ -185,7 +203,8 @@ Scrobbler::Scrobbler()
     nowPlayingTimer->setInterval(constNowPlayingInterval);
     retryTimer = new QTimer(this);
     retryTimer->setSingleShot(true);
-    retryTimer->setInterval(10000);
+    retryTimer->setInterval(constRetryInterval);
+    journal = new ScrobbleJournal(this);
     connect(scrobbleTimer, SIGNAL(timeout()), this, SLOT(scrobbleCurrent()));
     connect(retryTimer, SIGNAL(timeout()), this, SLOT(scrobbleQueued()));
     connect(nowPlayingTimer, SIGNAL(timeout()), this, SLOT(scrobbleNowPlaying()));
@@ -206,7 +225,7 @@ Scrobbler::~Scrobbler()
 void Scrobbler::stop()
 {
     cancelJobs();
-    saveCache();
+    journal->flush();
 }
 
 void Scrobbler::setActive()
@@ -457,7 +476,9 @@ void Scrobbler::scrobbleCurrent()
 {
     if (!scrobbledCurrent) {
         if (songQueue.isEmpty() || songQueue.last()!=currentSong) {
-            songQueue.enqueue(currentSong);
+            Track t=currentSong;
+            journal->append(t);
+            songQueue.enqueue(t);
         }
         scrobbledCurrent=true;
     }
@@ -469,46 +490,89 @@ void Scrobbler::scrobbleQueued()
     if (!scrobblingEnabled || scrobbleViaMpd) {
         return;
     }
-    if (!ensureAuthenticated() || scrobbleJob) {
+    if (!ensureAuthenticated()) {
         if (!retryTimer->isActive()) {
-            retryTimer->start();
+            retryTimer->start(constRetryInterval);
         }
         return;
     }
 
-    if (!songQueue.isEmpty()) {
-        QMap<QString, QString> params;
-        params["method"] = "track.scrobble";
-        int batchSize=qMin(constMaxBatchSize, songQueue.size());
-        DBUG << "queued:" << songQueue.size() << "batchSize:" << batchSize;
-        for (int i=0; i<batchSize; ++i) {
-            Track s=songQueue.takeAt(0);
-            DBUG << s.artist << s.albumartist << s.album << s.title << s.track << s.length << s.timestamp;
-            params[QString("track[%1]").arg(i)] = s.title;
-            if (!s.album.isEmpty()) {
-                params[QString("album[%1]").arg(i)] = s.album;
-            }
-            params[QString("artist[%1]").arg(i)] = s.artist;
-            if (!s.albumartist.isEmpty() && s.albumartist!=s.artist) {
-                params[QString("albumArtist[%1]").arg(i)] = s.albumartist;
+    qint64 now=QDateTime::currentMSecsSinceEpoch();
+    while (inFlight.count()<constMaxInFlight) {
+        Batch batch;
+        int failed=-1;
+        for (int i=0; i<failedBatches.count() && -1==failed; ++i) {
+            if (failedBatches.at(i).retryAt<=now) {
+                failed=i;
             }
-            if (s.track) {
-                params[QString("trackNumber[%1]").arg(i)] = QString::number(s.track);
-            }
-            if (s.length) {
-                params[QString("duration[%1]").arg(i)] = QString::number(s.length);
-            }
-            params[QString("timestamp[%1]").arg(i)] = QString::number(s.timestamp);
-            lastScrobbledSongs.append(s);
         }
-        params["sk"] = sessionKey;
-        sign(params);
-        if (fakeScrobbling) {
-            lastScrobbledSongs.clear();
+        if (-1!=failed) {
+            batch=failedBatches.takeAt(failed);
+        } else if (!songQueue.isEmpty()) {
+            int size=qMin(batchSize, songQueue.size());
+            for (int i=0; i<size; ++i) {
+                batch.tracks.append(songQueue.dequeue());
+            }
         } else {
-            scrobbleJob=NetworkAccessManager::self()->postFormData(scrobblerUrl(), format(params));
-            connect(scrobbleJob, SIGNAL(finished()), this, SLOT(scrobbleFinished()));
+            break;
+        }
+        DBUG << "queued:" << songQueue.size() << "inFlight:" << inFlight.count() << "failed:" << failedBatches.count()
+             << "batchSize:" << batch.tracks.count() << "attempts:" << batch.attempts;
+        submitBatch(batch);
+    }
+    scheduleRetry();
+}
+
+void Scrobbler::submitBatch(Batch &batch)
+{
+    QMap<QString, QString> params;
+    params["method"] = "track.scrobble";
+    for (int i=0; i<batch.tracks.count(); ++i) {
+        const Track &s=batch.tracks.at(i);
+        DBUG << s.artist << s.albumartist << s.album << s.title << s.track << s.length << s.timestamp;
+        params[QString("track[%1]").arg(i)] = s.title;
+        if (!s.album.isEmpty()) {
+            params[QString("album[%1]").arg(i)] = s.album;
         }
+        params[QString("artist[%1]").arg(i)] = s.artist;
+        if (!s.albumartist.isEmpty() && s.albumartist!=s.artist) {
+            params[QString("albumArtist[%1]").arg(i)] = s.albumartist;
+        }
+        if (s.track) {
+            params[QString("trackNumber[%1]").arg(i)] = QString::number(s.track);
+        }
+        if (s.length) {
+            params[QString("duration[%1]").arg(i)] = QString::number(s.length);
+        }
+        params[QString("timestamp[%1]").arg(i)] = QString::number(s.timestamp);
+    }
+    params["sk"] = sessionKey;
+    sign(params);
+    if (fakeScrobbling) {
+        journal->acknowledge(batch.tracks);
+    } else {
+        QNetworkReply *job=NetworkAccessManager::self()->postFormData(scrobblerUrl(), format(params));
+        connect(job, SIGNAL(finished()), this, SLOT(scrobbleFinished()));
+        // Don't let a stalled request block its slot forever - aborting it will cause batch to be retried
+        QTimer::singleShot(constBatchTimeout, job, SLOT(abort()));
+        batch.sent.start();
+        inFlight.insert(job, batch);
+    }
+}
+
+void Scrobbler::scheduleRetry()
+{
+    if (failedBatches.isEmpty()) {
+        return;
+    }
+
+    qint64 next=failedBatches.first().retryAt;
+    foreach (const Batch &b, failedBatches) {
+        next=qMin(next, b.retryAt);
+    }
+    int interval=qMax((qint64)0, next-QDateTime::currentMSecsSinceEpoch());
+    if (!retryTimer->isActive() || retryTimer->interval()>interval) {
+        retryTimer->start(interval);
     }
 }
 
@@ -520,64 +584,104 @@ void Scrobbler::scrobbleFinished()
         return;
     }
     job->deleteLater();
-    if (job==scrobbleJob) {
-        QByteArray data=job->readAll();
-        DBUG << job->errorString() << data << songQueue.size() << lastScrobbledSongs.size();
-        scrobbleJob=0;
-
-        int errorCode=NoError;
-        QXmlStreamReader reader(data);
-        while (!reader.atEnd() && !reader.hasError()) {
-            reader.readNext();
-            if (reader.isStartElement()) {
-                if (QLatin1String("lfm")==reader.name().toString()) {
-                    QString status=reader.attributes().value("status").toString().toLower();
-                    DBUG << status;
-                    if (QLatin1String("failed")==status) {
-                        while (!reader.atEnd() && !reader.hasError()) {
-                            reader.readNext();
-                            if (reader.isStartElement()) {
-                                if (QLatin1String("error")==reader.name().toString()) {
-                                    errorCode=reader.attributes().value(QLatin1String("code")).toString().toInt();
-                                    QString errorStr=errorString(errorCode, reader.readElementText());
-                                    emit error(i18n("%1 error: %2", scrobbler, errorStr));
-                                    DBUG << errorStr;
-                                    break;
-                                }
+    if (!inFlight.contains(job)) {
+        return;
+    }
+
+    Batch batch=inFlight.take(job);
+    qint64 latency=batch.sent.elapsed();
+    QByteArray data=job->readAll();
+    DBUG << job->errorString() << data << latency << songQueue.size() << batch.tracks.size();
+
+    bool ok=false;
+    int errorCode=NoError;
+    QXmlStreamReader reader(data);
+    while (!reader.atEnd() && !reader.hasError()) {
+        reader.readNext();
+        if (reader.isStartElement()) {
+            if (QLatin1String("lfm")==reader.name().toString()) {
+                QString status=reader.attributes().value("status").toString().toLower();
+                DBUG << status;
+                if (QLatin1String("ok")==status) {
+                    ok=true;
+                } else if (QLatin1String("failed")==status) {
+                    while (!reader.atEnd() && !reader.hasError()) {
+                        reader.readNext();
+                        if (reader.isStartElement()) {
+                            if (QLatin1String("error")==reader.name().toString()) {
+                                errorCode=reader.attributes().value(QLatin1String("code")).toString().toInt();
+                                QString errorStr=errorString(errorCode, reader.readElementText());
+                                emit error(i18n("%1 error: %2", scrobbler, errorStr));
+                                DBUG << errorStr;
+                                break;
                             }
                         }
                     }
-                    break;
                 }
+                break;
             }
         }
+    }
+
+    if (ok) {
+        failedCount=0;
+        DBUG << "Scrobble succeeded";
+        journal->acknowledge(batch.tracks);
+        // Grow batch size whilst the server is responding quickly, shrink it if it is slowing down
+        if (latency<constTargetLatency) {
+            batchSize=qMin(constMaxBatchSize, batchSize+constBatchSizeStep);
+        } else {
+            batchSize=qMax(constMinBatchSize, (batchSize*3)/4);
+        }
+        scrobbleQueued();
+        return;
+    }
 
-        switch (errorCode) {
-        case NoError:
-            failedCount=0;
-            DBUG << "Scrobble succeeded";
-            lastScrobbledSongs.clear();
+    switch (errorCode) {
+    case AuthenticationFailed:
+    case InvalidSessionKey:
+    case TokenNotAuthorised:
+        sessionKey.clear();
+        authenticate();
+        failedCount=0;
+        // Not the batch's fault, so retry as soon as we have re-authenticated
+        batch.retryAt=0;
+        failedBatches.prepend(batch);
+        return;
+    case InvalidParameters:
+    case InvalidFormat:
+        // Server does not like something in this batch - if it has been tried too often, and it is just 1 track, then
+        // give up on it. Otherwise it would block the queue forever.
+        if (1==batch.tracks.count() && batch.attempts+1>=constMaxAttempts) {
+            DBUG << "Dropping" << batch.tracks.first().artist << batch.tracks.first().title;
+            journal->acknowledge(batch.tracks);
+            scrobbleQueued();
             return;
-        case AuthenticationFailed:
-        case InvalidSessionKey:
-        case TokenNotAuthorised:
+        }
+        break;
+    default:
+        if (++failedCount > 2 && !hardFailTimer->isActive()) {
             sessionKey.clear();
-            authenticate();
-            failedCount=0;
-            break;
-        default:
-            if (++failedCount > 2 && !hardFailTimer->isActive()) {
-                sessionKey.clear();
-                hardFailTimer->setInterval((failedCount > 120 ? 120 : failedCount)*60*1000);
-                hardFailTimer->start();
-            }
-            break;
+            hardFailTimer->setInterval((failedCount > 120 ? 120 : failedCount)*60*1000);
+            hardFailTimer->start();
         }
+        break;
+    }
 
-        DBUG << "Move last scrobbled into queued";
-        songQueue << lastScrobbledSongs;
-        lastScrobbledSongs.clear();
+    batchSize=qMax(constMinBatchSize, batchSize/2);
+    batch.attempts++;
+    batch.retryAt=QDateTime::currentMSecsSinceEpoch()+qMin((qint64)constMaxRetryInterval, ((qint64)constRetryInterval)<<qMin(batch.attempts-1, 16));
+    DBUG << "Batch failed, attempts:" << batch.attempts << "retry in:" << (batch.retryAt-QDateTime::currentMSecsSinceEpoch());
+    // Split large batches, so that a problem with one track does not hold up the others
+    if (batch.tracks.count()>constMinBatchSize) {
+        Batch other=batch;
+        int half=batch.tracks.count()/2;
+        other.tracks=batch.tracks.mid(half);
+        batch.tracks=batch.tracks.mid(0, half);
+        failedBatches.append(other);
     }
+    failedBatches.append(batch);
+    scheduleRetry();
 }
 
 bool Scrobbler::ensureAuthenticated()
@@ -673,77 +777,54 @@ void Scrobbler::authResp()
         if (lovePending) {
             love();
         }
+        if (!songQueue.isEmpty() || !failedBatches.isEmpty()) {
+            scrobbleQueued();
+        }
     }
 }
 
 void Scrobbler::loadCache()
 {
-    QString fileName=cacheName(false);
-    if (fileName.isEmpty()) {
+    if (journal->isLoaded()) {
         return;
     }
-    QFile file(fileName);
-    QtIOCompressor compressor(&file);
-    compressor.setStreamFormat(QtIOCompressor::GzipFormat);
-    if (compressor.open(QIODevice::ReadOnly)) {
-        QXmlStreamReader reader(&compressor);
-        while (!reader.atEnd()) {
-            reader.readNext();
-            if (reader.isStartElement() && QLatin1String("track")==reader.name()) {
-                Track t;
-                t.artist = reader.attributes().value(QLatin1String("artist")).toString();
-                t.album = reader.attributes().value(QLatin1String("album")).toString();
-                t.albumartist = reader.attributes().value(QLatin1String("albumartist")).toString();
-                t.title = reader.attributes().value(QLatin1String("title")).toString();
-                t.track = reader.attributes().value(QLatin1String("track")).toString().toUInt();
-                t.length = reader.attributes().value(QLatin1String("length")).toString().toUInt();
-                t.timestamp = reader.attributes().value(QLatin1String("timestamp")).toString().toUInt();
-                songQueue.append(t);
-            }
-        }
-    }
-    DBUG << fileName << songQueue.size();
-}
-
-void Scrobbler::saveCache()
-{
-    QString fileName=cacheName(true);
-    DBUG << fileName << lastScrobbledSongs.count() << songQueue.count();
+    QString fileName=cacheName(QString(constJournalFile)+ScrobbleJournal::constExtension, true);
     if (fileName.isEmpty()) {
         return;
     }
-
-    if (lastScrobbledSongs.isEmpty() && songQueue.isEmpty()) {
-        if (QFile::exists(fileName)) {
-            QFile::remove(fileName);
-        }
-        return;
-    }
-
-    QFile file(fileName);
-    QtIOCompressor compressor(&file);
-    compressor.setStreamFormat(QtIOCompressor::GzipFormat);
-    if (compressor.open(QIODevice::WriteOnly)) {
-        QXmlStreamWriter writer(&compressor);
-        writer.setAutoFormatting(false);
-        writer.writeStartDocument();
-        writer.writeStartElement("tracks");
-        writer.writeAttribute("version", "1");
-
-        const QQueue<Track> &queue=lastScrobbledSongs.isEmpty() ? songQueue : lastScrobbledSongs;
-        foreach (const Track &t, queue) {
-            writer.writeEmptyElement("track");
-            writer.writeAttribute(QLatin1String("artist"), t.artist);
-            writer.writeAttribute(QLatin1String("album"), t.album);
-            writer.writeAttribute(QLatin1String("albumartist"), t.albumartist);
-            writer.writeAttribute(QLatin1String("title"), t.title);
-            writer.writeAttribute(QLatin1String("track"), QString::number(t.track));
-            writer.writeAttribute(QLatin1String("length"), QString::number(t.length));
-            writer.writeAttribute(QLatin1String("timestamp"), QString::number(t.timestamp));
+    journal->setFileName(fileName);
+    songQueue=journal->load();
+
+    // Import any tracks from old XML cache...
+    QString legacyFileName=cacheName(constCacheFile, false);
+    if (!legacyFileName.isEmpty() && QFile::exists(legacyFileName)) {
+        QFile file(legacyFileName);
+        QtIOCompressor compressor(&file);
+        compressor.setStreamFormat(QtIOCompressor::GzipFormat);
+        if (compressor.open(QIODevice::ReadOnly)) {
+            QXmlStreamReader reader(&compressor);
+            while (!reader.atEnd()) {
+                reader.readNext();
+                if (reader.isStartElement() && QLatin1String("track")==reader.name()) {
+                    Track t;
+                    t.artist = reader.attributes().value(QLatin1String("artist")).toString();
+                    t.album = reader.attributes().value(QLatin1String("album")).toString();
+                    t.albumartist = reader.attributes().value(QLatin1String("albumartist")).toString();
+                    t.title = reader.attributes().value(QLatin1String("title")).toString();
+                    t.track = reader.attributes().value(QLatin1String("track")).toString().toUInt();
+                    t.length = reader.attributes().value(QLatin1String("length")).toString().toUInt();
+                    t.timestamp = reader.attributes().value(QLatin1String("timestamp")).toString().toUInt();
+                    journal->append(t);
+                    songQueue.append(t);
+                }
+            }
+            compressor.close();
         }
-        writer.writeEndElement();
-        writer.writeEndDocument();
+        journal->flush();
+        QFile::remove(legacyFileName);
+        DBUG << "imported" << legacyFileName;
     }
+    DBUG << fileName << songQueue.size();
 }
 
 void Scrobbler::mpdStateUpdated(bool songChanged)
@@ -828,21 +909,38 @@ void Scrobbler::cancelJobs()
         authJob->deleteLater();
         authJob=0;
     }
-    if (scrobbleJob) {
-        disconnect(scrobbleJob, SIGNAL(finished()), this, SLOT(scrobbleFinished()));
-        authJob->close();
-        authJob->abort();
-        authJob->deleteLater();
-        scrobbleJob=0;
+    // Put the tracks of any in-flight, or failed, batches back at the start of the queue - in the order
+    // they were scrobbled - so that these are re-sent when scrobbling next resumes.
+    QList<Track> unsent;
+    QMap<QNetworkReply *, Batch>::ConstIterator it=inFlight.constBegin();
+    QMap<QNetworkReply *, Batch>::ConstIterator end=inFlight.constEnd();
+    for (; it!=end; ++it) {
+        disconnect(it.key(), SIGNAL(finished()), this, SLOT(scrobbleFinished()));
+        it.key()->close();
+        it.key()->abort();
+        it.key()->deleteLater();
+        unsent+=it.value().tracks;
+    }
+    foreach (const Batch &b, failedBatches) {
+        unsent+=b.tracks;
+    }
+    inFlight.clear();
+    failedBatches.clear();
+    if (!unsent.isEmpty()) {
+        qStableSort(unsent.begin(), unsent.end(), journalOrder);
+        for (int i=unsent.count()-1; i>=0; --i) {
+            songQueue.prepend(unsent.at(i));
+        }
+        DBUG << "requeued:" << unsent.count();
     }
+    retryTimer->stop();
 }
 
 void Scrobbler::reset()
 {
-    songQueue.clear();
-    lastScrobbledSongs.clear();
-    saveCache();
     cancelJobs();
+    songQueue.clear();
+    journal->clear();
 }
 
 void Scrobbler::loadScrobblers()
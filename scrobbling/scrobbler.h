@@ -34,12 +34,14 @@
 #include <QObject>
 #include <QUrl>
 #include <QMap>
+#include <QElapsedTimer>
 #include <time.h>
 #include "mpd-interface/mpdstatus.h"
 
 class QTimer;
 class QNetworkReply;
 class PausableTimer;
+class ScrobbleJournal;
 struct Song;
 struct MPDStatusValues;
 
@@ -48,12 +50,12 @@ class Scrobbler : public QObject
 	Q_OBJECT
 public:
     struct Track {
-        Track() : track(0), length(0), timestamp(0) { }
+        Track() : track(0), length(0), timestamp(0), id(0) { }
         Track(const Song &s);
         bool operator==(const Track &o) const { return track==o.track && title==o.title && artist==o.artist &&
                                                 albumartist==o.albumartist && album==o.album; }
         bool operator!=(const Track &o) const { return !(*this==o); }
-        void clear() { title=artist=albumartist=album=QString(); track=length=0; timestamp=0; }
+        void clear() { title=artist=albumartist=album=QString(); track=length=0; timestamp=0; id=0; }
         bool isEmpty() { return 0==track && 0==length && 0==timestamp && title.isEmpty() && artist.isEmpty() && albumartist.isEmpty() && album.isEmpty(); }
         QString title;
         QString artist;
@@ -62,6 +64,7 @@ public:
         quint32 track;
         quint32 length;
         time_t timestamp;
+        quint64 id; // Journal ID
     };
 
     static Scrobbler * self();
@@ -116,11 +119,20 @@ private Q_SLOTS:
     void clientMessageFailed(const QString &client, const QString &msg);
 
 private:
+    struct Batch {
+        Batch() : attempts(0), retryAt(0) { }
+        QList<Track> tracks;
+        int attempts;
+        qint64 retryAt; // msecs since epoch
+        QElapsedTimer sent;
+    };
+
     void setActive();
     void loadSettings();
     bool ensureAuthenticated();
     void loadCache();
-    void saveCache();
+    void submitBatch(Batch &batch);
+    void scheduleRetry();
     void calcScrobbleIntervals();
     void cancelJobs();
     void reset();
@@ -136,7 +148,10 @@ private:
     QString password;
     QString sessionKey;
     QQueue<Track> songQueue;
-    QQueue<Track> lastScrobbledSongs;
+    QMap<QNetworkReply *, Batch> inFlight;
+    QList<Batch> failedBatches;
+    int batchSize;
+    ScrobbleJournal *journal;
     Track inactiveSong; // Song set whilst inactive
     Track currentSong;
     PausableTimer * scrobbleTimer;
@@ -155,7 +170,6 @@ private:
     MPDState lastState;
 
     QNetworkReply *authJob;
-    QNetworkReply *scrobbleJob;
 };
 
 #endif
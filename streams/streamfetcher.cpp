@@ -43,6 +43,14 @@ static const int constMaxRedirects = 3;
 static const int constMaxData = 1024;
 static const int constTimeout = 3*1000;
 
+// The URL may be that of the stream itself - which must never be written to the HTTP cache!
+static QNetworkRequest uncachedRequest(const QUrl &u)
+{
+    QNetworkRequest req(u);
+    NetworkAccessManager::disableCache(req);
+    return req;
+}
+
 static QString parsePlaylist(const QByteArray &data, const QString &key, const QSet<QString> &handlers)
 {
     QStringList lines=QString(data).split('\n', QString::SkipEmptyParts);
@@ -217,7 +225,7 @@ void StreamFetcher::doNext()
         } else if (u.scheme().startsWith(StreamsModel::constPrefix)) {
             data.clear();
             u.setScheme("http");
-            job=NetworkAccessManager::self()->get(u, constTimeout);
+            job=NetworkAccessManager::self()->get(uncachedRequest(u), constTimeout);
             DBUG << "Check" << u.toString();
             connect(job, SIGNAL(readyRead()), this, SLOT(dataReady()));
             connect(job, SIGNAL(finished()), this, SLOT(jobFinished()));
@@ -289,7 +297,7 @@ void StreamFetcher::jobFinished(NetworkJob *reply)
                 DBUG << "semi-redirect" << current;
                 data.clear();
                 cancelJob();
-                job=NetworkAccessManager::self()->get(u, constTimeout);
+                job=NetworkAccessManager::self()->get(uncachedRequest(u), constTimeout);
                 connect(job, SIGNAL(readyRead()), this, SLOT(dataReady()));
                 connect(job, SIGNAL(finished()), this, SLOT(jobFinished()));
                 redirected=true;
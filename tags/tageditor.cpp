@@ -186,7 +186,7 @@ TagEditor::TagEditor(QWidget *parent, const QList<Song> &songs,
         REMOVE(mopidyNote);
         connect(this, SIGNAL(getRating(QString)), MPDConnection::self(), SLOT(getRating(QString)));
         connect(this, SIGNAL(setRating(QString,quint8)), MPDConnection::self(), SLOT(setRating(QString,quint8)));
-        connect(MPDConnection::self(), SIGNAL(rating(QString,quint8)), this, SLOT(rating(QString,quint8)));
+        connect(MPDConnection::self(), SIGNAL(ratings(QStringList,QList<quint8>)), this, SLOT(ratings(QStringList,QList<quint8>)));
         ratingWidget->setShowZeroForNull(true);
         QColor col=palette().color(QPalette::WindowText);
         ratingVarious->setStyleSheet(QString("QLabel{color:rgba(%1,%2,%3,128);}").arg(col.red()).arg(col.green()).arg(col.blue()));
@@ -1012,6 +1012,13 @@ void TagEditor::showMopidyMessage()
                             QLatin1String("Mopidy"));
 }
 
+void TagEditor::ratings(const QStringList &files, const QList<quint8> &vals)
+{
+    for (int i=0; i<files.count() && i<vals.count(); ++i) {
+        rating(files.at(i), vals.at(i));
+    }
+}
+
 void TagEditor::rating(const QString &f, quint8 r)
 {
     if (!ratingWidget) {
@@ -29,6 +29,7 @@
 #include "ui_tageditor.h"
 #include <QSet>
 #include <QList>
+#include <QStringList>
 
 #ifdef ENABLE_DEVICES_SUPPORT
 class Device;
@@ -81,9 +82,12 @@ private Q_SLOTS:
     void setSong(const Song &s);
     void setIndex(int idx);
     void showMopidyMessage();
-    void rating(const QString &f, quint8 r);
+    void ratings(const QStringList &files, const QList<quint8> &vals);
     void checkRating();
 
+private:
+    void rating(const QString &f, quint8 r);
+
 private:
     QString baseDir;
     #ifdef ENABLE_DEVICES_SUPPORT
@@ -466,7 +466,7 @@ void MPDBackend::updateStats() //Does nothing right now...
         if (!MusicLibraryModel::self()->fromXML()) {
             emit loadLibrary();
         }
-        if (DirViewModel::self()->isEnabled() && !DirViewModel::self()->fromXML()) {
+        if (DirViewModel::self()->isEnabled() && !DirViewModel::self()->load()) {
             emit loadFolders();
         }
 //        albumsPage->goTop();
@@ -151,18 +151,14 @@ enum Type {
     AlbumTrack
 };
 
-static Type getType(const QModelIndex &index)
+static Type getType(const GroupedView *view, const QModelIndex &index)
 {
-    QModelIndex prev=index.row()>0 ? index.sibling(index.row()-1, 0) : QModelIndex();
-    quint16 thisKey=index.data(Cantata::Role_Key).toUInt();
-    quint16 prevKey=prev.isValid() ? prev.data(Cantata::Role_Key).toUInt() : (quint16)Song::Null_Key;
-
-    return thisKey==prevKey ? AlbumTrack : AlbumHeader;
+    return view->startsAlbum(index) ? AlbumHeader : AlbumTrack;
 }
 
-static bool isAlbumHeader(const QModelIndex &index)
+static bool isAlbumHeader(const GroupedView *view, const QModelIndex &index)
 {
-    return !index.data(Cantata::Role_IsCollection).toBool() && AlbumHeader==getType(index);
+    return !index.data(Cantata::Role_IsCollection).toBool() && AlbumHeader==getType(view, index);
 }
 
 static QString streamText(const Song &song, const QString &trackTitle, bool useName=true)
@@ -216,7 +212,7 @@ public:
     QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const
     {
         if (0==index.column()) {
-            return sizeHint(getType(index), index.data(Cantata::Role_IsCollection).toBool());
+            return sizeHint(getType(view, index), index.data(Cantata::Role_IsCollection).toBool());
         }
         return QStyledItemDelegate::sizeHint(option, index);
     }
@@ -227,7 +223,7 @@ public:
             return;
         }
 
-        Type type=getType(index);
+        Type type=getType(view, index);
         bool isCollection=index.data(Cantata::Role_IsCollection).toBool();
         Song song=index.data(Cantata::Role_SongWithRating).value<Song>();
         int state=index.data(Cantata::Role_Status).toInt();
@@ -290,7 +286,7 @@ public:
         } else if (AlbumHeader==type) {
             if (stream) {
                 QModelIndex next=index.sibling(index.row()+1, 0);
-                quint16 nextKey=next.isValid() ? next.data(Cantata::Role_Key).toUInt() : (quint16)Song::Null_Key;
+                quint16 nextKey=next.isValid() ? view->albumKey(next) : (quint16)Song::Null_Key;
                 if (nextKey!=song.key && !song.name().isEmpty()) {
                     title=song.name();
                     track=streamText(song, trackTitle, false);
@@ -492,6 +488,7 @@ GroupedView::GroupedView(QWidget *parent, bool isPlayQueue)
     , filterActive(false)
     , isMultiLevel(false)
     , currentAlbum(Song::Null_Key)
+    , rowsNeedUpdate(true)
 {
     setContextMenuPolicy(Qt::CustomContextMenu);
     setAcceptDrops(true);
@@ -520,8 +517,24 @@ GroupedView::~GroupedView()
 
 void GroupedView::setModel(QAbstractItemModel *model)
 {
+    QAbstractItemModel *old=TreeView::model();
+    if (old) {
+        disconnect(old, SIGNAL(rowsInserted(QModelIndex,int,int)), this, SLOT(rowsAdded(QModelIndex,int,int)));
+        disconnect(old, SIGNAL(rowsRemoved(QModelIndex,int,int)), this, SLOT(rowsRemoved(QModelIndex,int,int)));
+        disconnect(old, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)), this, SLOT(rowsMoved(QModelIndex,int,int,QModelIndex,int)));
+        disconnect(old, SIGNAL(dataChanged(QModelIndex,QModelIndex)), this, SLOT(keysChanged(QModelIndex,QModelIndex)));
+        disconnect(old, SIGNAL(modelReset()), this, SLOT(clearIndex()));
+        disconnect(old, SIGNAL(layoutChanged()), this, SLOT(clearIndex()));
+    }
+    clearIndex();
     TreeView::setModel(model);
     if (model) {
+        connect(model, SIGNAL(rowsInserted(QModelIndex,int,int)), this, SLOT(rowsAdded(QModelIndex,int,int)));
+        connect(model, SIGNAL(rowsRemoved(QModelIndex,int,int)), this, SLOT(rowsRemoved(QModelIndex,int,int)));
+        connect(model, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)), this, SLOT(rowsMoved(QModelIndex,int,int,QModelIndex,int)));
+        connect(model, SIGNAL(dataChanged(QModelIndex,QModelIndex)), this, SLOT(keysChanged(QModelIndex,QModelIndex)));
+        connect(model, SIGNAL(modelReset()), this, SLOT(clearIndex()));
+        connect(model, SIGNAL(layoutChanged()), this, SLOT(clearIndex()));
         if (startClosed) {
             updateCollectionRows();
         }
@@ -538,6 +551,7 @@ void GroupedView::setFilterActive(bool f)
         return;
     }
     filterActive=f;
+    rowsNeedUpdate=true;
     if (filterActive && model()) {
         quint32 count=model()->rowCount();
         for (quint32 i=0; i<count; ++i) {
@@ -562,6 +576,7 @@ void GroupedView::setStartClosed(bool sc)
     }
     controlledAlbums.clear();
     startClosed=sc;
+    rowsNeedUpdate=true;
     if (startClosed) {
         updateCollectionRows();
     }
@@ -569,6 +584,7 @@ void GroupedView::setStartClosed(bool sc)
 
 void GroupedView::updateRows(qint32 row, quint16 curAlbum, bool scroll, const QModelIndex &parent, bool forceScroll)
 {
+    quint16 prevAlbum=currentAlbum;
     currentAlbum=curAlbum;
 
     if (row<0) {
@@ -580,13 +596,21 @@ void GroupedView::updateRows(qint32 row, quint16 curAlbum, bool scroll, const QM
     }
 
     if (filterActive && model() && MPDState_Playing==MPDStatus::self()->state()) {
+        rowsNeedUpdate=true;
         if (scroll) {
             scrollTo(model()->index(row, 0, parent), QAbstractItemView::PositionAtCenter);
         }
         return;
     }
 
-    updateRows(parent);
+    // Rows are kept up to date as they are added, removed, or moved. So, unless something has changed
+    // that affects all rows, only the old and new current albums need to be updated.
+    if (rowsNeedUpdate) {
+        updateRows(parent);
+    } else if (autoExpand && prevAlbum!=currentAlbum) {
+        updateAlbumRows(parent, prevAlbum);
+        updateAlbumRows(parent, currentAlbum);
+    }
     if (scroll && (MPDState_Playing==MPDStatus::self()->state() || forceScroll)) {
         scrollTo(model()->index(row, 0, parent), QAbstractItemView::PositionAtCenter);
     }
@@ -598,24 +622,208 @@ void GroupedView::updateRows(const QModelIndex &parent)
         return;
     }
 
-    qint32 count=model()->rowCount(parent);
+    const QVector<quint16> &rows=keys(parent);
     quint16 lastKey=Song::Null_Key;
     quint32 collection=parent.data(Cantata::Role_CollectionId).toUInt();
-    QSet<quint16> keys;
-
-    for (qint32 i=0; i<count; ++i) {
-        quint16 key=model()->index(i, 0, parent).data(Cantata::Role_Key).toUInt();
-        keys.insert(key);
-        bool hide=key==lastKey &&
-                        !(key==currentAlbum && autoExpand) &&
-                        ( ( startClosed && !controlledAlbums[collection].contains(key)) ||
-                          ( !startClosed && controlledAlbums[collection].contains(key)));
-        setRowHidden(i, parent, hide);
+    QSet<quint16> validKeys;
+
+    for (int i=0; i<rows.count(); ++i) {
+        quint16 key=rows.at(i);
+        validKeys.insert(key);
+        bool hide=hideRow(key, lastKey, collection);
+        if (hide!=isRowHidden(i, parent)) {
+            setRowHidden(i, parent, hide);
+        }
         lastKey=key;
     }
 
     // Check that 'controlledAlbums' only contains valid keys...
-    controlledAlbums[collection].intersect(keys);
+    controlledAlbums[collection].intersect(validKeys);
+    if (!parent.isValid()) {
+        rowsNeedUpdate=false;
+    }
+}
+
+// Update hidden state of rows first to last (inclusive), e.g. after rows have been added or removed.
+void GroupedView::updateRows(const QModelIndex &parent, int first, int last)
+{
+    const QVector<quint16> &rows=keys(parent);
+    quint32 collection=parent.data(Cantata::Role_CollectionId).toUInt();
+    last=qMin(last, rows.count()-1);
+    for (int i=qMax(first, 0); i<=last; ++i) {
+        bool hide=hideRow(rows.at(i), i>0 ? rows.at(i-1) : (quint16)Song::Null_Key, collection);
+        if (hide!=isRowHidden(i, parent)) {
+            setRowHidden(i, parent, hide);
+        }
+    }
+}
+
+void GroupedView::updateAlbumRows(const QModelIndex &parent, quint16 key)
+{
+    if (Song::Null_Key==key) {
+        return;
+    }
+    const QVector<quint16> &rows=keys(parent);
+    for (int i=0; i<rows.count(); ++i) {
+        if (rows.at(i)==key) {
+            int last=i;
+            while (last+1<rows.count() && rows.at(last+1)==key) {
+                ++last;
+            }
+            updateRows(parent, i, last);
+            i=last;
+        }
+    }
+}
+
+bool GroupedView::hideRow(quint16 key, quint16 prevKey, quint32 collection) const
+{
+    return key==prevKey &&
+           !(key==currentAlbum && autoExpand) &&
+           ( ( startClosed && !controlledAlbums[collection].contains(key)) ||
+             ( !startClosed && controlledAlbums[collection].contains(key)));
+}
+
+const QVector<quint16> & GroupedView::keys(const QModelIndex &parent) const
+{
+    quint32 collection=parent.data(Cantata::Role_CollectionId).toUInt();
+    QMap<quint32, QVector<quint16> >::Iterator it=rowKeys.find(collection);
+    if (rowKeys.end()==it) {
+        QVector<quint16> rows;
+        if (model()) {
+            int count=model()->rowCount(parent);
+            rows.reserve(count);
+            for (int i=0; i<count; ++i) {
+                rows.append(model()->index(i, 0, parent).data(Cantata::Role_Key).toUInt());
+            }
+        }
+        it=rowKeys.insert(collection, rows);
+    }
+    return it.value();
+}
+
+quint16 GroupedView::albumKey(const QModelIndex &idx) const
+{
+    const QVector<quint16> &rows=keys(idx.parent());
+    return idx.row()<rows.count() ? rows.at(idx.row()) : (quint16)idx.data(Cantata::Role_Key).toUInt();
+}
+
+bool GroupedView::startsAlbum(const QModelIndex &idx) const
+{
+    const QVector<quint16> &rows=keys(idx.parent());
+    int row=idx.row();
+    if (row>=rows.count()) {
+        return true;
+    }
+    return rows.at(row)!=(row>0 ? rows.at(row-1) : (quint16)Song::Null_Key);
+}
+
+void GroupedView::rowsAdded(const QModelIndex &parent, int first, int last)
+{
+    quint32 collection=parent.data(Cantata::Role_CollectionId).toUInt();
+    QMap<quint32, QVector<quint16> >::Iterator it=rowKeys.find(collection);
+    if (rowKeys.end()==it) {
+        rowsNeedUpdate=true;
+        return;
+    }
+    if (first>it.value().count()) {
+        rowKeys.erase(it);
+        rowsNeedUpdate=true;
+        return;
+    }
+    QHash<quint16, QString> &names=albumNames[collection];
+    QVector<quint16> &rows=it.value();
+    rows.insert(first, last-first+1, (quint16)Song::Null_Key);
+    for (int i=first; i<=last; ++i) {
+        rows[i]=model()->index(i, 0, parent).data(Cantata::Role_Key).toUInt();
+        names.remove(rows.at(i));
+    }
+    // Row after the new rows may have become, or may no longer be, an album header.
+    updateRows(parent, first, last+1);
+}
+
+void GroupedView::rowsRemoved(const QModelIndex &parent, int first, int last)
+{
+    quint32 collection=parent.data(Cantata::Role_CollectionId).toUInt();
+    if (isMultiLevel && !parent.isValid()) {
+        // Collections have been removed, we cant tell which - so rebuild indexes as required.
+        clearIndex();
+        return;
+    }
+    QMap<quint32, QVector<quint16> >::Iterator it=rowKeys.find(collection);
+    if (rowKeys.end()==it) {
+        rowsNeedUpdate=true;
+        return;
+    }
+    if (last>=it.value().count()) {
+        rowKeys.erase(it);
+        rowsNeedUpdate=true;
+        return;
+    }
+    it.value().remove(first, last-first+1);
+    updateRows(parent, first, first);
+}
+
+void GroupedView::rowsMoved(const QModelIndex &parent, int start, int end, const QModelIndex &dest, int row)
+{
+    quint32 collection=parent.data(Cantata::Role_CollectionId).toUInt();
+    QMap<quint32, QVector<quint16> >::Iterator it=rowKeys.find(collection);
+    if (parent!=dest || (isMultiLevel && !parent.isValid())) {
+        clearIndex();
+        return;
+    }
+    if (rowKeys.end()==it) {
+        rowsNeedUpdate=true;
+        return;
+    }
+    QVector<quint16> &rows=it.value();
+    if (end>=rows.count() || row>rows.count()) {
+        rowKeys.erase(it);
+        rowsNeedUpdate=true;
+        return;
+    }
+    int count=end-start+1;
+    QVector<quint16> moved=rows.mid(start, count);
+    rows.remove(start, count);
+    int to=row>end ? row-count : row;
+    for (int i=0; i<count; ++i) {
+        rows.insert(to+i, moved.at(i));
+    }
+    // Update the moved rows, and those either side of their old and new positions.
+    updateRows(parent, qMin(start, to), qMax(start, to+count));
+}
+
+void GroupedView::keysChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    QModelIndex parent=topLeft.parent();
+    quint32 collection=parent.data(Cantata::Role_CollectionId).toUInt();
+    QMap<quint32, QVector<quint16> >::Iterator it=rowKeys.find(collection);
+    if (rowKeys.end()==it || !model()) {
+        return;
+    }
+    QVector<quint16> &rows=it.value();
+    QHash<quint16, QString> &names=albumNames[collection];
+    int last=qMin(bottomRight.row(), rows.count()-1);
+    bool changed=false;
+    for (int i=topLeft.row(); i<=last; ++i) {
+        quint16 key=model()->index(i, 0, parent).data(Cantata::Role_Key).toUInt();
+        names.remove(rows.at(i));
+        if (key!=rows.at(i)) {
+            names.remove(key);
+            rows[i]=key;
+            changed=true;
+        }
+    }
+    if (changed) {
+        updateRows(parent, topLeft.row(), last+1);
+    }
+}
+
+void GroupedView::clearIndex()
+{
+    rowKeys.clear();
+    albumNames.clear();
+    rowsNeedUpdate=true;
 }
 
 void GroupedView::updateCollectionRows()
@@ -637,7 +845,7 @@ void GroupedView::toggle(const QModelIndex &idx)
         return;
     }
 
-    quint16 indexKey=idx.data(Cantata::Role_Key).toUInt();
+    quint16 indexKey=albumKey(idx);
 
     if (indexKey==currentAlbum && autoExpand) {
         return;
@@ -655,12 +863,11 @@ void GroupedView::toggle(const QModelIndex &idx)
 
     if (model()) {
         QModelIndex parent=idx.parent();
-        quint32 count=model()->rowCount(idx.parent());
-        for (quint32 i=0; i<count; ++i) {
-            QModelIndex index=model()->index(i, 0, parent);
-            quint16 key=index.data(Cantata::Role_Key).toUInt();
-            if (indexKey==key) {
-                if (isAlbumHeader(index)) {
+        const QVector<quint16> &rows=keys(parent);
+        for (int i=0; i<rows.count(); ++i) {
+            if (indexKey==rows.at(i)) {
+                QModelIndex index=model()->index(i, 0, parent);
+                if (isAlbumHeader(this, index)) {
                     dataChanged(index, index);
                 } else {
                     setRowHidden(i, parent, toBeHidden);
@@ -725,7 +932,7 @@ void GroupedView::dropEvent(QDropEvent *event)
         if (idx.isValid() && selectionModel() && selectionModel()->isSelected(idx)) {
             return;
         }
-        if (idx.isValid() && isAlbumHeader(idx)) {
+        if (idx.isValid() && isAlbumHeader(this, idx)) {
             QRect rect(visualRect(idx));
             if (event->pos().y()>(rect.y()+(rect.height()/2))) {
                 quint16 key=idx.data(Cantata::Role_Key).toUInt();
@@ -761,56 +968,54 @@ void GroupedView::coverLoaded(const Song &song, int size)
     if (filterActive || !isVisible() || size!=constCoverSize || song.isArtistImageRequest() || song.isComposerImageRequest()) {
         return;
     }
-    quint32 count=model()->rowCount();
-    quint16 lastKey=Song::Null_Key;
-    QString albumArtist=song.albumArtist();
-    QString album=song.album;
+    QString album=song.albumArtist()+QLatin1Char('\n')+song.album;
 
-    for (quint32 i=0; i<count; ++i) {
-        QModelIndex index=model()->index(i, 0);
-        if (!index.isValid()) {
-            continue;
-        }
-        if (isMultiLevel && model()->hasChildren(index)) {
-            lastKey=Song::Null_Key;
-            quint32 childCount=model()->rowCount(index);
-            for (quint32 c=0; c<childCount; ++c) {
-                QModelIndex child=model()->index(c, 0, index);
-                if (!child.isValid()) {
-                    continue;
-                }
-                quint16 key=child.data(Cantata::Role_Key).toUInt();
-
-                if (key!=lastKey && !isRowHidden(c, index)) {
-                    Song song=child.data(Cantata::Role_Song).value<Song>();
-                    if (song.albumArtist()==albumArtist && song.album==album) {
-                        dataChanged(child, child);
-                    }
-                }
-                lastKey=key;
+    if (isMultiLevel) {
+        quint32 count=model()->rowCount();
+        for (quint32 i=0; i<count; ++i) {
+            QModelIndex index=model()->index(i, 0);
+            if (index.isValid() && model()->hasChildren(index)) {
+                updateCovers(index, album);
             }
-        } else {
-            quint16 key=index.data(Cantata::Role_Key).toUInt();
+        }
+    } else {
+        updateCovers(QModelIndex(), album);
+    }
+}
 
-            if (key!=lastKey && !isRowHidden(i, QModelIndex())) {
+void GroupedView::updateCovers(const QModelIndex &parent, const QString &album)
+{
+    const QVector<quint16> &rows=keys(parent);
+    QHash<quint16, QString> &names=albumNames[parent.data(Cantata::Role_CollectionId).toUInt()];
+    quint16 lastKey=Song::Null_Key;
+
+    for (int i=0; i<rows.count(); ++i) {
+        quint16 key=rows.at(i);
+        if (key!=lastKey && !isRowHidden(i, parent)) {
+            QModelIndex index=model()->index(i, 0, parent);
+            QHash<quint16, QString>::ConstIterator it=names.find(key);
+            if (names.end()==it) {
                 Song song=index.data(Cantata::Role_Song).value<Song>();
-                if (song.albumArtist()==albumArtist && song.album==album) {
-                    dataChanged(index, index);
-                }
+                it=names.insert(key, song.albumArtist()+QLatin1Char('\n')+song.album);
+            }
+            if (it.value()==album) {
+                dataChanged(index, index);
             }
-            lastKey=key;
         }
+        lastKey=key;
     }
 }
 
 void GroupedView::collectionRemoved(quint32 key)
 {
     controlledAlbums.remove(key);
+    rowKeys.remove(key);
+    albumNames.remove(key);
 }
 
 void GroupedView::itemClicked(const QModelIndex &idx)
 {
-    if (isAlbumHeader(idx)) {
+    if (isAlbumHeader(this, idx)) {
         QRect indexRect(visualRect(idx));
         QRect icon(indexRect.x()+constBorder+4, indexRect.y()+constBorder+((indexRect.height()-constCoverSize)/2),
                    constCoverSize, constCoverSize);
@@ -873,7 +1078,7 @@ void GroupedView::expand(const QModelIndex &idx, bool singleOnly)
                     expand(idx.child(i, 0));
                 }
             }
-        } else if (AlbumHeader==getType(idx)) {
+        } else if (AlbumHeader==getType(this, idx)) {
             quint16 indexKey=idx.data(Cantata::Role_Key).toUInt();
             quint32 collection=idx.data(Cantata::Role_CollectionId).toUInt();
             if (!isExpanded(indexKey, collection)) {
@@ -25,6 +25,9 @@
 #define GROUPEDVIEW_H
 
 #include <QSet>
+#include <QHash>
+#include <QMap>
+#include <QVector>
 #include "treeview.h"
 
 struct Song;
@@ -55,7 +58,7 @@ public:
     void setModel(QAbstractItemModel *model);
     void setFilterActive(bool f);
     bool isFilterActive() const { return filterActive; }
-    void setAutoExpand(bool ae) { autoExpand=ae; }
+    void setAutoExpand(bool ae) { autoExpand=ae; rowsNeedUpdate=true; }
     bool isAutoExpand() const { return autoExpand; }
     void setStartClosed(bool sc);
     bool isStartClosed() const { return startClosed; }
@@ -74,6 +77,8 @@ public:
     void collectionRemoved(quint32 key);
     void expand(const QModelIndex &idx, bool singleOnly=false);
     void collapse(const QModelIndex &idx, bool singleOnly=false);
+    quint16 albumKey(const QModelIndex &idx) const;
+    bool startsAlbum(const QModelIndex &idx) const;
 
 public Q_SLOTS:
     void updateRows(const QModelIndex &parent);
@@ -81,6 +86,18 @@ public Q_SLOTS:
 
 private Q_SLOTS:
     void itemClicked(const QModelIndex &index);
+    void rowsAdded(const QModelIndex &parent, int first, int last);
+    void rowsRemoved(const QModelIndex &parent, int first, int last);
+    void rowsMoved(const QModelIndex &parent, int start, int end, const QModelIndex &dest, int row);
+    void keysChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void clearIndex();
+
+private:
+    const QVector<quint16> & keys(const QModelIndex &parent) const;
+    bool hideRow(quint16 key, quint16 prevKey, quint32 collection) const;
+    void updateRows(const QModelIndex &parent, int first, int last);
+    void updateAlbumRows(const QModelIndex &parent, quint16 key);
+    void updateCovers(const QModelIndex &parent, const QString &album);
 
 private:
     bool allowClose;
@@ -90,6 +107,13 @@ private:
     bool isMultiLevel;
     quint16 currentAlbum;
     QMap<quint32, QSet<quint16> > controlledAlbums;
+    // Album key of each row, per collection. Built on demand, and then kept up to date from the model's
+    // row signals - so that finding album headers, or an album's rows, does not need to query the model.
+    mutable QMap<quint32, QVector<quint16> > rowKeys;
+    // "albumartist\nalbum" of each album key, per collection - used to find the headers of a loaded cover.
+    QMap<quint32, QHash<quint16, QString> > albumNames;
+    // Set when the hidden state of rows can no longer be updated incrementally.
+    bool rowsNeedUpdate;
 };
 
 #endif
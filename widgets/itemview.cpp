@@ -137,12 +137,101 @@ static inline double subTextAlpha(bool selected)
     return selected ? 0.7 : 0.5;
 }
 
+// Delay, in milliseconds, between checking which covers are required when a view is scrolled
+static const int constCoverRequestDelay=50;
+
+static inline int coverSize(const ListView *view, const QModelIndex &idx)
+{
+    return QListView::IconMode==view->viewMode()
+            ? gridCoverSize
+            : idx.data(Cantata::Role_ListImage).toBool() ? listCoverSize : 0;
+}
+
+CoverRequestScheduler::CoverRequestScheduler(ListView *v)
+    : QObject(v)
+    , view(v)
+{
+    timer=new QTimer(this);
+    timer->setSingleShot(true);
+    connect(timer, SIGNAL(timeout()), SLOT(update()));
+}
+
+void CoverRequestScheduler::painted(const QModelIndex &idx, const Song &song, int size)
+{
+    requested.insert(idx.row(), Request(song, size));
+    // Dont restart the timer if it is already running, otherwise requests would never be cancelled
+    // whilst the view is being continually scrolled.
+    if (!timer->isActive()) {
+        timer->start(constCoverRequestDelay);
+    }
+}
+
+void CoverRequestScheduler::update()
+{
+    QAbstractItemModel *model=view->model();
+    QModelIndex parent=view->rootIndex();
+    int count=model ? model->rowCount(parent) : 0;
+    if (0==count) {
+        requested.clear();
+        return;
+    }
+
+    // Window is the visible area, plus one page above and below it.
+    int height=view->viewport()->height();
+    int first=firstRowBelow(parent, count, -height, false);
+    int last=firstRowBelow(parent, count, 2*height, true)-1;
+
+    QHash<int, Request>::Iterator it=requested.begin();
+    while (it!=requested.end()) {
+        if (it.key()<first || it.key()>last) {
+            Covers::self()->cancel(it.value().song, it.value().size);
+            it=requested.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (int row=first; row<=last; ++row) {
+        if (!requested.contains(row)) {
+            QModelIndex idx=model->index(row, 0, parent);
+            int size=coverSize(view, idx);
+            if (size>0) {
+                Song cSong=idx.data(Cantata::Role_CoverSong).value<Song>();
+                if (!cSong.isEmpty()) {
+                    Covers::self()->get(cSong, size);
+                    requested.insert(row, Request(cSong, size));
+                }
+            }
+        }
+    }
+}
+
+// Items are laid out in row order (left-to-right, top-to-bottom), so we can use a binary search
+// to find the first row whose bottom (or top, if useTop is set) is below y.
+int CoverRequestScheduler::firstRowBelow(const QModelIndex &parent, int count, int y, bool useTop) const
+{
+    QAbstractItemModel *model=view->model();
+    int low=0;
+    int high=count;
+    while (low<high) {
+        int mid=(low+high)/2;
+        QRect r=view->visualRect(model->index(mid, 0, parent));
+        if ((useTop ? r.top() : r.bottom())<y) {
+            low=mid+1;
+        } else {
+            high=mid;
+        }
+    }
+    return low;
+}
+
 class ListDelegate : public ActionItemDelegate
 {
 public:
     ListDelegate(ListView *v, QAbstractItemView *p)
         : ActionItemDelegate(p)
         , view(v)
+        , scheduler(v ? new CoverRequestScheduler(v) : 0)
     {
     }
 
@@ -217,10 +306,14 @@ public:
         if (iconMode || index.data(Cantata::Role_ListImage).toBool()) {
             Song cSong=index.data(Cantata::Role_CoverSong).value<Song>();
             if (!cSong.isEmpty()) {
-                QPixmap *cp=Covers::self()->get(cSong, iconMode ? gridCoverSize : listCoverSize, getCoverInUiThread(index));
+                int size=iconMode ? gridCoverSize : listCoverSize;
+                QPixmap *cp=Covers::self()->get(cSong, size, getCoverInUiThread(index));
                 if (cp) {
                     pix=*cp;
                 }
+                if (scheduler) {
+                    scheduler->painted(index, cSong, size);
+                }
             }
         }
         if (!pix) {
@@ -379,6 +472,7 @@ public:
 
 protected:
     ListView *view;
+    CoverRequestScheduler *scheduler;
 };
 
 class TreeDelegate : public ListDelegate
@@ -27,7 +27,9 @@
 #include "config.h"
 #include "ui_itemview.h"
 #include "treeview.h"
+#include "mpd-interface/song.h"
 #include <QMap>
+#include <QHash>
 #include <QList>
 #include <QPair>
 
@@ -39,6 +41,7 @@ class ActionItemDelegate;
 class MessageOverlay;
 class Icon;
 class TableView;
+class ListView;
 
 class KeyEventHandler : public QObject
 {
@@ -66,6 +69,35 @@ private:
     ActionItemDelegate *delegate;
 };
 
+// Keeps cover requests of a ListView in step with what is on screen. Covers for items just outside
+// of the visible area are requested before they are scrolled to, and requests for items that have
+// since scrolled well out of view are cancelled - so that, when scrolling through a large grid, the
+// covers currently shown do not have to wait for those that have already scrolled past.
+class CoverRequestScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    CoverRequestScheduler(ListView *v);
+    void painted(const QModelIndex &idx, const Song &song, int size);
+
+private Q_SLOTS:
+    void update();
+
+private:
+    int firstRowBelow(const QModelIndex &parent, int count, int y, bool useTop) const;
+
+private:
+    struct Request {
+        Request(const Song &s=Song(), int sz=0) : song(s), size(sz) { }
+        Song song;
+        int size;
+    };
+
+    ListView *view;
+    QTimer *timer;
+    QHash<int, Request> requested;
+};
+
 class ItemView : public QWidget, public Ui::ItemView
 {
     Q_OBJECT
@@ -43,6 +43,10 @@
 #include <QToolTip>
 #include <QSpacerItem>
 
+// If interpolated time goes this many seconds past the end of the song, without MPD reporting a
+// change, then assume our clock has drifted and ask MPD for its status.
+static const int constMaxDrift=2;
+
 class PosSliderProxyStyle : public QProxyStyle
 {
 public:
@@ -253,7 +257,7 @@ NowPlayingWidget::NowPlayingWidget(QWidget *p)
     : QWidget(p)
     , shown(false)
     , timer(0)
-    , lastVal(0)
+    , resyncRequested(false)
     , pollCount(0)
     , pollMpd(Settings::self()->mpdPoll())
 {
@@ -295,9 +299,7 @@ NowPlayingWidget::NowPlayingWidget(QWidget *p)
     connect(slider, SIGNAL(sliderReleased()), this, SLOT(released()));
     connect(slider, SIGNAL(positionSet()), this, SIGNAL(sliderReleased()));
     connect(slider, SIGNAL(valueChanged(int)), this, SLOT(updateTimes()));
-    if (pollMpd>0) {
-        connect(this, SIGNAL(mpdPoll()), MPDConnection::self(), SLOT(getStatus()));
-    }
+    connect(this, SIGNAL(mpdPoll()), MPDConnection::self(), SLOT(getStatus()));
     setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
     clearTimes();
     update(Song());
@@ -346,8 +348,6 @@ void NowPlayingWidget::startTimer()
         timer->setInterval(1000);
         connect(timer, SIGNAL(timeout()), this, SLOT(updatePos()));
     }
-    startTime.restart();
-    lastVal=value();
     timer->start();
     pollCount=0;
 }
@@ -362,8 +362,7 @@ void NowPlayingWidget::stopTimer()
 
 void NowPlayingWidget::setValue(int v)
 {
-    startTime.restart();
-    lastVal=v;
+    resyncRequested=false;
     slider->setValue(v);
     updateTimes();
 }
@@ -378,7 +377,7 @@ void NowPlayingWidget::setRange(int min, int max)
 void NowPlayingWidget::clearTimes()
 {
     stopTimer();
-    lastVal=0;
+    resyncRequested=false;
     slider->setRange(0, 0);
     time->setRange(0, 0);
     time->updateTime();
@@ -415,14 +414,16 @@ void NowPlayingWidget::updateTimes()
 
 void NowPlayingWidget::updatePos()
 {
-    int elapsed=(startTime.elapsed()/1000.0)+0.5;
-    slider->setValue(lastVal+elapsed);
-    MPDStatus::self()->setGuessedElapsed(lastVal+elapsed);
+    MPDStatus *status=MPDStatus::self();
+    slider->setValue(status->guessedElapsed());
     if (pollMpd>0) {
         if (++pollCount>=pollMpd) {
             pollCount=0;
             emit mpdPoll();
         }
+    } else if (!resyncRequested && status->timeTotal()>0 && status->interpolatedElapsed()>=status->timeTotal()+constMaxDrift) {
+        resyncRequested=true;
+        emit mpdPoll();
     }
 }
 
@@ -25,7 +25,6 @@
 #define NOWPLAYING_WIDGET_H
 
 #include <QWidget>
-#include <QTime>
 #include <QSlider>
 
 class QTimer;
@@ -96,9 +95,8 @@ private:
     PosSlider *slider;
     RatingWidget *ratingWidget;
     QTimer *timer;
-    QTime startTime;
     QString currentSongFile;
-    int lastVal;
+    bool resyncRequested;
     int pollCount;
     int pollMpd;
 };